@@ -1,8 +1,19 @@
+//for mmap under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
 #include "toy.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
 
 //utilities
 #define APPEND(dest, src) \
@@ -105,6 +116,78 @@ int getFileName(char* dest, const char* src) {
 	return len;
 }
 
+//maps a compiled file read-only, so the VM can run straight from the page cache
+unsigned char* mapFile(char* path, int* size) {
+#if defined(_WIN32) || defined(_WIN64)
+	//no mmap here, but the VM doesn't care where the bytes came from
+	unsigned char* buffer = readFile(path, size);
+	if (buffer != NULL) {
+		(*size)--; //drop the terminator
+	}
+	return buffer;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		*size = -1; //missing file error
+		return NULL;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) == -1) {
+		close(fd);
+		*size = -2; //signal a read error
+		return NULL;
+	}
+
+	*size = info.st_size;
+	if (*size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	void* ptr = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //the mapping keeps its own reference
+
+	if (ptr == MAP_FAILED) {
+		*size = -2;
+		return NULL;
+	}
+
+	return ptr;
+#endif
+}
+
+void unmapFile(unsigned char* ptr, int size) {
+#if defined(_WIN32) || defined(_WIN64)
+	free(ptr);
+#else
+	munmap(ptr, size);
+#endif
+}
+
+int writeFile(char* path, unsigned char* data, int size) {
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return -1;
+	}
+
+	int written = fwrite(data, sizeof(unsigned char), size, file);
+
+	//fclose() flushes, which can fail too
+	if (fclose(file) != 0 || written != size) {
+		return -1;
+	}
+
+	return 0;
+}
+
+bool hasExtension(const char* path, const char* ext) {
+	int pathLength = strlen(path);
+	int extLength = strlen(ext);
+
+	return pathLength >= extLength && strcmp(path + pathLength - extLength, ext) == 0;
+}
+
 //callbacks
 static void printCallback(const char* msg) {
 	fprintf(stdout, "%s\n", msg);
@@ -128,6 +211,29 @@ static void silentExitCallback(const char* msg) {
 	exit(-1);
 }
 
+//the repl is the host for 'yield', printing each value before resuming
+static Toy_VMStatus runVMToCompletion(Toy_VM* vm) {
+	Toy_VMStatus status = Toy_runVM(vm);
+
+	while (status == TOY_VM_STATUS_YIELDED_VALUE) {
+		Toy_stringifyValue(vm->yieldValue, Toy_print);
+		status = Toy_runVM(vm);
+	}
+
+	return status;
+}
+
+static void printCacheStats(Toy_CompileCache* cache) {
+	Toy_CompileCacheStats stats = Toy_getCompileCacheStats(cache);
+	unsigned int lookups = stats.hits + stats.misses;
+
+	fprintf(stderr, TOY_CC_NOTICE "Compile cache: %u hits, %u misses, %.1f%% hit rate, %.3f seconds saved\n" TOY_CC_RESET, stats.hits, stats.misses, lookups > 0 ? stats.hits * 100.0 / lookups : 0.0, stats.savedSeconds);
+
+	if (stats.rejects > 0 || stats.writeFailures > 0) {
+		fprintf(stderr, TOY_CC_WARN "WARNING: Compile cache replaced %u stale entries and failed to store %u\n" TOY_CC_RESET, stats.rejects, stats.writeFailures);
+	}
+}
+
 //handle command line arguments
 typedef struct CmdLine {
 	bool error;
@@ -135,14 +241,22 @@ typedef struct CmdLine {
 	bool version;
 	char* infile;
 	int infileLength;
+	char* outfile; //compile the infile to bytecode, instead of running it
+	char* transpileFile; //write the infile's bytecode out as C, instead of running it
+	char* cacheDir; //reuse compiled bytecode between runs
+	const char* module; //run this module of a bundle, instead of the first
 	bool silentPrint;
 	bool silentAssert;
 	bool removeAssert;
+	bool dense; //the compact instruction encoding
 	bool verboseDebugPrint;
+	int jobs;
+	char** jobFiles; //every '-f' file, when running with '--jobs' or writing a bundle
+	int jobFileCount;
 } CmdLine;
 
 void usageCmdLine(int argc, const char* argv[]) {
-	printf("Usage: %s [ -h | -v | -f source.toy ]\n\n", argv[0]);
+	printf("Usage: %s [ -h | -v | -f source.toy [ -c output.tb ] | -f source.toy ... -c bundle.tb | -f output.tb [ -m module ] | -f input [ -t output.c ] | -j N -f source.toy ... ] [ --cache dir ]\n\n", argv[0]);
 }
 
 void helpCmdLine(int argc, const char* argv[]) {
@@ -152,11 +266,17 @@ void helpCmdLine(int argc, const char* argv[]) {
 
 	printf("  -h, --help\t\t\tShow this help then exit.\n");
 	printf("  -v, --version\t\t\tShow version and copyright information then exit.\n");
-	printf("  -f, --file infile\t\tParse, compile and execute the source file then exit.\n");
+	printf("  -f, --file infile\t\tParse, compile and execute the source file then exit; '.tb' files are run as bytecode.\n");
+	printf("  -c, --compile outfile\t\tWrite the compiled bytecode of the source file to outfile instead of executing it; several source files are written as one bundle.\n");
+	printf("  -m, --module name\t\tRun the named module of a bundle, instead of the first; modules are named after their source files.\n");
+	printf("  -t, --transpile outfile\tWrite the source or bytecode file as C instead of executing it, for a host to build and bind with Toy_bindVMToNative().\n");
 	printf("      --silent-print\t\tSuppress output from the print keyword.\n");
 	printf("      --silent-assert\t\tSuppress output from the assert keyword.\n");
 	printf("      --remove-assert\t\tDo not include the assert statement in the bytecode.\n");
+	printf("      --dense\t\t\tUse the compact instruction encoding, which trades alignment for smaller bytecode.\n");
 	printf("  -d, --verbose\t\tPrint debugging information about Toy's internals.\n");
+	printf("  -j, --jobs N\t\t\tRun every given source file on N worker threads, then report the throughput.\n");
+	printf("      --cache dir\t\tKeep compiled source files in an existing directory, and reuse them when the source is unchanged.\n");
 }
 
 void versionCmdLine(int argc, const char* argv[]) {
@@ -192,12 +312,25 @@ CmdLine parseCmdLine(int argc, const char* argv[]) {
 		.version = false,
 		.infile = NULL,
 		.infileLength = 0,
+		.outfile = NULL,
+		.transpileFile = NULL,
+		.cacheDir = NULL,
+		.module = NULL,
 		.silentPrint = false,
 		.silentAssert = false,
 		.removeAssert = false,
+		.dense = false,
 		.verboseDebugPrint = false,
+		.jobs = 0,
+		.jobFiles = malloc(argc * sizeof(char*)),
+		.jobFileCount = 0,
 	};
 
+	if (cmd.jobFiles == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate space while parsing the command line, exiting\n" TOY_CC_RESET);
+		exit(-1);
+	}
+
 	for (int i = 1; i < argc; i++) {
 		if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
 			cmd.help = true;
@@ -230,7 +363,103 @@ CmdLine parseCmdLine(int argc, const char* argv[]) {
 				getFilePath(cmd.infile, argv[0]);
 				APPEND(cmd.infile, argv[i]);
 				FLIPSLASH(cmd.infile);
+
+				//keep every file, in case '--jobs' is given
+				cmd.jobFiles[cmd.jobFileCount] = malloc(cmd.infileLength + 1);
+
+				if (cmd.jobFiles[cmd.jobFileCount] == NULL) {
+					fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate space while parsing the command line, exiting\n" TOY_CC_RESET);
+					exit(-1);
+				}
+
+				strcpy(cmd.jobFiles[cmd.jobFileCount++], cmd.infile);
+			}
+		}
+
+		else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compile")) {
+			if (argc <= i + 1) {
+				cmd.error = true;
+			}
+			else {
+				free(cmd.outfile); //don't leak
+
+				i++;
+
+				//resolved the same way as the infile
+				cmd.outfile = malloc(strlen(argv[0]) + strlen(argv[i]) + 1);
+
+				if (cmd.outfile == NULL) {
+					fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate space while parsing the command line, exiting\n" TOY_CC_RESET);
+					exit(-1);
+				}
+
+				getFilePath(cmd.outfile, argv[0]);
+				APPEND(cmd.outfile, argv[i]);
+				FLIPSLASH(cmd.outfile);
+			}
+		}
+
+		else if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--transpile")) {
+			if (argc <= i + 1) {
+				cmd.error = true;
+			}
+			else {
+				free(cmd.transpileFile); //don't leak
+
+				i++;
+
+				//resolved the same way as the infile
+				cmd.transpileFile = malloc(strlen(argv[0]) + strlen(argv[i]) + 1);
+
+				if (cmd.transpileFile == NULL) {
+					fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate space while parsing the command line, exiting\n" TOY_CC_RESET);
+					exit(-1);
+				}
+
+				getFilePath(cmd.transpileFile, argv[0]);
+				APPEND(cmd.transpileFile, argv[i]);
+				FLIPSLASH(cmd.transpileFile);
+			}
+		}
+
+		else if (!strcmp(argv[i], "--cache")) {
+			if (argc <= i + 1) {
+				cmd.error = true;
+			}
+			else {
+				free(cmd.cacheDir); //don't leak
+
+				i++;
+
+				//resolved the same way as the infile
+				cmd.cacheDir = malloc(strlen(argv[0]) + strlen(argv[i]) + 1);
+
+				if (cmd.cacheDir == NULL) {
+					fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate space while parsing the command line, exiting\n" TOY_CC_RESET);
+					exit(-1);
+				}
+
+				getFilePath(cmd.cacheDir, argv[0]);
+				APPEND(cmd.cacheDir, argv[i]);
+				FLIPSLASH(cmd.cacheDir);
+			}
+		}
+
+		else if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--module")) {
+			if (argc <= i + 1) {
+				cmd.error = true;
+			}
+			else {
+				cmd.module = argv[++i];
+			}
+		}
+
+		else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) {
+			if (argc <= i + 1 || sscanf(argv[i + 1], "%d", &cmd.jobs) != 1 || cmd.jobs < 1) {
+				cmd.error = true;
 			}
+
+			i++;
 		}
 
 		else if (!strcmp(argv[i], "--silent-print")) {
@@ -245,6 +474,10 @@ CmdLine parseCmdLine(int argc, const char* argv[]) {
 			cmd.removeAssert = true;
 		}
 
+		else if (!strcmp(argv[i], "--dense")) {
+			cmd.dense = true;
+		}
+
 		else if (!strcmp(argv[i], "-d") || !strcmp(argv[i], "--verbose")) {
 			cmd.verboseDebugPrint = true;
 		}
@@ -311,13 +544,14 @@ int repl(const char* filepath) {
 		}
 
 		Toy_Bytecode bc = Toy_compileBytecode(ast);
-		Toy_bindVM(&vm, bc.ptr);
-
-		//run
-		Toy_runVM(&vm);
+		//run, unless it's rejected
+		if (Toy_bindVM(&vm, bc.ptr, bc.count)) {
+			runVMToCompletion(&vm);
+		}
 
 		//free the bytecode, and leave the VM ready for the next loop
 		Toy_resetVM(&vm);
+		Toy_freeBytecode(bc);
 
 		printf("%s> ", prompt); //shows the terminal prompt
 	}
@@ -390,73 +624,255 @@ static void debugStackPrint(Toy_Stack* stack) {
 	}
 }
 
+//DEBUG: print a single name and its value
+static void debugEntryPrint(Toy_TableEntry* entry, void* userData) {
+	if ( (TOY_VALUE_IS_STRING(entry->key) && TOY_VALUE_AS_STRING(entry->key)->type == TOY_STRING_NAME) == false) {
+		return;
+	}
+
+	Toy_Value k = entry->key;
+	Toy_Value v = entry->value;
+
+	printf("%s\t%s\t", Toy_private_getValueTypeAsCString(v.type), TOY_VALUE_AS_STRING(k)->as.name.data);
+
+	switch(v.type) {
+		case TOY_VALUE_NULL:
+			printf("null");
+			break;
+
+		case TOY_VALUE_BOOLEAN:
+			printf("%s", TOY_VALUE_AS_BOOLEAN(v) ? "true" : "false");
+			break;
+
+		case TOY_VALUE_INTEGER:
+			printf("%d", TOY_VALUE_AS_INTEGER(v));
+			break;
+
+		case TOY_VALUE_FLOAT:
+			printf("%f", TOY_VALUE_AS_FLOAT(v));
+			break;
+
+		case TOY_VALUE_STRING: {
+			Toy_String* str = TOY_VALUE_AS_STRING(v);
+
+			//print based on type
+			if (str->type == TOY_STRING_NODE) {
+				char* buffer = Toy_getStringRawBuffer(str);
+				printf("%s", buffer);
+				free(buffer);
+			}
+			else if (str->type == TOY_STRING_LEAF) {
+				printf("%s", str->as.leaf.data);
+			}
+			else if (str->type == TOY_STRING_NAME) {
+				printf("%s\nWarning: The above value is a name string", str->as.name.data);
+			}
+			break;
+		}
+
+		case TOY_VALUE_ARRAY:
+		case TOY_VALUE_TABLE:
+		case TOY_VALUE_FUNCTION:
+		case TOY_VALUE_OPAQUE:
+		case TOY_VALUE_TYPE:
+		case TOY_VALUE_ANY:
+		case TOY_VALUE_UNKNOWN:
+			printf("???");
+			break;
+	}
+
+	printf("\n");
+}
+
 static void debugScopePrint(Toy_Scope* scope, int depth) {
 	//DEBUG: if there's anything in the scope, print it
-	if (scope->table->count > 0) {
+	if (scope->table != NULL && scope->table->count > 0) {
+		printf("Scope %d Dump\n-------------------------\ntype\tname\tvalue\n", depth);
+		unsigned int iterator = 0;
+		for (Toy_TableEntry* entry = Toy_iterateTable(scope->table, &iterator); entry != NULL; entry = Toy_iterateTable(scope->table, &iterator)) {
+			debugEntryPrint(entry, NULL);
+		}
+	}
+	else if (scope->persistent != NULL && scope->persistent->count > 0) {
 		printf("Scope %d Dump\n-------------------------\ntype\tname\tvalue\n", depth);
-		for (int i = 0; i < scope->table->capacity; i++) {
-			if ( (TOY_VALUE_IS_STRING(scope->table->data[i].key) && TOY_VALUE_AS_STRING(scope->table->data[i].key)->type == TOY_STRING_NAME) == false) {
-				continue;
+		Toy_forEachPersistentTable(scope->persistent, debugEntryPrint, NULL);
+	}
+
+	if (scope->next != NULL) {
+		debugScopePrint(scope->next, depth + 1);
+	}
+}
+
+//run every given file on a pool of worker threads, printing each script's output in order
+static int runJobs(CmdLine* cmd) {
+	if (cmd->jobFileCount == 0) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: No source files given for '--jobs', exiting\n" TOY_CC_RESET);
+		return -1;
+	}
+
+	unsigned char* sources[cmd->jobFileCount];
+
+	for (int i = 0; i < cmd->jobFileCount; i++) {
+		int size;
+		sources[i] = readFile(cmd->jobFiles[i], &size);
+
+		if (sources[i] == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Could not read the file '%s', exiting\n" TOY_CC_RESET, cmd->jobFiles[i]);
+
+			for (int j = 0; j < i; j++) {
+				free(sources[j]);
 			}
+			return -1;
+		}
+	}
 
-			Toy_Value k = scope->table->data[i].key;
-			Toy_Value v = scope->table->data[i].value;
+	struct timespec start, end;
+	timespec_get(&start, TIME_UTC);
 
-			printf("%s\t%s\t", Toy_private_getValueTypeAsCString(v.type), TOY_VALUE_AS_STRING(k)->as.name.data);
+	Toy_Pool* pool = Toy_allocatePool(cmd->jobs);
+	Toy_CompileCache* cache = NULL;
 
-			switch(v.type) {
-				case TOY_VALUE_NULL:
-					printf("null");
-					break;
+	if (cmd->cacheDir != NULL) {
+		cache = Toy_allocateCompileCache(cmd->cacheDir);
+		Toy_setPoolCompileCache(pool, cache);
+	}
 
-				case TOY_VALUE_BOOLEAN:
-					printf("%s", TOY_VALUE_AS_BOOLEAN(v) ? "true" : "false");
-					break;
+	for (int i = 0; i < cmd->jobFileCount; i++) {
+		Toy_submitPool(pool, (char*)sources[i]);
+	}
 
-				case TOY_VALUE_INTEGER:
-					printf("%d", TOY_VALUE_AS_INTEGER(v));
-					break;
+	Toy_waitPool(pool);
 
-				case TOY_VALUE_FLOAT:
-					printf("%f", TOY_VALUE_AS_FLOAT(v));
-					break;
+	timespec_get(&end, TIME_UTC);
 
-				case TOY_VALUE_STRING: {
-					Toy_String* str = TOY_VALUE_AS_STRING(v);
+	//tickets are handed out in order
+	int failures = 0;
+	for (int i = 0; i < cmd->jobFileCount; i++) {
+		Toy_PoolResult* result = Toy_getPoolResult(pool, i);
 
-					//print based on type
-					if (str->type == TOY_STRING_NODE) {
-						char* buffer = Toy_getStringRawBuffer(str);
-						printf("%s", buffer);
-						free(buffer);
-					}
-					else if (str->type == TOY_STRING_LEAF) {
-						printf("%s", str->as.leaf.data);
-					}
-					else if (str->type == TOY_STRING_NAME) {
-						printf("%s\nWarning: The above value is a name string", str->as.name.data);
-					}
-					break;
-				}
+		if (result->output != NULL && !cmd->silentPrint) {
+			fputs(result->output, stdout);
+		}
 
-				case TOY_VALUE_ARRAY:
-				case TOY_VALUE_TABLE:
-				case TOY_VALUE_FUNCTION:
-				case TOY_VALUE_OPAQUE:
-				case TOY_VALUE_TYPE:
-				case TOY_VALUE_ANY:
-				case TOY_VALUE_UNKNOWN:
-					printf("???");
-					break;
-			}
+		if (result->errors != NULL) {
+			fputs(result->errors, stderr);
+		}
 
-			printf("\n");
+		//a failed assert doesn't stop the script, but it still counts
+		if (result->status != TOY_VM_STATUS_OK || result->errors != NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: '%s' failed\n" TOY_CC_RESET, cmd->jobFiles[i]);
+			failures++;
 		}
 	}
 
-	if (scope->next != NULL) {
-		debugScopePrint(scope->next, depth + 1);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, TOY_CC_NOTICE "%d scripts on %d threads in %.3f seconds, %.2f scripts/sec, %d failed\n" TOY_CC_RESET, cmd->jobFileCount, cmd->jobs, seconds, cmd->jobFileCount / seconds, failures);
+
+	if (cache != NULL) {
+		printCacheStats(cache);
 	}
+
+	//cleanup
+	Toy_freePool(pool);
+	Toy_freeCompileCache(cache);
+
+	for (int i = 0; i < cmd->jobFileCount; i++) {
+		free(sources[i]);
+	}
+
+	return failures > 0 ? -1 : 0;
+}
+
+//compile every given file into one bundle, each module named after its file without the extension
+static int writeBundle(CmdLine* cmd) {
+	int count = cmd->jobFileCount;
+
+	unsigned char* sources[count];
+	Toy_Ast* modules[count];
+	char names[count][256];
+	const char* namePtrs[count];
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+	int loaded = 0;
+	int result = 0;
+
+	for (int i = 0; i < count; i++) {
+		int size;
+		sources[i] = readFile(cmd->jobFiles[i], &size);
+
+		if (sources[i] == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Could not read the file '%s', exiting\n" TOY_CC_RESET, cmd->jobFiles[i]);
+			result = -1;
+			break;
+		}
+
+		loaded++;
+
+		Toy_Lexer lexer;
+		Toy_bindLexer(&lexer, (char*)sources[i]);
+
+		Toy_Parser parser;
+		Toy_bindParser(&parser, &lexer);
+
+		Toy_configureParser(&parser, cmd->removeAssert);
+
+		modules[i] = Toy_scanParser(&bucket, &parser);
+
+		//the parser has already reported the problem
+		if (parser.error) {
+			result = -1;
+			break;
+		}
+
+		getFileName(names[i], cmd->jobFiles[i]);
+
+		char* dot = strrchr(names[i], '.');
+		if (dot != NULL) {
+			*dot = '\0';
+		}
+
+		namePtrs[i] = names[i];
+	}
+
+	if (result == 0) {
+		Toy_Bytecode bc = Toy_compileBundle(modules, namePtrs, count, cmd->dense);
+		result = writeFile(cmd->outfile, bc.ptr, bc.count);
+
+		if (result != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Could not write the file '%s', exiting\n" TOY_CC_RESET, cmd->outfile);
+		}
+
+		Toy_freeBytecode(bc);
+	}
+
+	//cleanup
+	for (int i = 0; i < loaded; i++) {
+		free(sources[i]);
+	}
+
+	Toy_freeBucket(&bucket);
+
+	return result;
+}
+
+//write the bytecode out as C, with each routine named after the file it came from
+static int writeTranspiled(CmdLine* cmd, const unsigned char* bytecode, unsigned int length, const char* name) {
+	char* source = Toy_transpileBytecode(bytecode, length, name);
+
+	//the transpiler has already reported the problem
+	if (source == NULL) {
+		return -1;
+	}
+
+	int result = writeFile(cmd->transpileFile, (unsigned char*)source, strlen(source));
+
+	if (result != 0) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Could not write the file '%s', exiting\n" TOY_CC_RESET, cmd->transpileFile);
+	}
+
+	free(source);
+
+	return result;
 }
 
 //main file
@@ -487,10 +903,39 @@ int main(int argc, const char* argv[]) {
 	else if (cmd.version) {
 		versionCmdLine(argc, argv);
 	}
+	else if (cmd.jobs > 0) {
+		int result = runJobs(&cmd);
+
+		for (int i = 0; i < cmd.jobFileCount; i++) {
+			free(cmd.jobFiles[i]);
+		}
+		free(cmd.jobFiles);
+		free(cmd.infile);
+		free(cmd.outfile);
+		free(cmd.cacheDir);
+
+		return result;
+	}
+	else if (cmd.outfile != NULL && cmd.jobFileCount > 1) {
+		int result = writeBundle(&cmd);
+
+		for (int i = 0; i < cmd.jobFileCount; i++) {
+			free(cmd.jobFiles[i]);
+		}
+		free(cmd.jobFiles);
+		free(cmd.infile);
+		free(cmd.outfile);
+		free(cmd.cacheDir);
+
+		return result;
+	}
 	else if (cmd.infile != NULL) {
+		//precompiled bytecode skips the lexer, parser and compiler entirely
+		bool precompiled = hasExtension(cmd.infile, ".tb");
+
 		//run the given file
 		int size;
-		unsigned char* source = readFile(cmd.infile, &size);
+		unsigned char* source = precompiled ? mapFile(cmd.infile, &size) : readFile(cmd.infile, &size);
 
 		//check the file
 		if (source == NULL) {
@@ -510,46 +955,166 @@ int main(int argc, const char* argv[]) {
 			}
 		}
 
+		//transpiled routines are named after their file, like the modules of a bundle
+		char routineName[256];
+		getFileName(routineName, cmd.infile);
+
+		char* dot = strrchr(routineName, '.');
+		if (dot != NULL) {
+			*dot = '\0';
+		}
+
 		free(cmd.infile);
 
 		cmd.infile = NULL;
 		cmd.infileLength = 0;
 
-		Toy_Lexer lexer;
-		Toy_bindLexer(&lexer, (char*)source);
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = { .ptr = NULL, .capacity = 0, .count = 0 };
+		unsigned char* bytecode = source;
+		unsigned int bytecodeLength = size; //the whole mapping, until it's replaced by compiled bytecode
+
+		//the cache only helps when the bytecode is run, not written out
+		if (!precompiled && cmd.cacheDir != NULL && cmd.outfile == NULL) {
+			Toy_CompileCache* cache = Toy_allocateCompileCache(cmd.cacheDir);
+			bc = Toy_compileCached(cache, (char*)source, cmd.removeAssert, cmd.dense);
+			bytecode = bc.ptr;
+			bytecodeLength = bc.count;
+
+			if (cmd.verboseDebugPrint) {
+				printCacheStats(cache);
+			}
 
-		Toy_Parser parser;
-		Toy_bindParser(&parser, &lexer);
+			Toy_freeCompileCache(cache);
+			free(cmd.cacheDir);
+			cmd.cacheDir = NULL;
 
-		Toy_configureParser(&parser, cmd.removeAssert);
+			//the parser has already reported the problem
+			if (bc.ptr == NULL) {
+				Toy_freeBucket(&bucket);
+				free(source);
+				return -1;
+			}
+		}
 
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+		else if (!precompiled) {
+			Toy_Lexer lexer;
+			Toy_bindLexer(&lexer, (char*)source);
 
-		Toy_Bytecode bc = Toy_compileBytecode(ast);
+			Toy_Parser parser;
+			Toy_bindParser(&parser, &lexer);
+
+			Toy_configureParser(&parser, cmd.removeAssert);
+
+			Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+
+			//the parser has already reported the problem
+			if (parser.error) {
+				Toy_freeBucket(&bucket);
+				free(source);
+				free(cmd.outfile);
+				return -1;
+			}
+
+			bc = cmd.dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+			bytecode = bc.ptr;
+			bytecodeLength = bc.count;
+
+			//write the bytecode out instead of running it
+			if (cmd.outfile != NULL) {
+				int result = writeFile(cmd.outfile, bc.ptr, bc.count);
+
+				if (result != 0) {
+					fprintf(stderr, TOY_CC_ERROR "ERROR: Could not write the file '%s', exiting\n" TOY_CC_RESET, cmd.outfile);
+				}
+
+				Toy_freeBytecode(bc);
+				Toy_freeBucket(&bucket);
+				free(source);
+				free(cmd.outfile);
+
+				return result;
+			}
+		}
+
+		//write C instead of running it
+		if (cmd.transpileFile != NULL) {
+			int result = writeTranspiled(&cmd, bytecode, bytecodeLength, routineName);
+
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+
+			if (precompiled) {
+				unmapFile(source, size);
+			}
+			else {
+				free(source);
+			}
+
+			free(cmd.transpileFile);
+
+			return result;
+		}
 
 		//run the setup
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+
+		//only the named module is verified and relocated
+		bool bound = cmd.module == NULL ? Toy_bindVM(&vm, bytecode, bytecodeLength) : Toy_bindVMToModule(&vm, bytecode, bytecodeLength, cmd.module);
+
+		if (!bound) {
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+
+			if (precompiled) {
+				unmapFile(source, size);
+			}
+			else {
+				free(source);
+			}
+
+			return -1;
+		}
 
 		//run
-		Toy_runVM(&vm);
+		Toy_VMStatus status = runVMToCompletion(&vm);
 
 		//print the debug info
 		if (cmd.verboseDebugPrint) {
 			debugStackPrint(vm.stack);
 			debugScopePrint(vm.scope, 0);
+
+			Toy_VMStats stats = Toy_getVMStats(&vm);
+			printf("Inline caches: %d hits, %d misses\n", (int)stats.cacheHits, (int)stats.cacheMisses);
 		}
 
 		//cleanup
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 		Toy_freeBucket(&bucket);
-		free(source);
+
+		if (precompiled) {
+			unmapFile(source, size);
+		}
+		else {
+			free(source);
+		}
+
+		if (status != TOY_VM_STATUS_OK) {
+			return -1;
+		}
 	}
 	else {
 		repl(argv[0]);
 	}
 
+	for (int i = 0; i < cmd.jobFileCount; i++) {
+		free(cmd.jobFiles[i]);
+	}
+	free(cmd.jobFiles);
+	free(cmd.cacheDir);
+
 	return 0;
 }
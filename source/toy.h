@@ -12,6 +12,10 @@
 #include "toy_bucket.h"
 #include "toy_string.h"
 #include "toy_table.h"
+#include "toy_ordered_table.h"
+#include "toy_persistent_table.h"
+#include "toy_concurrent_table.h"
+#include "toy_flat_scope.h"
 
 //IR structures and other components
 #include "toy_ast.h"
@@ -21,5 +25,9 @@
 #include "toy_lexer.h"
 #include "toy_parser.h"
 #include "toy_bytecode.h"
+#include "toy_verifier.h"
 #include "toy_vm.h"
+#include "toy_transpiler.h"
+#include "toy_compile_cache.h"
+#include "toy_pool.h"
 
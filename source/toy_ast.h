@@ -19,6 +19,7 @@ typedef enum Toy_AstType {
 
 	TOY_AST_ASSERT,
 	TOY_AST_PRINT,
+	TOY_AST_YIELD,
 
 	TOY_AST_VAR_DECLARE,
 	TOY_AST_VAR_ASSIGN,
@@ -128,6 +129,11 @@ typedef struct Toy_AstPrint {
 	Toy_Ast* child;
 } Toy_AstPrint;
 
+typedef struct Toy_AstYield {
+	Toy_AstType type;
+	Toy_Ast* child;
+} Toy_AstYield;
+
 typedef struct Toy_AstVarDeclare {
 	Toy_AstType type;
 	Toy_String* name;
@@ -169,6 +175,7 @@ union Toy_Ast {                     //32 | 64 BITNESS
 	Toy_AstCompound compound;       //16 | 24
 	Toy_AstAssert assert;           //16 | 24
 	Toy_AstPrint print;             //8  | 16
+	Toy_AstYield yield;             //8  | 16
 	Toy_AstVarDeclare varDeclare;   //16 | 24
 	Toy_AstVarAssign varAssign;     //16 | 24
 	Toy_AstVarAccess varAccess;     //8  | 16
@@ -189,6 +196,7 @@ void Toy_private_emitAstCompound(Toy_Bucket** bucketHandle, Toy_Ast** astHandle,
 
 void Toy_private_emitAstAssert(Toy_Bucket** bucketHandle, Toy_Ast** astHandle, Toy_Ast* child, Toy_Ast* msg);
 void Toy_private_emitAstPrint(Toy_Bucket** bucketHandle, Toy_Ast** astHandle);
+void Toy_private_emitAstYield(Toy_Bucket** bucketHandle, Toy_Ast** astHandle);
 
 void Toy_private_emitAstVariableDeclaration(Toy_Bucket** bucketHandle, Toy_Ast** astHandle, Toy_String* name, Toy_Ast* expr);
 void Toy_private_emitAstVariableAssignment(Toy_Bucket** bucketHandle, Toy_Ast** astHandle, Toy_String* name, Toy_AstFlag flag, Toy_Ast* expr);
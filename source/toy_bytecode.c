@@ -35,37 +35,106 @@ static void writeBytecodeHeader(Toy_Bytecode* bc) {
 	emitByte(bc, TOY_VERSION_MINOR);
 	emitByte(bc, TOY_VERSION_PATCH);
 
-	//check strlen for the build string
+	//the build string, zero-padded so the header ends with 4-byte alignment
 	const char* build = Toy_private_version_build();
-	size_t len = strlen(build) + 1;
-
-	//BUGFIX: ensure the end of the header has 4-byte alignment
-	if (len % 4 != 1) { //1 to fill the 4th byte above
-		len += 4 - (len % 4) +1; //ceil
-	}
+	size_t len = Toy_getBytecodeHeaderSize() - 3;
 
 	expand(bc, len);
-	memcpy(bc->ptr + bc->count, build, len);
+	memset(bc->ptr + bc->count, 0, len);
+	memcpy(bc->ptr + bc->count, build, strlen(build));
 	bc->count += len;
+}
+
+static void emitWord(Toy_Bytecode* bc, unsigned int word) {
+	expand(bc, sizeof(word));
+	memcpy(bc->ptr + bc->count, &word, sizeof(word));
+	bc->count += sizeof(word);
+}
+
+static void patchWord(Toy_Bytecode* bc, unsigned int addr, unsigned int word) {
+	memcpy(bc->ptr + addr, &word, sizeof(word));
+}
+
+static void emitPadding(Toy_Bytecode* bc) {
+	while (bc->count % 4 != 0) {
+		emitByte(bc, 0);
+	}
+}
+
+static unsigned int readWord(const unsigned char* ptr) {
+	unsigned int word;
+	memcpy(&word, ptr, sizeof(word));
+	return word;
+}
 
-	bc->ptr[bc->count] = '\0';
+static const unsigned char* findBytecodeBody(const unsigned char* bytecode) {
+	return bytecode + Toy_getBytecodeHeaderSize();
 }
 
-static void writeBytecodeBody(Toy_Bytecode* bc, Toy_Ast* ast) {
+static void writeBytecodeModule(Toy_Bytecode* bc, Toy_Ast* ast, bool dense) {
 	//a 'module' is a routine that runs at the root-level of a file
 	//since routines can be recursive, this distinction is important
-	//eventually, the bytecode may support multiple modules packed into one file
-	void* module = Toy_compileRoutine(ast);
+	//it's written in place, rather than compiled separately and copied in
+	Toy_private_appendRoutine(ast, dense, &bc->ptr, &bc->capacity, &bc->count);
 
-	size_t len = (size_t)(((int*)module)[0]);
+	//keep the next module aligned
+	emitPadding(bc);
+}
 
-	expand(bc, len);
-	memcpy(bc->ptr + bc->count, module, len);
-	bc->count += len;
+static void writeBytecodeBundle(Toy_Bytecode* bc, Toy_Ast** modules, const char** names, unsigned int count, bool dense) {
+	emitWord(bc, TOY_BUNDLE_MARKER);
+	emitWord(bc, count);
+
+	//the index is filled in as the names and modules are written
+	unsigned int indexAddr = bc->count;
+	for (unsigned int i = 0; i < count; i++) {
+		emitWord(bc, 0);
+		emitWord(bc, 0);
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		patchWord(bc, indexAddr + i * 8, bc->count);
+
+		size_t len = strlen(names[i]) + 1;
+		expand(bc, len);
+		memcpy(bc->ptr + bc->count, names[i], len);
+		bc->count += len;
+	}
+
+	emitPadding(bc);
+
+	//each module is compiled on its own, so none of them depend on the others
+	for (unsigned int i = 0; i < count; i++) {
+		patchWord(bc, indexAddr + i * 8 + 4, bc->count);
+		writeBytecodeModule(bc, modules[i], dense);
+	}
+}
+
+static Toy_Bytecode compileBytecode(Toy_Ast* ast, bool dense) {
+	//setup
+	Toy_Bytecode bc;
+
+	bc.ptr = NULL;
+	bc.capacity = 0;
+	bc.count = 0;
+
+	//build
+	writeBytecodeHeader(&bc);
+	writeBytecodeModule(&bc, ast, dense);
+
+	return bc;
 }
 
 //exposed functions
 Toy_Bytecode Toy_compileBytecode(Toy_Ast* ast) {
+	return compileBytecode(ast, false);
+}
+
+Toy_Bytecode Toy_compileDenseBytecode(Toy_Ast* ast) {
+	return compileBytecode(ast, true);
+}
+
+Toy_Bytecode Toy_compileBundle(Toy_Ast** modules, const char** names, unsigned int count, bool dense) {
 	//setup
 	Toy_Bytecode bc;
 
@@ -75,7 +144,7 @@ Toy_Bytecode Toy_compileBytecode(Toy_Ast* ast) {
 
 	//build
 	writeBytecodeHeader(&bc);
-	writeBytecodeBody(&bc, ast);
+	writeBytecodeBundle(&bc, modules, names, count, dense);
 
 	return bc;
 }
@@ -83,3 +152,77 @@ Toy_Bytecode Toy_compileBytecode(Toy_Ast* ast) {
 void Toy_freeBytecode(Toy_Bytecode bc) {
 	free(bc.ptr);
 }
+
+unsigned int Toy_getBytecodeHeaderSize() {
+	//the version bytes, then the build string and its terminator
+	unsigned int size = 3 + strlen(TOY_VERSION_BUILD) + 1;
+	if (size % 4 != 0) {
+		size += 4 - (size % 4); //ceil
+	}
+
+	return size;
+}
+
+unsigned int Toy_getBundleModuleCount(const unsigned char* bytecode, unsigned int length) {
+	const unsigned char* body = findBytecodeBody(bytecode);
+	unsigned int bodyAddr = body - bytecode;
+
+	if (length < bodyAddr + 8 || readWord(body) != TOY_BUNDLE_MARKER) {
+		return 0;
+	}
+
+	//an index that runs past the image is treated as no index at all
+	unsigned int count = readWord(body + 4);
+	if (count > (length - bodyAddr - 8) / 8) {
+		return 0;
+	}
+
+	return count;
+}
+
+const char* Toy_getBundleModuleName(const unsigned char* bytecode, unsigned int length, unsigned int index) {
+	if (index >= Toy_getBundleModuleCount(bytecode, length)) {
+		return NULL;
+	}
+
+	const unsigned char* entries = findBytecodeBody(bytecode) + 8;
+	unsigned int nameAddr = readWord(entries + index * 8);
+
+	//the name must end within the image
+	if (nameAddr >= length || memchr(bytecode + nameAddr, '\0', length - nameAddr) == NULL) {
+		return NULL;
+	}
+
+	return (const char*)(bytecode + nameAddr);
+}
+
+const unsigned char* Toy_getBundleModule(const unsigned char* bytecode, unsigned int length, unsigned int index) {
+	if (index >= Toy_getBundleModuleCount(bytecode, length)) {
+		return NULL;
+	}
+
+	const unsigned char* entries = findBytecodeBody(bytecode) + 8;
+	unsigned int routineAddr = readWord(entries + index * 8 + 4);
+
+	//the routine itself is checked by the verifier, against what's left of the image
+	if (routineAddr >= length) {
+		return NULL;
+	}
+
+	return bytecode + routineAddr;
+}
+
+const unsigned char* Toy_findBundleModule(const unsigned char* bytecode, unsigned int length, const char* name) {
+	unsigned int count = Toy_getBundleModuleCount(bytecode, length);
+
+	//bundles are small, and only the index and the names are read
+	for (unsigned int i = 0; i < count; i++) {
+		const char* moduleName = Toy_getBundleModuleName(bytecode, length, i);
+
+		if (moduleName != NULL && strcmp(moduleName, name) == 0) {
+			return Toy_getBundleModule(bytecode, length, i);
+		}
+	}
+
+	return NULL;
+}
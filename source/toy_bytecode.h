@@ -10,4 +10,26 @@ typedef struct Toy_Bytecode {
 } Toy_Bytecode;
 
 TOY_API Toy_Bytecode Toy_compileBytecode(Toy_Ast* ast);
+TOY_API Toy_Bytecode Toy_compileDenseBytecode(Toy_Ast* ast); //smaller code sections, see toy_routine.h
+TOY_API Toy_Bytecode Toy_compileBundle(Toy_Ast** modules, const char** names, unsigned int count, bool dense); //several modules in one file, see below
 TOY_API void Toy_freeBytecode(Toy_Bytecode bc);
+
+//the size of the version header at the start of every image, which keeps the routine after it 4-byte aligned
+TOY_API unsigned int Toy_getBytecodeHeaderSize();
+
+//bundles are read in place, so these work on a mapped file; nothing is read past 'length', and an offset past it gives NULL
+TOY_API unsigned int Toy_getBundleModuleCount(const unsigned char* bytecode, unsigned int length); //0 for a single module, or an index that doesn't fit
+TOY_API const char* Toy_getBundleModuleName(const unsigned char* bytecode, unsigned int length, unsigned int index);
+TOY_API const unsigned char* Toy_getBundleModule(const unsigned char* bytecode, unsigned int length, unsigned int index); //the module's routine, or NULL
+TOY_API const unsigned char* Toy_findBundleModule(const unsigned char* bytecode, unsigned int length, const char* name); //the module's routine, or NULL
+
+//after the version header, a single module is just its routine, whose first word is never 0
+#define TOY_BUNDLE_MARKER 0
+
+//NOTE: a bundle is laid out as:
+//  marker      0, instead of a routine size
+//  count       the number of modules
+//  index       for each module, the offsets of its name and its routine, from the start of the bytecode
+//  names       c-strings in sequence, padded to a multiple of 4
+//  modules     each routine as compiled on its own, in the same order as the index
+//nothing outside the index is read until a module is bound, so only the modules that run are touched
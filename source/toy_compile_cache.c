@@ -0,0 +1,270 @@
+//for pthread_mutex_t and getpid under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_compile_cache.h"
+#include "toy_console_colors.h"
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_routine.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+struct Toy_CompileCache {
+	char* directory;
+
+	//guards the stats and the temp file counter, since pool workers share one cache
+	pthread_mutex_t lock;
+	Toy_CompileCacheStats stats;
+	unsigned int tempCount;
+};
+
+//utils
+static double secondsSince(struct timespec start) {
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+//FNV-1a, 64-bit
+static uint64_t hashBytes(uint64_t hash, const unsigned char* bytes, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+//each entry ends with the source it was compiled from, and this, so a colliding key can't return another script's bytecode
+typedef struct EntryFooter {
+	unsigned int sourceLength;
+	unsigned char removeAssert;
+	unsigned char dense;
+	double compileSeconds;
+} EntryFooter;
+
+//an entry is only trusted if it was written by this exact build from this exact source, and wasn't cut short; returns the bytecode's size, or 0
+static unsigned int validEntry(unsigned char* data, unsigned int size, const char* source, bool removeAssert, bool dense, EntryFooter* footer) {
+	unsigned int header = Toy_getBytecodeHeaderSize();
+
+	if (size < header + sizeof(int) + sizeof(EntryFooter) ||
+		data[0] != TOY_VERSION_MAJOR ||
+		data[1] != TOY_VERSION_MINOR ||
+		data[2] != TOY_VERSION_PATCH ||
+		strcmp((char*)data + 3, Toy_private_version_build()) != 0)
+	{
+		return 0;
+	}
+
+	//the module's first int is its total size, less the encoding flags
+	unsigned int moduleSize;
+	memcpy(&moduleSize, data + header, sizeof(moduleSize));
+	moduleSize &= TOY_ROUTINE_SIZE_MASK;
+
+	//the footer may be unaligned
+	memcpy(footer, data + size - sizeof(EntryFooter), sizeof(EntryFooter));
+
+	size_t sourceLength = strlen(source);
+
+	if ((size_t)header + moduleSize + sourceLength + sizeof(EntryFooter) != size ||
+		footer->sourceLength != sourceLength ||
+		footer->removeAssert != removeAssert ||
+		footer->dense != dense ||
+		memcmp(data + header + moduleSize, source, sourceLength) != 0)
+	{
+		return 0;
+	}
+
+	return header + moduleSize;
+}
+
+static unsigned char* readEntry(const char* path, unsigned int* size) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fseek(file, 0L, SEEK_END);
+	long length = ftell(file);
+	rewind(file);
+
+	unsigned char* buffer = length > 0 ? malloc(length) : NULL;
+	if (buffer == NULL || fread(buffer, sizeof(unsigned char), length, file) < (size_t)length) {
+		free(buffer);
+		fclose(file);
+		return NULL;
+	}
+
+	fclose(file);
+
+	*size = length;
+	return buffer;
+}
+
+//write to a unique temp file first, then rename it into place, so other runners never see half an entry
+static bool writeEntry(Toy_CompileCache* cache, const char* path, Toy_Bytecode bc, const char* source, bool removeAssert, bool dense, double compileSeconds) {
+	pthread_mutex_lock(&cache->lock);
+	unsigned int tempCount = cache->tempCount++;
+	pthread_mutex_unlock(&cache->lock);
+
+	char tempPath[strlen(path) + 32];
+	snprintf(tempPath, sizeof(tempPath), "%s.%ld.%u.tmp", path, (long)getpid(), tempCount);
+
+	FILE* file = fopen(tempPath, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	size_t sourceLength = strlen(source);
+	EntryFooter footer = { .sourceLength = sourceLength, .removeAssert = removeAssert, .dense = dense, .compileSeconds = compileSeconds };
+
+	size_t written = fwrite(bc.ptr, sizeof(unsigned char), bc.count, file);
+	written += fwrite(source, sizeof(unsigned char), sourceLength, file);
+	written += fwrite(&footer, sizeof(unsigned char), sizeof(EntryFooter), file);
+
+	//fclose() flushes, which can fail too
+	if (fclose(file) != 0 || written != bc.count + sourceLength + sizeof(EntryFooter) || rename(tempPath, path) != 0) {
+		remove(tempPath);
+		return false;
+	}
+
+	return true;
+}
+
+static Toy_Bytecode compileSource(const char* source, bool removeAssert, bool dense) {
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_configureParser(&parser, removeAssert);
+	Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+
+	Toy_Bytecode bc = { .ptr = NULL, .capacity = 0, .count = 0 };
+
+	//the parser has already reported the problem
+	if (!parser.error) {
+		bc = dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+	}
+
+	Toy_freeBucket(&bucket);
+
+	return bc;
+}
+
+//exposed functions
+Toy_CompileCache* Toy_allocateCompileCache(const char* directory) {
+	Toy_CompileCache* cache = malloc(sizeof(Toy_CompileCache));
+	char* copy = malloc(strlen(directory) + 1);
+
+	if (cache == NULL || copy == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_CompileCache'\n" TOY_CC_RESET);
+		exit(1);
+	}
+
+	strcpy(copy, directory);
+
+	cache->directory = copy;
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->stats = (Toy_CompileCacheStats){ .hits = 0, .misses = 0, .rejects = 0, .writeFailures = 0, .loadSeconds = 0, .compileSeconds = 0, .savedSeconds = 0 };
+	cache->tempCount = 0;
+
+	return cache;
+}
+
+void Toy_freeCompileCache(Toy_CompileCache* cache) {
+	if (cache == NULL) {
+		return;
+	}
+
+	pthread_mutex_destroy(&cache->lock);
+	free(cache->directory);
+	free(cache);
+}
+
+Toy_Bytecode Toy_compileCached(Toy_CompileCache* cache, const char* source, bool removeAssert, bool dense) {
+	char key[32];
+	Toy_private_getCompileCacheKey(key, source, removeAssert, dense);
+
+	char path[strlen(cache->directory) + 1 + sizeof(key)];
+	snprintf(path, sizeof(path), "%s/%s", cache->directory, key);
+
+	struct timespec start;
+	timespec_get(&start, TIME_UTC);
+
+	//hit
+	unsigned int size = 0;
+	unsigned char* data = readEntry(path, &size);
+	EntryFooter footer;
+	unsigned int count = data != NULL ? validEntry(data, size, source, removeAssert, dense, &footer) : 0;
+	bool rejected = data != NULL && count == 0;
+
+	if (count > 0) {
+		double seconds = secondsSince(start);
+
+		pthread_mutex_lock(&cache->lock);
+		cache->stats.hits++;
+		cache->stats.loadSeconds += seconds;
+		cache->stats.savedSeconds += footer.compileSeconds - seconds;
+		pthread_mutex_unlock(&cache->lock);
+
+		//the source and footer stay in the buffer, but aren't counted
+		return (Toy_Bytecode){ .ptr = data, .capacity = size, .count = count };
+	}
+
+	free(data);
+
+	//miss, so a stale or broken entry gets replaced
+	timespec_get(&start, TIME_UTC);
+	Toy_Bytecode bc = compileSource(source, removeAssert, dense);
+	double seconds = secondsSince(start);
+
+	bool stored = bc.ptr == NULL || writeEntry(cache, path, bc, source, removeAssert, dense, seconds);
+
+	pthread_mutex_lock(&cache->lock);
+	cache->stats.misses++;
+	cache->stats.rejects += rejected;
+	cache->stats.writeFailures += !stored;
+	cache->stats.compileSeconds += seconds;
+	pthread_mutex_unlock(&cache->lock);
+
+	return bc;
+}
+
+Toy_CompileCacheStats Toy_getCompileCacheStats(Toy_CompileCache* cache) {
+	pthread_mutex_lock(&cache->lock);
+	Toy_CompileCacheStats stats = cache->stats;
+	pthread_mutex_unlock(&cache->lock);
+
+	return stats;
+}
+
+void Toy_private_getCompileCacheKey(char* dest, const char* source, bool removeAssert, bool dense) {
+	size_t length = strlen(source);
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hash = hashBytes(hash, (const unsigned char*)source, length);
+
+	//anything that changes the output is part of the key
+	const unsigned char options[] = { TOY_VERSION_MAJOR, TOY_VERSION_MINOR, TOY_VERSION_PATCH, removeAssert, dense };
+	hash = hashBytes(hash, options, sizeof(options));
+
+	const char* build = Toy_private_version_build();
+	hash = hashBytes(hash, (const unsigned char*)build, strlen(build) + 1);
+
+	//the length makes an accidental collision that much less likely, and the entry holds the source to rule it out
+	snprintf(dest, 32, "%016llx-%08x.tb", (unsigned long long)hash, (unsigned int)length);
+}
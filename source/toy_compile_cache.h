@@ -0,0 +1,32 @@
+#pragma once
+
+#include "toy_common.h"
+#include "toy_bytecode.h"
+
+//NOTE: the cache holds a platform-specific lock, so it's only defined in the source file
+typedef struct Toy_CompileCache Toy_CompileCache;
+
+//running totals, so the host can tell if the cache is worth keeping
+typedef struct Toy_CompileCacheStats {
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int rejects;       //entries found, but from another build or source, or truncated
+	unsigned int writeFailures; //entries that couldn't be stored, these are still compiled
+	double loadSeconds;         //time spent reading entries on hits
+	double compileSeconds;      //time spent lexing, parsing and compiling on misses
+	double savedSeconds;        //what the hits originally took to compile, less their load time
+} Toy_CompileCacheStats;
+
+//keeps compiled bytecode in a directory, keyed by a hash of the source, the version and the build string
+//NOTE: each entry is the bytecode followed by its source, which is compared on a hit, and the seconds it took to compile; the VM never reads these
+TOY_API Toy_CompileCache* Toy_allocateCompileCache(const char* directory); //the directory must already exist
+TOY_API void Toy_freeCompileCache(Toy_CompileCache* cache);
+
+//returns cached bytecode if there is any, otherwise compiles and stores it; '.ptr' is NULL if the parser reported an error
+//'dense' picks Toy_compileDenseBytecode(), and is part of the key like 'removeAssert'
+TOY_API Toy_Bytecode Toy_compileCached(Toy_CompileCache* cache, const char* source, bool removeAssert, bool dense);
+
+TOY_API Toy_CompileCacheStats Toy_getCompileCacheStats(Toy_CompileCache* cache);
+
+//the cache file name of the given source, written to 'dest' which needs at least 32 bytes; exposed for testing
+TOY_API void Toy_private_getCompileCacheKey(char* dest, const char* source, bool removeAssert, bool dense);
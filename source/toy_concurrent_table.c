@@ -0,0 +1,273 @@
+//for pthread_rwlock_t under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_concurrent_table.h"
+#include "toy_console_colors.h"
+#include "toy_print.h"
+#include "toy_string.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//each shard is padded to whole cache lines, and the array starts on one, so neighbouring locks don't false-share
+#define CACHE_LINE_SIZE 64
+
+typedef struct Toy_ConcurrentShard {
+	union {
+		struct {
+			pthread_rwlock_t lock;
+			Toy_Table* table;
+		};
+		char _padding[CACHE_LINE_SIZE * ((sizeof(pthread_rwlock_t) + sizeof(Toy_Table*) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE)];
+	};
+} Toy_ConcurrentShard;
+
+//utils
+static inline Toy_ConcurrentShard* selectShard(Toy_ConcurrentTable* table, Toy_Value key) {
+	//the shard's own table probes with the low bits, so pick the shard with the high bits
+	unsigned int hash = Toy_hashValue(key) * 0x9E3779B1u;
+	return &table->shards[(hash >> 16) & (table->shardCount - 1)];
+}
+
+//name strings can't be compared to other strings, and only ever name variables
+static inline bool checkStringIsValid(Toy_Value value) {
+	return TOY_VALUE_IS_STRING(value) && TOY_VALUE_AS_STRING(value)->type != TOY_STRING_NAME;
+}
+
+static inline bool checkKeyIsValid(Toy_Value key) {
+	if (!TOY_VALUE_IS_INTEGER(key) && !TOY_VALUE_IS_FLOAT(key) && !checkStringIsValid(key)) {
+		Toy_error(TOY_CC_ERROR "ERROR: Bad concurrent table key\n" TOY_CC_RESET);
+		return false;
+	}
+
+	return true;
+}
+
+static inline bool checkValueIsValid(Toy_Value value) {
+	if (!TOY_VALUE_IS_NULL(value) && !TOY_VALUE_IS_BOOLEAN(value) && !TOY_VALUE_IS_INTEGER(value) && !TOY_VALUE_IS_FLOAT(value) && !checkStringIsValid(value)) {
+		Toy_error(TOY_CC_ERROR "ERROR: Bad concurrent table value\n" TOY_CC_RESET);
+		return false;
+	}
+
+	return true;
+}
+
+//strings are flattened into the table's own copies, outside of any bucket, so their refcounts are never touched by two threads
+static Toy_Value copyPrivateValue(Toy_Value value) {
+	if (!TOY_VALUE_IS_STRING(value)) {
+		return value;
+	}
+
+	Toy_String* str = TOY_VALUE_AS_STRING(value);
+	Toy_String* copy = malloc(sizeof(Toy_String) + str->length + 1);
+
+	if (copy == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a string of %d length for 'Toy_ConcurrentTable'\n" TOY_CC_RESET, (int)str->length);
+		exit(1);
+	}
+
+	copy->type = TOY_STRING_LEAF;
+	copy->length = str->length;
+	copy->refCount = 1;
+	copy->cachedHash = 0;
+
+	if (str->type == TOY_STRING_LEAF) {
+		memcpy(copy->as.leaf.data, str->as.leaf.data, str->length + 1);
+	}
+	else {
+		char* buffer = Toy_getStringRawBuffer(str);
+		memcpy(copy->as.leaf.data, buffer, str->length + 1);
+		free(buffer);
+	}
+
+	return TOY_VALUE_FROM_STRING(copy);
+}
+
+static void freePrivateValue(Toy_Value value) {
+	if (TOY_VALUE_IS_STRING(value)) {
+		free(TOY_VALUE_AS_STRING(value));
+	}
+}
+
+//must be called while the shard is locked, as a writer could free the private copy right after
+static Toy_Value copyOutValue(Toy_Bucket** bucketHandle, Toy_Value value) {
+	return TOY_VALUE_IS_STRING(value) ? TOY_VALUE_FROM_STRING(Toy_deepCopyString(bucketHandle, TOY_VALUE_AS_STRING(value))) : value;
+}
+
+//copy and modify the code from Toy_lookupTable, so the stored strings can be replaced and freed
+static Toy_TableEntry* findEntry(Toy_Table* table, Toy_Value key) {
+	unsigned int probe = Toy_hashValue(key) % table->capacity;
+
+	while (true) {
+		//found the entry
+		if (Toy_checkValuesAreEqual(table->data[probe].key, key)) {
+			return &(table->data[probe]);
+		}
+
+		//if its an empty slot
+		if (TOY_VALUE_IS_NULL(table->data[probe].key)) {
+			return NULL;
+		}
+
+		//adjust and continue
+		probe = (probe + 1) & (table->capacity - 1);
+	}
+}
+
+//exposed functions
+Toy_ConcurrentTable* Toy_allocateConcurrentTable() {
+	Toy_ConcurrentTable* table = malloc(sizeof(Toy_ConcurrentTable));
+	Toy_ConcurrentShard* shards = aligned_alloc(CACHE_LINE_SIZE, TOY_CONCURRENT_TABLE_SHARDS * sizeof(Toy_ConcurrentShard)); //the size is a multiple of the alignment, as aligned_alloc() requires
+
+	if (table == NULL || shards == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_ConcurrentTable' of %d shards\n" TOY_CC_RESET, (int)TOY_CONCURRENT_TABLE_SHARDS);
+		exit(1);
+	}
+
+	table->shards = shards;
+	table->shardCount = TOY_CONCURRENT_TABLE_SHARDS;
+
+	for (unsigned int i = 0; i < table->shardCount; i++) {
+		if (pthread_rwlock_init(&shards[i].lock, NULL) != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to initialize a lock for 'Toy_ConcurrentTable'\n" TOY_CC_RESET);
+			exit(1);
+		}
+
+		shards[i].table = Toy_allocateTable();
+	}
+
+	return table;
+}
+
+void Toy_freeConcurrentTable(Toy_ConcurrentTable* table) {
+	if (table != NULL) {
+		for (unsigned int i = 0; i < table->shardCount; i++) {
+			//the private strings aren't in a bucket, so they're freed here
+			unsigned int iterator = 0;
+			for (Toy_TableEntry* entry = Toy_iterateTable(table->shards[i].table, &iterator); entry != NULL; entry = Toy_iterateTable(table->shards[i].table, &iterator)) {
+				freePrivateValue(entry->key);
+				freePrivateValue(entry->value);
+				entry->value = TOY_VALUE_FROM_NULL();
+				entry->key = TOY_VALUE_FROM_NULL();
+			}
+
+			Toy_freeTable(table->shards[i].table);
+			pthread_rwlock_destroy(&table->shards[i].lock);
+		}
+
+		free(table->shards);
+		free(table);
+	}
+}
+
+void Toy_insertConcurrentTable(Toy_ConcurrentTable* table, Toy_Value key, Toy_Value value) {
+	if (!checkKeyIsValid(key) || !checkValueIsValid(value)) {
+		return;
+	}
+
+	Toy_ConcurrentShard* shard = selectShard(table, key);
+
+	//copied before locking, to keep the lock short
+	Toy_Value privateValue = copyPrivateValue(value);
+	Toy_Value oldValue = TOY_VALUE_FROM_NULL();
+
+	pthread_rwlock_wrlock(&shard->lock);
+	Toy_TableEntry* entry = findEntry(shard->table, key);
+
+	if (entry != NULL) {
+		oldValue = entry->value;
+		entry->value = privateValue;
+	}
+	else {
+		Toy_insertTable(&shard->table, copyPrivateValue(key), privateValue); //may reallocate, hence the exclusive lock
+	}
+	pthread_rwlock_unlock(&shard->lock);
+
+	freePrivateValue(oldValue);
+}
+
+Toy_Value Toy_lookupConcurrentTable(Toy_ConcurrentTable* table, Toy_Bucket** bucketHandle, Toy_Value key) {
+	if (!checkKeyIsValid(key)) {
+		return TOY_VALUE_FROM_NULL();
+	}
+
+	Toy_ConcurrentShard* shard = selectShard(table, key);
+
+	pthread_rwlock_rdlock(&shard->lock);
+	Toy_Value result = copyOutValue(bucketHandle, Toy_lookupTable(&shard->table, key));
+	pthread_rwlock_unlock(&shard->lock);
+
+	return result;
+}
+
+void Toy_removeConcurrentTable(Toy_ConcurrentTable* table, Toy_Value key) {
+	if (!checkKeyIsValid(key)) {
+		return;
+	}
+
+	Toy_ConcurrentShard* shard = selectShard(table, key);
+	Toy_TableEntry removed = { .key = TOY_VALUE_FROM_NULL(), .value = TOY_VALUE_FROM_NULL(), .psl = 0 };
+
+	pthread_rwlock_wrlock(&shard->lock);
+	Toy_TableEntry* entry = findEntry(shard->table, key);
+
+	if (entry != NULL) {
+		removed = *entry;
+		Toy_removeTable(&shard->table, key);
+	}
+	pthread_rwlock_unlock(&shard->lock);
+
+	freePrivateValue(removed.key);
+	freePrivateValue(removed.value);
+}
+
+Toy_Value Toy_updateConcurrentTable(Toy_ConcurrentTable* table, Toy_Bucket** bucketHandle, Toy_Value key, Toy_ConcurrentUpdateCallback callback, void* userData) {
+	if (!checkKeyIsValid(key)) {
+		return TOY_VALUE_FROM_NULL();
+	}
+
+	Toy_ConcurrentShard* shard = selectShard(table, key);
+	Toy_Value oldValue = TOY_VALUE_FROM_NULL();
+
+	pthread_rwlock_wrlock(&shard->lock);
+	Toy_TableEntry* entry = findEntry(shard->table, key);
+	Toy_Value result = callback(entry != NULL ? entry->value : TOY_VALUE_FROM_NULL(), userData);
+
+	//a rejected result leaves the old value in place
+	if (checkValueIsValid(result)) {
+		result = copyPrivateValue(result);
+
+		if (entry != NULL) {
+			oldValue = entry->value;
+			entry->value = result;
+		}
+		else {
+			Toy_insertTable(&shard->table, copyPrivateValue(key), result);
+		}
+	}
+	else {
+		result = entry != NULL ? entry->value : TOY_VALUE_FROM_NULL();
+	}
+
+	result = copyOutValue(bucketHandle, result);
+	pthread_rwlock_unlock(&shard->lock);
+
+	freePrivateValue(oldValue);
+
+	return result;
+}
+
+unsigned int Toy_getConcurrentTableCount(Toy_ConcurrentTable* table) {
+	unsigned int count = 0;
+
+	//not a consistent snapshot across shards, but each shard's count is
+	for (unsigned int i = 0; i < table->shardCount; i++) {
+		pthread_rwlock_rdlock(&table->shards[i].lock);
+		count += table->shards[i].table->count;
+		pthread_rwlock_unlock(&table->shards[i].lock);
+	}
+
+	return count;
+}
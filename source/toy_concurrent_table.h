@@ -0,0 +1,36 @@
+#pragma once
+
+#include "toy_common.h"
+#include "toy_bucket.h"
+#include "toy_value.h"
+#include "toy_table.h"
+
+//NOTE: the shards hold platform-specific locks, so they're only defined in the source file
+struct Toy_ConcurrentShard;
+
+//lock-striped key-value table, for sharing data between VMs on separate threads
+typedef struct Toy_ConcurrentTable {     //32 | 64 BITNESS
+	struct Toy_ConcurrentShard* shards;  //4  | 8
+	unsigned int shardCount;             //4  | 4
+} Toy_ConcurrentTable;                   //8  | 16
+
+//for read-modify-write operations, such as counters; called while the key's shard is locked, so a string in 'oldValue' is only valid until it returns
+typedef Toy_Value (*Toy_ConcurrentUpdateCallback)(Toy_Value oldValue, void* userData);
+
+TOY_API Toy_ConcurrentTable* Toy_allocateConcurrentTable();
+TOY_API void Toy_freeConcurrentTable(Toy_ConcurrentTable* table);
+
+//keys are integers, floats or strings, and values can also be null or booleans; the other types are shared by reference, so they're rejected
+//strings are stored as the table's own flat copies, outside of any bucket, and copied into the caller's bucket on the way out while the shard is locked
+//'bucketHandle' is only used when the result is a string
+TOY_API void Toy_insertConcurrentTable(Toy_ConcurrentTable* table, Toy_Value key, Toy_Value value);
+TOY_API Toy_Value Toy_lookupConcurrentTable(Toy_ConcurrentTable* table, Toy_Bucket** bucketHandle, Toy_Value key);
+TOY_API void Toy_removeConcurrentTable(Toy_ConcurrentTable* table, Toy_Value key);
+TOY_API Toy_Value Toy_updateConcurrentTable(Toy_ConcurrentTable* table, Toy_Bucket** bucketHandle, Toy_Value key, Toy_ConcurrentUpdateCallback callback, void* userData); //returns the value now stored
+
+TOY_API unsigned int Toy_getConcurrentTableCount(Toy_ConcurrentTable* table);
+
+//must be a power of 2, more shards means less lock contention
+#ifndef TOY_CONCURRENT_TABLE_SHARDS
+#define TOY_CONCURRENT_TABLE_SHARDS 16
+#endif
@@ -0,0 +1,189 @@
+#include "toy_flat_scope.h"
+#include "toy_console_colors.h"
+
+#include "toy_print.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//utils
+static inline void checkKeyIsName(Toy_String* key) {
+	if (key->type != TOY_STRING_NAME) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Toy_FlatScope only allows name strings as keys\n" TOY_CC_RESET);
+		exit(-1);
+	}
+}
+
+//the index maps each name to its innermost binding
+static Toy_FlatBinding* lookupFlatScope(Toy_FlatScope* scope, Toy_String* key) {
+	Toy_Value slot = Toy_lookupTable(&scope->index, TOY_VALUE_FROM_STRING(key));
+
+	if (TOY_VALUE_IS_NULL(slot)) {
+		return NULL;
+	}
+
+	return &(scope->bindings[TOY_VALUE_AS_INTEGER(slot)]);
+}
+
+//exposed functions
+Toy_FlatScope* Toy_allocateFlatScope() {
+	Toy_FlatScope* scope = malloc(sizeof(Toy_FlatScope));
+	Toy_FlatBinding* bindings = malloc(TOY_FLAT_SCOPE_INITIAL_CAPACITY * sizeof(Toy_FlatBinding));
+
+	if (scope == NULL || bindings == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_FlatScope' of %d capacity\n" TOY_CC_RESET, (int)TOY_FLAT_SCOPE_INITIAL_CAPACITY);
+		exit(1);
+	}
+
+	scope->index = Toy_allocateTable();
+	scope->bindings = bindings;
+	scope->capacity = TOY_FLAT_SCOPE_INITIAL_CAPACITY;
+	scope->count = 0;
+	scope->depth = 0;
+
+	return scope;
+}
+
+void Toy_freeFlatScope(Toy_FlatScope* scope) {
+	if (scope != NULL) {
+		//unwind everything, which leaves the index empty
+		while (scope->depth > 0) {
+			Toy_popFlatScope(scope);
+		}
+		Toy_popFlatScope(scope);
+
+		Toy_freeTable(scope->index);
+		free(scope->bindings);
+		free(scope);
+	}
+}
+
+void Toy_pushFlatScope(Toy_FlatScope* scope) {
+	scope->depth++;
+}
+
+void Toy_popFlatScope(Toy_FlatScope* scope) {
+	//the bindings are in declaration order, so the current depth is always on top
+	while (scope->count > 0 && scope->bindings[scope->count - 1].depth == scope->depth) {
+		Toy_FlatBinding* binding = &(scope->bindings[--scope->count]);
+
+		//NOTE: the index borrows the key from whichever binding it points to
+		if (binding->shadowed >= 0) {
+			Toy_insertTable(&scope->index, scope->bindings[binding->shadowed].key, TOY_VALUE_FROM_INTEGER(binding->shadowed));
+		}
+		else {
+			Toy_removeTable(&scope->index, binding->key);
+		}
+
+		Toy_freeValue(binding->key);
+		Toy_freeValue(binding->value);
+	}
+
+	if (scope->depth > 0) {
+		scope->depth--;
+	}
+}
+
+void Toy_declareFlatScope(Toy_FlatScope* scope, Toy_String* key, Toy_Value value) {
+	checkKeyIsName(key);
+
+	Toy_FlatBinding* existing = lookupFlatScope(scope, key);
+
+	if (existing != NULL && existing->depth == scope->depth) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Can't redefine a variable: %s", key->as.name.data);
+		Toy_error(buffer);
+		return;
+	}
+
+	//type check
+	Toy_ValueType kt = Toy_getNameStringType(key);
+	if (kt != TOY_VALUE_ANY && value.type != TOY_VALUE_NULL && kt != value.type) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Incorrect value type assigned to in variable declaration '%s' (expected %d, got %d)", key->as.name.data, (int)kt, (int)value.type);
+		Toy_error(buffer);
+		return;
+	}
+
+	//constness check
+	if (Toy_getNameStringConstant(key) && value.type == TOY_VALUE_NULL) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Can't declare %s as const with value 'null'", key->as.name.data);
+		Toy_error(buffer);
+		return;
+	}
+
+	//before the bindings can move
+	int shadowed = existing != NULL ? (int)(existing - scope->bindings) : -1;
+
+	//expand the bindings if needed
+	if (scope->count >= scope->capacity) {
+		Toy_FlatBinding* bindings = realloc(scope->bindings, scope->capacity * TOY_FLAT_SCOPE_EXPANSION_RATE * sizeof(Toy_FlatBinding));
+
+		if (bindings == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to expand a 'Toy_FlatScope' to %d capacity\n" TOY_CC_RESET, (int)(scope->capacity * TOY_FLAT_SCOPE_EXPANSION_RATE));
+			exit(1);
+		}
+
+		scope->bindings = bindings;
+		scope->capacity *= TOY_FLAT_SCOPE_EXPANSION_RATE;
+	}
+
+	scope->bindings[scope->count] = (Toy_FlatBinding){ .key = TOY_VALUE_FROM_STRING(Toy_copyString(key)), .value = value, .depth = scope->depth, .shadowed = shadowed };
+
+	Toy_insertTable(&scope->index, scope->bindings[scope->count].key, TOY_VALUE_FROM_INTEGER(scope->count));
+	scope->count++;
+}
+
+void Toy_assignFlatScope(Toy_FlatScope* scope, Toy_String* key, Toy_Value value) {
+	checkKeyIsName(key);
+
+	Toy_FlatBinding* binding = lookupFlatScope(scope, key);
+
+	if (binding == NULL) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Undefined variable: %s", key->as.name.data);
+		Toy_error(buffer);
+		return;
+	}
+
+	//type check
+	Toy_ValueType kt = Toy_getNameStringType( TOY_VALUE_AS_STRING(binding->key) );
+	if (kt != TOY_VALUE_ANY && value.type != TOY_VALUE_NULL && kt != value.type) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Incorrect value type assigned to in variable assignment '%s' (expected %d, got %d)", key->as.name.data, (int)kt, (int)value.type);
+		Toy_error(buffer);
+		return;
+	}
+
+	//constness check
+	if (Toy_getNameStringConstant( TOY_VALUE_AS_STRING(binding->key) )) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Can't assign to const %s", key->as.name.data);
+		Toy_error(buffer);
+		return;
+	}
+
+	binding->value = value;
+}
+
+Toy_Value Toy_accessFlatScope(Toy_FlatScope* scope, Toy_String* key) {
+	checkKeyIsName(key);
+
+	Toy_FlatBinding* binding = lookupFlatScope(scope, key);
+
+	if (binding == NULL) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Undefined variable: %s", key->as.name.data);
+		Toy_error(buffer);
+		return TOY_VALUE_FROM_NULL();
+	}
+
+	return binding->value;
+}
+
+bool Toy_isDeclaredFlatScope(Toy_FlatScope* scope, Toy_String* key) {
+	checkKeyIsName(key);
+
+	return lookupFlatScope(scope, key) != NULL;
+}
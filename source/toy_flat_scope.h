@@ -0,0 +1,46 @@
+#pragma once
+
+#include "toy_common.h"
+
+#include "toy_value.h"
+#include "toy_string.h"
+#include "toy_table.h"
+
+//each declaration, stored in order; inner bindings hide the outer bindings with the same name
+typedef struct Toy_FlatBinding { //32 | 64 BITNESS
+	Toy_Value key;               //8  | 16
+	Toy_Value value;             //8  | 16
+	unsigned int depth;          //4  | 4
+	int shadowed;                //4  | 4
+} Toy_FlatBinding;               //24 | 40
+
+//alternative to Toy_Scope for deeply nested code, where lookups take one probe regardless of depth
+typedef struct Toy_FlatScope {    //32 | 64 BITNESS
+	Toy_Table* index;             //4  | 8
+	Toy_FlatBinding* bindings;    //4  | 8
+	unsigned int capacity;        //4  | 4
+	unsigned int count;           //4  | 4
+	unsigned int depth;           //4  | 4
+} Toy_FlatScope;                  //20 | 32
+
+TOY_API Toy_FlatScope* Toy_allocateFlatScope();
+TOY_API void Toy_freeFlatScope(Toy_FlatScope* scope);
+
+//handle deep scopes - popping removes the bindings declared since the matching push
+TOY_API void Toy_pushFlatScope(Toy_FlatScope* scope);
+TOY_API void Toy_popFlatScope(Toy_FlatScope* scope);
+
+//manage the contents, with the same rules as Toy_Scope
+TOY_API void Toy_declareFlatScope(Toy_FlatScope* scope, Toy_String* key, Toy_Value value);
+TOY_API void Toy_assignFlatScope(Toy_FlatScope* scope, Toy_String* key, Toy_Value value);
+TOY_API Toy_Value Toy_accessFlatScope(Toy_FlatScope* scope, Toy_String* key);
+
+TOY_API bool Toy_isDeclaredFlatScope(Toy_FlatScope* scope, Toy_String* key);
+
+#ifndef TOY_FLAT_SCOPE_INITIAL_CAPACITY
+#define TOY_FLAT_SCOPE_INITIAL_CAPACITY 16
+#endif
+
+#ifndef TOY_FLAT_SCOPE_EXPANSION_RATE
+#define TOY_FLAT_SCOPE_EXPANSION_RATE 2
+#endif
@@ -5,7 +5,7 @@ typedef enum Toy_OpcodeType {
 	TOY_OPCODE_READ,
 	TOY_OPCODE_DECLARE,
 	TOY_OPCODE_ASSIGN,
-	TOY_OPCODE_ACCESS,
+	TOY_OPCODE_ACCESS, //reads the name from the data section, or from the stack when squeezed after DUPLICATE
 
 	TOY_OPCODE_DUPLICATE, //duplicate the top of the stack
 
@@ -32,6 +32,7 @@ typedef enum Toy_OpcodeType {
 
 	//control instructions
 	TOY_OPCODE_RETURN,
+	TOY_OPCODE_YIELD, //suspend the routine, handing the top of the stack to the host
 
 	TOY_OPCODE_SCOPE_PUSH,
 	TOY_OPCODE_SCOPE_POP,
@@ -0,0 +1,169 @@
+#include "toy_ordered_table.h"
+#include "toy_console_colors.h"
+#include "toy_print.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//each sparse slot holds (entry index + 1), so zeroed memory reads as empty
+#define EMPTY_SLOT 0
+#define REMOVED_SLOT 0xFFFFFFFF
+
+//utils
+static inline unsigned int* getIndices(Toy_OrderedTable* table) {
+	return (unsigned int*)(table->entries + table->entryCapacity);
+}
+
+static inline unsigned int calcEntryCapacity(unsigned int capacity) {
+	return (unsigned int)(capacity * TOY_ORDERED_TABLE_DENSITY);
+}
+
+//returns the sparse slot for the key, or the first empty slot if it isn't present
+static unsigned int probeSlot(Toy_OrderedTable* table, Toy_Value key, unsigned int hash) {
+	unsigned int* indices = getIndices(table);
+	unsigned int probe = hash & (table->capacity - 1); //DOOM hack
+
+	while (true) {
+		unsigned int slot = indices[probe];
+
+		if (slot == EMPTY_SLOT) {
+			return probe;
+		}
+
+		//skip removed entries, but keep probing past them
+		if (slot != REMOVED_SLOT && table->entries[slot - 1].hash == hash && Toy_checkValuesAreEqual(table->entries[slot - 1].key, key)) {
+			return probe;
+		}
+
+		//adjust and continue
+		probe++;
+		probe &= table->capacity - 1; //DOOM hack
+	}
+}
+
+//assumes there is space for another entry
+static void appendEntry(Toy_OrderedTable* table, Toy_Value key, Toy_Value value, unsigned int hash) {
+	unsigned int probe = probeSlot(table, key, hash);
+	unsigned int* indices = getIndices(table);
+
+	//if we're overriding an existing value, the order is kept
+	if (indices[probe] != EMPTY_SLOT) {
+		table->entries[indices[probe] - 1].value = value;
+		return;
+	}
+
+	table->entries[table->used] = (Toy_OrderedTableEntry){ .key = key, .value = value, .hash = hash };
+	indices[probe] = ++table->used;
+	table->count++;
+}
+
+//exposed functions
+Toy_OrderedTable* Toy_private_adjustOrderedTableCapacity(Toy_OrderedTable* oldTable, unsigned int newCapacity) {
+	unsigned int entryCapacity = calcEntryCapacity(newCapacity);
+
+	//allocate a new table in memory, with the dense entries followed by the sparse index
+	Toy_OrderedTable* newTable = malloc(sizeof(Toy_OrderedTable) + entryCapacity * sizeof(Toy_OrderedTableEntry) + newCapacity * sizeof(unsigned int));
+
+	if (newTable == NULL) {
+		Toy_error(TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_OrderedTable'\n" TOY_CC_RESET);
+		return oldTable;
+	}
+
+	newTable->capacity = newCapacity;
+	newTable->entryCapacity = entryCapacity;
+	newTable->count = 0;
+	newTable->used = 0;
+
+	//only the sparse index needs to be zeroed, the dense entries are written in sequence
+	memset(getIndices(newTable), 0, newCapacity * sizeof(unsigned int));
+
+	if (oldTable == NULL) { //for initial allocations
+		return newTable;
+	}
+
+	//copy the live entries across in order, dropping the removed ones, reusing the cached hashes
+	for (unsigned int i = 0; i < oldTable->used; i++) {
+		if (!TOY_VALUE_IS_NULL(oldTable->entries[i].key)) {
+			appendEntry(newTable, oldTable->entries[i].key, oldTable->entries[i].value, oldTable->entries[i].hash);
+		}
+	}
+
+	//clean up and return
+	free(oldTable);
+	return newTable;
+}
+
+Toy_OrderedTable* Toy_allocateOrderedTable() {
+	return Toy_private_adjustOrderedTableCapacity(NULL, TOY_ORDERED_TABLE_INITIAL_CAPACITY);
+}
+
+void Toy_freeOrderedTable(Toy_OrderedTable* table) {
+	if (table != NULL) {
+		//only the dense entries need to be visited
+		for (unsigned int i = 0; i < table->used; i++) {
+			Toy_freeValue(table->entries[i].key);
+			Toy_freeValue(table->entries[i].value);
+		}
+
+		free(table);
+	}
+}
+
+void Toy_insertOrderedTable(Toy_OrderedTable** tableHandle, Toy_Value key, Toy_Value value) {
+	if (TOY_VALUE_IS_NULL(key) || TOY_VALUE_IS_BOOLEAN(key)) { //TODO: disallow functions and opaques
+		Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+	}
+
+	//out of dense space, so either compact away the removed entries, or expand
+	if ((*tableHandle)->used >= (*tableHandle)->entryCapacity) {
+		unsigned int newCapacity = (*tableHandle)->count * 2 < (*tableHandle)->entryCapacity ? (*tableHandle)->capacity : (*tableHandle)->capacity * TOY_ORDERED_TABLE_EXPANSION_RATE;
+		(*tableHandle) = Toy_private_adjustOrderedTableCapacity((*tableHandle), newCapacity);
+	}
+
+	appendEntry((*tableHandle), key, value, Toy_hashValue(key));
+}
+
+Toy_Value Toy_lookupOrderedTable(Toy_OrderedTable** tableHandle, Toy_Value key) {
+	if (TOY_VALUE_IS_NULL(key) || TOY_VALUE_IS_BOOLEAN(key)) { //TODO: disallow functions and opaques
+		Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+	}
+
+	unsigned int slot = getIndices(*tableHandle)[ probeSlot((*tableHandle), key, Toy_hashValue(key)) ];
+
+	if (slot == EMPTY_SLOT) {
+		return TOY_VALUE_FROM_NULL();
+	}
+
+	return (*tableHandle)->entries[slot - 1].value;
+}
+
+void Toy_removeOrderedTable(Toy_OrderedTable** tableHandle, Toy_Value key) {
+	if (TOY_VALUE_IS_NULL(key) || TOY_VALUE_IS_BOOLEAN(key)) { //TODO: disallow functions and opaques
+		Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+	}
+
+	unsigned int probe = probeSlot((*tableHandle), key, Toy_hashValue(key));
+	unsigned int* indices = getIndices(*tableHandle);
+
+	if (indices[probe] == EMPTY_SLOT) {
+		return;
+	}
+
+	//leave a hole in the dense entries, and a marker in the sparse index so later probes continue
+	(*tableHandle)->entries[indices[probe] - 1] = (Toy_OrderedTableEntry){ .key = TOY_VALUE_FROM_NULL(), .value = TOY_VALUE_FROM_NULL(), .hash = 0 };
+	indices[probe] = REMOVED_SLOT;
+	(*tableHandle)->count--;
+}
+
+Toy_OrderedTableEntry* Toy_iterateOrderedTable(Toy_OrderedTable* table, unsigned int* iterator) {
+	while ((*iterator) < table->used) {
+		Toy_OrderedTableEntry* entry = &(table->entries[(*iterator)++]);
+
+		if (!TOY_VALUE_IS_NULL(entry->key)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "toy_common.h"
+#include "toy_value.h"
+
+//dense entry, stored in insertion order - https://mail.python.org/pipermail/python-dev/2012-December/123028.html
+typedef struct Toy_OrderedTableEntry { //32 | 64 BITNESS
+	Toy_Value key;                     //8  | 16
+	Toy_Value value;                   //8  | 16
+	unsigned int hash;                 //4  | 4
+} Toy_OrderedTableEntry;               //20 | 40
+
+//key-value table that remembers insertion order; the sparse index is stored directly after the dense entries
+typedef struct Toy_OrderedTable {     //32 | 64 BITNESS
+	unsigned int capacity;            //4  | 4 (sparse index slots)
+	unsigned int entryCapacity;       //4  | 4 (dense entries)
+	unsigned int count;               //4  | 4 (live entries)
+	unsigned int used;                //4  | 4 (live entries + removed entries)
+	Toy_OrderedTableEntry entries[];  //-  | -
+} Toy_OrderedTable;                   //16 | 16
+
+TOY_API Toy_OrderedTable* Toy_allocateOrderedTable();
+TOY_API void Toy_freeOrderedTable(Toy_OrderedTable* table);
+TOY_API void Toy_insertOrderedTable(Toy_OrderedTable** tableHandle, Toy_Value key, Toy_Value value);
+TOY_API Toy_Value Toy_lookupOrderedTable(Toy_OrderedTable** tableHandle, Toy_Value key);
+TOY_API void Toy_removeOrderedTable(Toy_OrderedTable** tableHandle, Toy_Value key);
+
+//visits only live entries, in insertion order; start the iterator at 0, returns NULL when finished
+TOY_API Toy_OrderedTableEntry* Toy_iterateOrderedTable(Toy_OrderedTable* table, unsigned int* iterator);
+
+//NOTE: also used to compact away removed entries, when newCapacity matches the old one
+TOY_API Toy_OrderedTable* Toy_private_adjustOrderedTableCapacity(Toy_OrderedTable* oldTable, unsigned int newCapacity);
+
+//some useful sizes, could be swapped out as needed
+#ifndef TOY_ORDERED_TABLE_INITIAL_CAPACITY
+#define TOY_ORDERED_TABLE_INITIAL_CAPACITY 8
+#endif
+
+//NOTE: The DOOM hack needs a power of 2
+#ifndef TOY_ORDERED_TABLE_EXPANSION_RATE
+#define TOY_ORDERED_TABLE_EXPANSION_RATE 2
+#endif
+
+//the dense entries are capped at a percentage of the sparse index, which keeps probing short
+#ifndef TOY_ORDERED_TABLE_DENSITY
+#define TOY_ORDERED_TABLE_DENSITY 0.75
+#endif
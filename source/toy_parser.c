@@ -683,6 +683,20 @@ static void makePrintStmt(Toy_Bucket** bucketHandle, Toy_Parser* parser, Toy_Ast
 	consume(parser, TOY_TOKEN_OPERATOR_SEMICOLON, "Expected ';' at the end of print statement");
 }
 
+static void makeYieldStmt(Toy_Bucket** bucketHandle, Toy_Parser* parser, Toy_Ast** rootHandle) {
+	//a bare 'yield;' hands null back to the host
+	if (parser->current.type == TOY_TOKEN_OPERATOR_SEMICOLON) {
+		Toy_private_emitAstValue(bucketHandle, rootHandle, TOY_VALUE_FROM_NULL());
+	}
+	else {
+		makeExpr(bucketHandle, parser, rootHandle);
+	}
+
+	Toy_private_emitAstYield(bucketHandle, rootHandle);
+
+	consume(parser, TOY_TOKEN_OPERATOR_SEMICOLON, "Expected ';' at the end of yield statement");
+}
+
 static void makeExprStmt(Toy_Bucket** bucketHandle, Toy_Parser* parser, Toy_Ast** rootHandle) {
 	makeExpr(bucketHandle, parser, rootHandle);
 	consume(parser, TOY_TOKEN_OPERATOR_SEMICOLON, "Expected ';' at the end of expression statement");
@@ -760,6 +774,11 @@ static void makeStmt(Toy_Bucket** bucketHandle, Toy_Parser* parser, Toy_Ast** ro
 		return;
 	}
 
+	else if (match(parser, TOY_TOKEN_KEYWORD_YIELD)) {
+		makeYieldStmt(bucketHandle, parser, rootHandle);
+		return;
+	}
+
 	else {
 		//default
 		makeExprStmt(bucketHandle, parser, rootHandle);
@@ -0,0 +1,468 @@
+#include "toy_persistent_table.h"
+#include "toy_console_colors.h"
+#include "toy_print.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//32-way branching, 5 bits of the hash per level; below the last level, entries with identical hashes are stored side by side
+#define BITS_PER_LEVEL 5
+#define LEVEL_MASK 0x1F
+#define MAX_SHIFT 30
+
+typedef Toy_PersistentNode Node;
+typedef Toy_TableEntry Entry;
+
+//utils
+static inline unsigned int countBits(unsigned int x) {
+	//SWAR popcount
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	x = (x + (x >> 4)) & 0x0F0F0F0F;
+	return (x * 0x01010101) >> 24;
+}
+
+static inline unsigned int fragment(unsigned int hash, unsigned int shift) {
+	return (hash >> shift) & LEVEL_MASK;
+}
+
+static inline unsigned int countEntries(Node* node) {
+	return node->collisions + countBits(node->dataMap);
+}
+
+static inline Node** getNodes(Node* node) {
+	return (Node**)(node->entries + countEntries(node));
+}
+
+//strings cache their hashes, so the keys' are cheap to recompute
+static inline unsigned int hashEntry(Entry* entry) {
+	return Toy_hashValue(entry->key);
+}
+
+static inline bool checkEntryMatches(Entry* entry, Toy_Value key, unsigned int hash) {
+	return hashEntry(entry) == hash && Toy_checkValuesAreEqual(entry->key, key);
+}
+
+static Node* allocateNode(unsigned int dataMap, unsigned int nodeMap, unsigned int collisions) {
+	unsigned int entries = collisions + countBits(dataMap);
+	unsigned int nodes = countBits(nodeMap);
+
+	Node* node = malloc(sizeof(Node) + entries * sizeof(Entry) + nodes * sizeof(Node*));
+
+	if (node == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_PersistentNode' with %d entries and %d nodes\n" TOY_CC_RESET, (int)entries, (int)nodes);
+		exit(1);
+	}
+
+	node->refCount = 1;
+	node->dataMap = dataMap;
+	node->nodeMap = nodeMap;
+	node->collisions = collisions;
+
+	return node;
+}
+
+static void releaseNode(Node* node) {
+	if (node == NULL || --node->refCount > 0) {
+		return;
+	}
+
+	unsigned int entries = countEntries(node);
+	for (unsigned int i = 0; i < entries; i++) {
+		Toy_freeValue(node->entries[i].key);
+		Toy_freeValue(node->entries[i].value);
+	}
+
+	unsigned int nodes = countBits(node->nodeMap);
+	for (unsigned int i = 0; i < nodes; i++) {
+		releaseNode(getNodes(node)[i]);
+	}
+
+	free(node);
+}
+
+//copy-on-write: a shared node is cloned before modification, and the clone replaces it in the parent
+static Node* ensureUnique(Node* node) {
+	if (node->refCount == 1) {
+		return node;
+	}
+
+	Node* clone = allocateNode(node->dataMap, node->nodeMap, node->collisions);
+
+	unsigned int entries = countEntries(node);
+	for (unsigned int i = 0; i < entries; i++) {
+		clone->entries[i] = (Entry){ .key = Toy_copyValue(node->entries[i].key), .value = Toy_copyValue(node->entries[i].value), .psl = 0 };
+	}
+
+	unsigned int nodes = countBits(node->nodeMap);
+	for (unsigned int i = 0; i < nodes; i++) {
+		getNodes(clone)[i] = getNodes(node)[i];
+		getNodes(clone)[i]->refCount++;
+	}
+
+	node->refCount--;
+	return clone;
+}
+
+//rebuild a unique branch node with different maps; the contents are moved, not copied
+static Node* packNode(Node* old, unsigned int dataMap, unsigned int nodeMap, Entry* entries, Node** nodes) {
+	Node* node = allocateNode(dataMap, nodeMap, 0);
+
+	memcpy(node->entries, entries, countBits(dataMap) * sizeof(Entry));
+	memcpy(getNodes(node), nodes, countBits(nodeMap) * sizeof(Node*));
+
+	free(old);
+	return node;
+}
+
+static void unpackNode(Node* node, Entry* entries, Node** nodes) {
+	memcpy(entries, node->entries, countBits(node->dataMap) * sizeof(Entry));
+	memcpy(nodes, getNodes(node), countBits(node->nodeMap) * sizeof(Node*));
+}
+
+static Node* makePair(unsigned int shift, Entry a, Entry b) {
+	//out of hash bits
+	if (shift > MAX_SHIFT) {
+		Node* node = allocateNode(0, 0, 2);
+		node->entries[0] = a;
+		node->entries[1] = b;
+		return node;
+	}
+
+	unsigned int fa = fragment(hashEntry(&a), shift);
+	unsigned int fb = fragment(hashEntry(&b), shift);
+
+	//both fit at this level, in bit order
+	if (fa != fb) {
+		Node* node = allocateNode((1u << fa) | (1u << fb), 0, 0);
+		node->entries[0] = fa < fb ? a : b;
+		node->entries[1] = fa < fb ? b : a;
+		return node;
+	}
+
+	//both collide at this level
+	Node* node = allocateNode(0, 1u << fa, 0);
+	getNodes(node)[0] = makePair(shift + BITS_PER_LEVEL, a, b);
+	return node;
+}
+
+static Entry* findEntry(Node* node, Toy_Value key, unsigned int hash) {
+	unsigned int shift = 0;
+
+	while (node != NULL) {
+		if (shift > MAX_SHIFT) {
+			for (unsigned int i = 0; i < node->collisions; i++) {
+				if (checkEntryMatches(&node->entries[i], key, hash)) {
+					return &node->entries[i];
+				}
+			}
+			return NULL;
+		}
+
+		unsigned int bit = 1u << fragment(hash, shift);
+
+		if (node->dataMap & bit) {
+			Entry* entry = &node->entries[countBits(node->dataMap & (bit - 1))];
+			return checkEntryMatches(entry, key, hash) ? entry : NULL;
+		}
+
+		if ((node->nodeMap & bit) == 0) {
+			return NULL;
+		}
+
+		node = getNodes(node)[countBits(node->nodeMap & (bit - 1))];
+		shift += BITS_PER_LEVEL;
+	}
+
+	return NULL;
+}
+
+static Node* insertNode(Node* node, unsigned int shift, Entry entry, unsigned int hash, bool* added) {
+	node = ensureUnique(node);
+
+	//bottom of the trie
+	if (shift > MAX_SHIFT) {
+		for (unsigned int i = 0; i < node->collisions; i++) {
+			if (checkEntryMatches(&node->entries[i], entry.key, hash)) {
+				Toy_freeValue(node->entries[i].key);
+				Toy_freeValue(node->entries[i].value);
+				node->entries[i] = entry;
+				return node;
+			}
+		}
+
+		Node* result = allocateNode(0, 0, node->collisions + 1);
+		memcpy(result->entries, node->entries, node->collisions * sizeof(Entry));
+		result->entries[node->collisions] = entry;
+		free(node);
+
+		*added = true;
+		return result;
+	}
+
+	unsigned int bit = 1u << fragment(hash, shift);
+	unsigned int index = countBits(node->dataMap & (bit - 1));
+
+	//if this slot has a subnode, recurse
+	if (node->nodeMap & bit) {
+		Node** slot = &getNodes(node)[countBits(node->nodeMap & (bit - 1))];
+		(*slot) = insertNode((*slot), shift + BITS_PER_LEVEL, entry, hash, added);
+		return node;
+	}
+
+	Entry entries[32];
+	Node* nodes[32];
+	unpackNode(node, entries, nodes);
+
+	//if this slot has an entry, override it or push both down a level
+	if (node->dataMap & bit) {
+		if (checkEntryMatches(&node->entries[index], entry.key, hash)) {
+			Toy_freeValue(node->entries[index].key);
+			Toy_freeValue(node->entries[index].value);
+			node->entries[index] = entry;
+			return node;
+		}
+
+		unsigned int dataMap = node->dataMap & ~bit;
+		unsigned int nodeMap = node->nodeMap | bit;
+		unsigned int nodeIndex = countBits(nodeMap & (bit - 1));
+
+		Node* sub = makePair(shift + BITS_PER_LEVEL, entries[index], entry);
+
+		memmove(entries + index, entries + index + 1, (countBits(node->dataMap) - index - 1) * sizeof(Entry));
+		memmove(nodes + nodeIndex + 1, nodes + nodeIndex, (countBits(node->nodeMap) - nodeIndex) * sizeof(Node*));
+		nodes[nodeIndex] = sub;
+
+		*added = true;
+		return packNode(node, dataMap, nodeMap, entries, nodes);
+	}
+
+	//empty slot
+	memmove(entries + index + 1, entries + index, (countBits(node->dataMap) - index) * sizeof(Entry));
+	entries[index] = entry;
+
+	*added = true;
+	return packNode(node, node->dataMap | bit, node->nodeMap, entries, nodes);
+}
+
+//NOTE: only called when the key is known to be present
+static Node* removeNode(Node* node, unsigned int shift, Toy_Value key, unsigned int hash) {
+	node = ensureUnique(node);
+
+	//bottom of the trie
+	if (shift > MAX_SHIFT) {
+		unsigned int i = 0;
+		while (!checkEntryMatches(&node->entries[i], key, hash)) {
+			i++;
+		}
+
+		Toy_freeValue(node->entries[i].key);
+		Toy_freeValue(node->entries[i].value);
+
+		if (node->collisions == 1) {
+			free(node);
+			return NULL;
+		}
+
+		Node* result = allocateNode(0, 0, node->collisions - 1);
+		memcpy(result->entries, node->entries, i * sizeof(Entry));
+		memcpy(result->entries + i, node->entries + i + 1, (node->collisions - i - 1) * sizeof(Entry));
+		free(node);
+
+		return result;
+	}
+
+	unsigned int bit = 1u << fragment(hash, shift);
+	unsigned int index = countBits(node->dataMap & (bit - 1));
+	unsigned int nodeIndex = countBits(node->nodeMap & (bit - 1));
+
+	Entry entries[32];
+	Node* nodes[32];
+
+	//the entry is here
+	if (node->dataMap & bit) {
+		Toy_freeValue(node->entries[index].key);
+		Toy_freeValue(node->entries[index].value);
+
+		if ((node->dataMap & ~bit) == 0 && node->nodeMap == 0) {
+			free(node);
+			return NULL;
+		}
+
+		unpackNode(node, entries, nodes);
+		memmove(entries + index, entries + index + 1, (countBits(node->dataMap) - index - 1) * sizeof(Entry));
+
+		return packNode(node, node->dataMap & ~bit, node->nodeMap, entries, nodes);
+	}
+
+	//the entry is further down
+	Node* child = removeNode(getNodes(node)[nodeIndex], shift + BITS_PER_LEVEL, key, hash);
+
+	if (child != NULL && (child->nodeMap != 0 || countEntries(child) > 1)) {
+		getNodes(node)[nodeIndex] = child;
+		return node;
+	}
+
+	if (child == NULL && (node->nodeMap & ~bit) == 0 && node->dataMap == 0) {
+		free(node);
+		return NULL;
+	}
+
+	unpackNode(node, entries, nodes);
+	memmove(nodes + nodeIndex, nodes + nodeIndex + 1, (countBits(node->nodeMap) - nodeIndex - 1) * sizeof(Node*));
+
+	if (child == NULL) {
+		return packNode(node, node->dataMap, node->nodeMap & ~bit, entries, nodes);
+	}
+
+	//a child with a single entry left is pulled up into this level
+	memmove(entries + index + 1, entries + index, (countBits(node->dataMap) - index) * sizeof(Entry));
+	entries[index] = child->entries[0];
+	free(child);
+
+	return packNode(node, node->dataMap | bit, node->nodeMap & ~bit, entries, nodes);
+}
+
+static Entry* findEntryForWrite(Node** nodeHandle, unsigned int shift, Toy_Value key, unsigned int hash) {
+	(*nodeHandle) = ensureUnique(*nodeHandle);
+	Node* node = (*nodeHandle);
+
+	if (shift > MAX_SHIFT) {
+		for (unsigned int i = 0; i < node->collisions; i++) {
+			if (checkEntryMatches(&node->entries[i], key, hash)) {
+				return &node->entries[i];
+			}
+		}
+		return NULL;
+	}
+
+	unsigned int bit = 1u << fragment(hash, shift);
+
+	if (node->dataMap & bit) {
+		return &node->entries[countBits(node->dataMap & (bit - 1))];
+	}
+
+	return findEntryForWrite(&getNodes(node)[countBits(node->nodeMap & (bit - 1))], shift + BITS_PER_LEVEL, key, hash);
+}
+
+static void visitNode(Node* node, Toy_PersistentTableCallback callback, void* userData) {
+	if (node == NULL) {
+		return;
+	}
+
+	unsigned int entries = countEntries(node);
+	for (unsigned int i = 0; i < entries; i++) {
+		callback(&node->entries[i], userData);
+	}
+
+	unsigned int nodes = countBits(node->nodeMap);
+	for (unsigned int i = 0; i < nodes; i++) {
+		visitNode(getNodes(node)[i], callback, userData);
+	}
+}
+
+//exposed functions
+Toy_PersistentTable* Toy_allocatePersistentTable() {
+	Toy_PersistentTable* table = malloc(sizeof(Toy_PersistentTable));
+
+	if (table == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_PersistentTable'\n" TOY_CC_RESET);
+		exit(1);
+	}
+
+	table->root = NULL;
+	table->count = 0;
+	table->version = 0;
+
+	return table;
+}
+
+Toy_PersistentTable* Toy_copyPersistentTable(Toy_PersistentTable* table) {
+	Toy_PersistentTable* copy = Toy_allocatePersistentTable();
+
+	copy->root = table->root;
+	copy->count = table->count;
+	table->version++; //the source's entries are shared from now on
+
+	if (copy->root != NULL) {
+		copy->root->refCount++;
+	}
+
+	return copy;
+}
+
+void Toy_freePersistentTable(Toy_PersistentTable* table) {
+	if (table != NULL) {
+		releaseNode(table->root);
+		free(table);
+	}
+}
+
+void Toy_insertPersistentTable(Toy_PersistentTable** tableHandle, Toy_Value key, Toy_Value value) {
+	if (TOY_VALUE_IS_NULL(key) || TOY_VALUE_IS_BOOLEAN(key)) { //TODO: disallow functions and opaques
+		Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+		return;
+	}
+
+	if ((*tableHandle)->root == NULL) {
+		(*tableHandle)->root = allocateNode(0, 0, 0);
+	}
+
+	bool added = false;
+	(*tableHandle)->root = insertNode((*tableHandle)->root, 0, (Entry){ .key = key, .value = value, .psl = 0 }, Toy_hashValue(key), &added);
+
+	if (added) {
+		(*tableHandle)->count++;
+	}
+}
+
+Toy_Value Toy_lookupPersistentTable(Toy_PersistentTable** tableHandle, Toy_Value key) {
+	if (TOY_VALUE_IS_NULL(key) || TOY_VALUE_IS_BOOLEAN(key)) { //TODO: disallow functions and opaques
+		Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+		return TOY_VALUE_FROM_NULL();
+	}
+
+	Entry* entry = findEntry((*tableHandle)->root, key, Toy_hashValue(key));
+
+	return entry != NULL ? entry->value : TOY_VALUE_FROM_NULL();
+}
+
+void Toy_removePersistentTable(Toy_PersistentTable** tableHandle, Toy_Value key) {
+	if (TOY_VALUE_IS_NULL(key) || TOY_VALUE_IS_BOOLEAN(key)) { //TODO: disallow functions and opaques
+		Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+		return;
+	}
+
+	unsigned int hash = Toy_hashValue(key);
+
+	//don't copy anything if there's nothing to remove
+	if (findEntry((*tableHandle)->root, key, hash) == NULL) {
+		return;
+	}
+
+	(*tableHandle)->root = removeNode((*tableHandle)->root, 0, key, hash);
+	(*tableHandle)->count--;
+}
+
+void Toy_forEachPersistentTable(Toy_PersistentTable* table, Toy_PersistentTableCallback callback, void* userData) {
+	visitNode(table->root, callback, userData);
+}
+
+Toy_TableEntry* Toy_private_findPersistentEntry(Toy_PersistentTable** tableHandle, Toy_Value key, bool forWrite, bool* copied) {
+	unsigned int hash = Toy_hashValue(key);
+	Entry* entry = findEntry((*tableHandle)->root, key, hash);
+
+	if (entry == NULL || !forWrite) {
+		return entry;
+	}
+
+	//only the shared nodes on the path are cloned, which moves the entry
+	Entry* written = findEntryForWrite(&(*tableHandle)->root, 0, key, hash);
+
+	if (copied != NULL) {
+		(*copied) = written != entry;
+	}
+
+	return written;
+}
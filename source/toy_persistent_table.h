@@ -0,0 +1,41 @@
+#pragma once
+
+#include "toy_common.h"
+#include "toy_value.h"
+#include "toy_table.h"
+
+//hash array mapped trie, with structural sharing - https://michael.steindorfer.name/publications/oopsla15.pdf
+//the entries are stored first, followed by the subnode pointers (collision nodes at the bottom only have entries)
+//entries are the same as Toy_Table's, so Toy_Scope can hand out either; 'psl' is unused, and hashes are recomputed from the keys
+typedef struct Toy_PersistentNode { //32 | 64 BITNESS
+	unsigned int refCount;          //4  | 4
+	unsigned int dataMap;           //4  | 4
+	unsigned int nodeMap;           //4  | 4
+	unsigned int collisions;        //4  | 4
+	Toy_TableEntry entries[];       //-  | -
+} Toy_PersistentNode;               //16 | 16
+
+//each copy is a separate handle, sharing the trie until one of them is modified
+typedef struct Toy_PersistentTable { //32 | 64 BITNESS
+	Toy_PersistentNode* root;        //4  | 8
+	unsigned int count;              //4  | 4
+	unsigned int version;            //4  | 4
+} Toy_PersistentTable;               //12 | 16
+
+TOY_API Toy_PersistentTable* Toy_allocatePersistentTable();
+TOY_API Toy_PersistentTable* Toy_copyPersistentTable(Toy_PersistentTable* table); //O(1) snapshot, bumps the source's version
+TOY_API void Toy_freePersistentTable(Toy_PersistentTable* table);
+
+//the table takes ownership of the key and value; only the modified path is copied if it's shared
+TOY_API void Toy_insertPersistentTable(Toy_PersistentTable** tableHandle, Toy_Value key, Toy_Value value);
+TOY_API Toy_Value Toy_lookupPersistentTable(Toy_PersistentTable** tableHandle, Toy_Value key);
+TOY_API void Toy_removePersistentTable(Toy_PersistentTable** tableHandle, Toy_Value key);
+
+//visits every entry, in no particular order; the callback mustn't modify the table
+typedef void (*Toy_PersistentTableCallback)(Toy_TableEntry* entry, void* userData);
+TOY_API void Toy_forEachPersistentTable(Toy_PersistentTable* table, Toy_PersistentTableCallback callback, void* userData);
+
+//NOTE: exposed for Toy_Scope, which holds onto the entry; NULL if it's missing
+//writes copy the path to the entry first, so other snapshots are unaffected, and set 'copied' when that moved the entry
+//an entry found for writing stays unshared until the table's version changes
+TOY_API Toy_TableEntry* Toy_private_findPersistentEntry(Toy_PersistentTable** tableHandle, Toy_Value key, bool forWrite, bool* copied);
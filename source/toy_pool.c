@@ -0,0 +1,445 @@
+//for pthread_mutex_t and pthread_cond_t under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_pool.h"
+#include "toy_console_colors.h"
+#include "toy_print.h"
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Toy_PoolJob {
+	const char* source;
+	Toy_PoolResult result;
+	unsigned int outputCapacity;
+	unsigned int errorsCapacity;
+} Toy_PoolJob;
+
+//a ring buffer of jobs; the owner pops from the bottom, while thieves take the oldest from the top
+typedef struct Toy_PoolDeque {
+	pthread_mutex_t lock;
+	Toy_PoolJob** jobs;
+	unsigned int capacity;
+	unsigned int top;
+	unsigned int bottom;
+} Toy_PoolDeque;
+
+typedef struct Toy_PoolWorker {
+	pthread_t thread;
+	Toy_Pool* pool;
+	unsigned int index;
+	Toy_PoolDeque deque;
+	Toy_VM vm;
+} Toy_PoolWorker;
+
+struct Toy_Pool {
+	Toy_PoolWorker* workers;
+	unsigned int workerCount;
+	unsigned int nextWorker; //submissions are dealt out round-robin
+	Toy_CompileCache* cache; //optional, shared by every worker
+	bool removeAssert;
+	bool dense;
+
+	//every job by ticket, only touched by the submitting thread
+	Toy_PoolJob** jobs;
+	unsigned int jobCapacity;
+	unsigned int jobCount;
+
+	//guards the counters below, which let idle workers sleep
+	pthread_mutex_t lock;
+	pthread_cond_t workReady;
+	pthread_cond_t allDone;
+	unsigned int queued; //sitting in a deque
+	unsigned int pending; //queued or running
+	bool shutdown;
+};
+
+//utils
+static void initDeque(Toy_PoolDeque* deque) {
+	pthread_mutex_init(&deque->lock, NULL);
+	deque->jobs = NULL;
+	deque->capacity = 0;
+	deque->top = 0;
+	deque->bottom = 0;
+}
+
+static void freeDeque(Toy_PoolDeque* deque) {
+	free(deque->jobs);
+	pthread_mutex_destroy(&deque->lock);
+}
+
+static void pushDeque(Toy_PoolDeque* deque, Toy_PoolJob* job) {
+	pthread_mutex_lock(&deque->lock);
+
+	unsigned int count = deque->bottom - deque->top;
+
+	if (count == deque->capacity) {
+		unsigned int capacity = deque->capacity < 16 ? 16 : deque->capacity * 2;
+		Toy_PoolJob** jobs = malloc(capacity * sizeof(Toy_PoolJob*));
+
+		if (jobs == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_Pool' deque of %d jobs\n" TOY_CC_RESET, (int)capacity);
+			exit(1);
+		}
+
+		//unwrap the ring into the new buffer
+		for (unsigned int i = 0; i < count; i++) {
+			jobs[i] = deque->jobs[(deque->top + i) % deque->capacity];
+		}
+
+		free(deque->jobs);
+		deque->jobs = jobs;
+		deque->capacity = capacity;
+		deque->top = 0;
+		deque->bottom = count;
+	}
+
+	deque->jobs[deque->bottom % deque->capacity] = job;
+	deque->bottom++;
+
+	pthread_mutex_unlock(&deque->lock);
+}
+
+static Toy_PoolJob* popDeque(Toy_PoolDeque* deque) {
+	Toy_PoolJob* job = NULL;
+
+	pthread_mutex_lock(&deque->lock);
+	if (deque->bottom != deque->top) {
+		deque->bottom--;
+		job = deque->jobs[deque->bottom % deque->capacity];
+	}
+	pthread_mutex_unlock(&deque->lock);
+
+	return job;
+}
+
+static Toy_PoolJob* stealDeque(Toy_PoolDeque* deque) {
+	Toy_PoolJob* job = NULL;
+
+	pthread_mutex_lock(&deque->lock);
+	if (deque->bottom != deque->top) {
+		job = deque->jobs[deque->top % deque->capacity];
+		deque->top++;
+	}
+	pthread_mutex_unlock(&deque->lock);
+
+	return job;
+}
+
+//own work first, then the other workers' in order, starting with the next one along
+static Toy_PoolJob* findJob(Toy_PoolWorker* worker) {
+	Toy_Pool* pool = worker->pool;
+	Toy_PoolJob* job = popDeque(&worker->deque);
+
+	for (unsigned int i = 1; job == NULL && i < pool->workerCount; i++) {
+		job = stealDeque(&pool->workers[(worker->index + i) % pool->workerCount].deque);
+	}
+
+	return job;
+}
+
+static void appendLine(char** bufferHandle, unsigned int* lengthHandle, unsigned int* capacityHandle, const char* msg) {
+	unsigned int length = strlen(msg);
+
+	//grow geometrically, since scripts can print a lot of short lines
+	if (*lengthHandle + length + 2 > *capacityHandle) {
+		unsigned int capacity = *capacityHandle < 64 ? 64 : *capacityHandle;
+		while (capacity < *lengthHandle + length + 2) {
+			capacity *= 2;
+		}
+
+		char* buffer = realloc(*bufferHandle, capacity);
+
+		if (buffer == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to capture the output of a 'Toy_Pool' script\n" TOY_CC_RESET);
+			exit(1);
+		}
+
+		*bufferHandle = buffer;
+		*capacityHandle = capacity;
+	}
+
+	char* buffer = *bufferHandle;
+
+	memcpy(buffer + *lengthHandle, msg, length);
+	*lengthHandle += length;
+	buffer[(*lengthHandle)++] = '\n';
+	buffer[*lengthHandle] = '\0';
+}
+
+static void captureOutput(const char* msg, void* userData) {
+	Toy_PoolJob* job = userData;
+	appendLine(&job->result.output, &job->result.outputLength, &job->outputCapacity, msg);
+}
+
+static void captureErrors(const char* msg, void* userData) {
+	Toy_PoolJob* job = userData;
+	appendLine(&job->result.errors, &job->result.errorsLength, &job->errorsCapacity, msg);
+}
+
+//drop everything the last script left behind, keeping the stack, table pool and VM itself for the next one
+static void recycleVM(Toy_VM* vm) {
+	//the yielded value may point into the buckets
+	Toy_resetVM(vm);
+
+	while (vm->scope != NULL) {
+		vm->scope = Toy_popScope(vm->scope);
+	}
+
+	//the strings and scopes die with the script that made them
+	Toy_freeBucket(&vm->stringBucket);
+	Toy_freeBucket(&vm->scopeBucket);
+}
+
+static void runJob(Toy_PoolWorker* worker, Toy_PoolJob* job) {
+	//everything this thread reports while working on the job ends up in its result
+	Toy_PrintContext context = { .printCallback = captureOutput, .errorCallback = captureErrors, .assertCallback = captureErrors, .userData = job };
+	Toy_PrintContext* outerContext = Toy_swapPrintContext(&context);
+
+	Toy_Bytecode bc = { .ptr = NULL, .capacity = 0, .count = 0 };
+
+	if (worker->pool->cache != NULL) {
+		bc = Toy_compileCached(worker->pool->cache, job->source, worker->pool->removeAssert, worker->pool->dense);
+	}
+	else {
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+		Toy_Lexer lexer;
+		Toy_bindLexer(&lexer, job->source);
+		Toy_Parser parser;
+		Toy_bindParser(&parser, &lexer);
+		Toy_configureParser(&parser, worker->pool->removeAssert);
+		Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+
+		if (!parser.error) {
+			bc = worker->pool->dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+		}
+
+		Toy_freeBucket(&bucket);
+	}
+
+	if (bc.ptr == NULL) {
+		job->result.compiled = false;
+		job->result.status = TOY_VM_STATUS_PANIC;
+	}
+	else {
+		//the worker's VM is reused, but scripts are independent, so each one gets a fresh scope
+		Toy_setVMPrintContext(&worker->vm, context);
+
+		//the pool is the host for 'yield', capturing each value as output
+		Toy_VMStatus status = TOY_VM_STATUS_PANIC;
+		if (Toy_bindVM(&worker->vm, bc.ptr, bc.count)) {
+			status = Toy_runVM(&worker->vm);
+			while (status == TOY_VM_STATUS_YIELDED_VALUE) {
+				Toy_stringifyValue(worker->vm.yieldValue, Toy_print);
+				status = Toy_runVM(&worker->vm);
+			}
+		}
+
+		recycleVM(&worker->vm);
+		Toy_freeBytecode(bc);
+
+		job->result.compiled = true;
+		job->result.status = status;
+	}
+
+	Toy_swapPrintContext(outerContext);
+}
+
+static void* workerLoop(void* arg) {
+	Toy_PoolWorker* worker = arg;
+	Toy_Pool* pool = worker->pool;
+
+	//one VM for every script this worker runs
+	Toy_initVM(&worker->vm);
+
+	for (;;) {
+		Toy_PoolJob* job = findJob(worker);
+
+		if (job == NULL) {
+			//sleep until there's something to find
+			pthread_mutex_lock(&pool->lock);
+			while (pool->queued == 0 && !pool->shutdown) {
+				pthread_cond_wait(&pool->workReady, &pool->lock);
+			}
+
+			bool finished = pool->queued == 0 && pool->shutdown;
+			pthread_mutex_unlock(&pool->lock);
+
+			if (finished) {
+				Toy_freeVM(&worker->vm);
+				return NULL;
+			}
+
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		pool->queued--;
+		pthread_mutex_unlock(&pool->lock);
+
+		runJob(worker, job);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->pending == 0) {
+			pthread_cond_broadcast(&pool->allDone);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+//exposed functions
+Toy_Pool* Toy_allocatePool(unsigned int workerCount) {
+	if (workerCount == 0) {
+		workerCount = 1;
+	}
+
+	Toy_Pool* pool = malloc(sizeof(Toy_Pool));
+	Toy_PoolWorker* workers = malloc(workerCount * sizeof(Toy_PoolWorker));
+
+	if (pool == NULL || workers == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a 'Toy_Pool' of %d workers\n" TOY_CC_RESET, (int)workerCount);
+		exit(1);
+	}
+
+	pool->workers = workers;
+	pool->workerCount = workerCount;
+	pool->nextWorker = 0;
+	pool->cache = NULL;
+	pool->removeAssert = false;
+	pool->dense = false;
+
+	pool->jobs = NULL;
+	pool->jobCapacity = 0;
+	pool->jobCount = 0;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->workReady, NULL);
+	pthread_cond_init(&pool->allDone, NULL);
+	pool->queued = 0;
+	pool->pending = 0;
+	pool->shutdown = false;
+
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers[i].pool = pool;
+		workers[i].index = i;
+		initDeque(&workers[i].deque);
+	}
+
+	//start only once every deque exists, since any worker may steal from any other
+	for (unsigned int i = 0; i < workerCount; i++) {
+		if (pthread_create(&workers[i].thread, NULL, workerLoop, &workers[i]) != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to start a worker thread for 'Toy_Pool'\n" TOY_CC_RESET);
+			exit(1);
+		}
+	}
+
+	return pool;
+}
+
+void Toy_freePool(Toy_Pool* pool) {
+	if (pool == NULL) {
+		return;
+	}
+
+	//let the workers drain the deques, then exit
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->workReady);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (unsigned int i = 0; i < pool->workerCount; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	//only once every worker has stopped stealing
+	for (unsigned int i = 0; i < pool->workerCount; i++) {
+		freeDeque(&pool->workers[i].deque);
+	}
+
+	for (unsigned int i = 0; i < pool->jobCount; i++) {
+		free(pool->jobs[i]->result.output);
+		free(pool->jobs[i]->result.errors);
+		free(pool->jobs[i]);
+	}
+
+	pthread_cond_destroy(&pool->allDone);
+	pthread_cond_destroy(&pool->workReady);
+	pthread_mutex_destroy(&pool->lock);
+
+	free(pool->jobs);
+	free(pool->workers);
+	free(pool);
+}
+
+unsigned int Toy_submitPool(Toy_Pool* pool, const char* source) {
+	Toy_PoolJob* job = malloc(sizeof(Toy_PoolJob));
+
+	if (pool->jobCount == pool->jobCapacity) {
+		pool->jobCapacity = pool->jobCapacity < 16 ? 16 : pool->jobCapacity * 2;
+		pool->jobs = realloc(pool->jobs, pool->jobCapacity * sizeof(Toy_PoolJob*));
+	}
+
+	if (job == NULL || pool->jobs == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a job for 'Toy_Pool'\n" TOY_CC_RESET);
+		exit(1);
+	}
+
+	job->source = source;
+	job->result = (Toy_PoolResult){ .compiled = false, .status = TOY_VM_STATUS_OK, .output = NULL, .outputLength = 0, .errors = NULL, .errorsLength = 0 };
+	job->outputCapacity = 0;
+	job->errorsCapacity = 0;
+
+	unsigned int ticket = pool->jobCount++;
+	pool->jobs[ticket] = job;
+
+	//count it before it's visible, so a worker can't finish it first
+	pthread_mutex_lock(&pool->lock);
+	pool->queued++;
+	pool->pending++;
+	pthread_mutex_unlock(&pool->lock);
+
+	pushDeque(&pool->workers[pool->nextWorker].deque, job);
+	pool->nextWorker = (pool->nextWorker + 1) % pool->workerCount;
+
+	pthread_mutex_lock(&pool->lock);
+	pthread_cond_signal(&pool->workReady);
+	pthread_mutex_unlock(&pool->lock);
+
+	return ticket;
+}
+
+void Toy_waitPool(Toy_Pool* pool) {
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0) {
+		pthread_cond_wait(&pool->allDone, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+Toy_PoolResult* Toy_getPoolResult(Toy_Pool* pool, unsigned int ticket) {
+	if (ticket >= pool->jobCount) {
+		return NULL;
+	}
+
+	return &pool->jobs[ticket]->result;
+}
+
+unsigned int Toy_getPoolWorkerCount(Toy_Pool* pool) {
+	return pool->workerCount;
+}
+
+void Toy_setPoolCompileCache(Toy_Pool* pool, Toy_CompileCache* cache) {
+	pool->cache = cache;
+}
+
+void Toy_configurePool(Toy_Pool* pool, bool removeAssert, bool dense) {
+	pool->removeAssert = removeAssert;
+	pool->dense = dense;
+}
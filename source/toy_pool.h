@@ -0,0 +1,34 @@
+#pragma once
+
+#include "toy_common.h"
+#include "toy_vm.h"
+#include "toy_compile_cache.h"
+
+//NOTE: the pool holds platform-specific threads and locks, so it's only defined in the source file
+typedef struct Toy_Pool Toy_Pool;
+
+//the outcome of one script, filled in by whichever worker ran it
+typedef struct Toy_PoolResult {
+	bool compiled;              //false if the parser reported an error
+	Toy_VMStatus status;        //TOY_VM_STATUS_PANIC if it didn't compile
+	char* output;               //print output and yielded values, one per line
+	unsigned int outputLength;
+	char* errors;               //runtime errors and assert failures, one per line
+	unsigned int errorsLength;
+} Toy_PoolResult;
+
+//runs independent scripts on a fixed set of worker threads, each with its own VM
+TOY_API Toy_Pool* Toy_allocatePool(unsigned int workerCount);
+TOY_API void Toy_freePool(Toy_Pool* pool); //waits for the submitted scripts first
+
+TOY_API unsigned int Toy_submitPool(Toy_Pool* pool, const char* source); //the source must outlive the script's run, returns a ticket
+TOY_API void Toy_waitPool(Toy_Pool* pool); //blocks until every submitted script has finished
+TOY_API Toy_PoolResult* Toy_getPoolResult(Toy_Pool* pool, unsigned int ticket); //only valid after Toy_waitPool(), until the pool is freed
+
+TOY_API unsigned int Toy_getPoolWorkerCount(Toy_Pool* pool);
+
+//compile through the given cache from now on, which must outlive the pool; only set this while no scripts are pending
+TOY_API void Toy_setPoolCompileCache(Toy_Pool* pool, Toy_CompileCache* cache);
+
+//how every script is compiled, with or without the cache; only set this while no scripts are pending
+TOY_API void Toy_configurePool(Toy_Pool* pool, bool removeAssert, bool dense);
@@ -14,15 +14,33 @@ static Toy_callbackType printCallback = outDefault;
 static Toy_callbackType errorCallback = errDefault;
 static Toy_callbackType assertCallback = errDefault;
 
+//set by the VM for the duration of a run
+static _Thread_local Toy_PrintContext* currentContext = NULL;
+
 void Toy_print(const char* msg) {
+	if (currentContext != NULL && currentContext->printCallback != NULL) {
+		currentContext->printCallback(msg, currentContext->userData);
+		return;
+	}
+
 	printCallback(msg);
 }
 
 void Toy_error(const char* msg) {
+	if (currentContext != NULL && currentContext->errorCallback != NULL) {
+		currentContext->errorCallback(msg, currentContext->userData);
+		return;
+	}
+
 	errorCallback(msg);
 }
 
 void Toy_assertFailure(const char* msg) {
+	if (currentContext != NULL && currentContext->assertCallback != NULL) {
+		currentContext->assertCallback(msg, currentContext->userData);
+		return;
+	}
+
 	assertCallback(msg);
 }
 
@@ -49,3 +67,9 @@ void Toy_resetErrorCallback() {
 void Toy_resetAssertFailureCallback() {
 	assertCallback = errDefault;
 }
+
+Toy_PrintContext* Toy_swapPrintContext(Toy_PrintContext* context) {
+	Toy_PrintContext* previous = currentContext;
+	currentContext = context;
+	return previous;
+}
@@ -17,3 +17,15 @@ TOY_API void Toy_resetPrintCallback();
 TOY_API void Toy_resetErrorCallback();
 TOY_API void Toy_resetAssertFailureCallback();
 
+
+//per-VM sinks with a user pointer, so separate VMs can run on separate threads; a NULL callback falls back to the globals above
+typedef void (*Toy_ContextCallbackType)(const char* msg, void* userData);
+
+typedef struct Toy_PrintContext {
+	Toy_ContextCallbackType printCallback;
+	Toy_ContextCallbackType errorCallback;
+	Toy_ContextCallbackType assertCallback;
+	void* userData;
+} Toy_PrintContext;
+
+TOY_API Toy_PrintContext* Toy_swapPrintContext(Toy_PrintContext* context); //sets the calling thread's context, returning the previous one
@@ -29,20 +29,23 @@ static void emitByte(void** handle, unsigned int* capacity, unsigned int* count,
 	((unsigned char*)(*handle))[(*count)++] = byte;
 }
 
+static void emitBytes(void** handle, unsigned int* capacity, unsigned int* count, const void* bytes, unsigned int amount) {
+	expand(handle, capacity, count, amount);
+	memcpy((unsigned char*)(*handle) + (*count), bytes, amount);
+	(*count) += amount;
+}
+
 static void emitInt(void** handle, unsigned int* capacity, unsigned int* count, unsigned int bytes) {
-	char* ptr = (char*)&bytes;
-	emitByte(handle, capacity, count, *(ptr++));
-	emitByte(handle, capacity, count, *(ptr++));
-	emitByte(handle, capacity, count, *(ptr++));
-	emitByte(handle, capacity, count, *(ptr++));
+	emitBytes(handle, capacity, count, &bytes, sizeof(bytes));
 }
 
 static void emitFloat(void** handle, unsigned int* capacity, unsigned int* count, float bytes) {
-	char* ptr = (char*)&bytes;
-	emitByte(handle, capacity, count, *(ptr++));
-	emitByte(handle, capacity, count, *(ptr++));
-	emitByte(handle, capacity, count, *(ptr++));
-	emitByte(handle, capacity, count, *(ptr++));
+	emitBytes(handle, capacity, count, &bytes, sizeof(bytes));
+}
+
+static void emitInstruction(void** handle, unsigned int* capacity, unsigned int* count, unsigned char a, unsigned char b, unsigned char c, unsigned char d) {
+	unsigned char bytes[4] = { a, b, c, d };
+	emitBytes(handle, capacity, count, bytes, sizeof(bytes));
 }
 
 //write instructions based on the AST types
@@ -52,13 +55,94 @@ static void emitFloat(void** handle, unsigned int* capacity, unsigned int* count
 	emitInt((void**)(&((*rt)->part)), &((*rt)->part##Capacity), &((*rt)->part##Count), bytes);
 #define EMIT_FLOAT(rt, part, bytes) \
 	emitFloat((void**)(&((*rt)->part)), &((*rt)->part##Capacity), &((*rt)->part##Count), bytes);
+#define EMIT_INSTRUCTION(rt, part, a, b, c, d) \
+	emitInstruction((void**)(&((*rt)->part)), &((*rt)->part##Capacity), &((*rt)->part##Count), a, b, c, d);
 
 static void emitToJumpTable(Toy_Routine** rt, unsigned int startAddr) {
 	EMIT_INT(rt, code, (*rt)->jumpsCount); //mark the jump index in the code
 	EMIT_INT(rt, jumps, startAddr); //save address at the jump index
 }
 
+//returns the matching slot, or the empty one where it belongs
+static Toy_RoutineString* findRoutineString(Toy_Routine* rt, unsigned int hash, const char* cstring, unsigned int length) {
+	unsigned int mask = rt->stringsCapacity - 1;
+
+	for (unsigned int i = hash & mask; ; i = (i + 1) & mask) {
+		Toy_RoutineString* slot = &rt->strings[i];
+
+		if (slot->jump == 0) {
+			return slot;
+		}
+
+		//the stored copy is null-terminated, so it can't be read past
+		if (slot->hash == hash && strncmp((const char*)(rt->data + rt->jumps[(slot->jump - 1) / 4]), cstring, length + 1) == 0) {
+			return slot;
+		}
+	}
+}
+
+static void growRoutineStrings(Toy_Routine* rt) {
+	unsigned int oldCapacity = rt->stringsCapacity;
+	Toy_RoutineString* oldStrings = rt->strings;
+
+	rt->stringsCapacity = oldCapacity < 16 ? 16 : oldCapacity * 2;
+	rt->strings = calloc(rt->stringsCapacity, sizeof(Toy_RoutineString));
+
+	if (rt->strings == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate %d space for the strings of 'Toy_Routine'\n" TOY_CC_RESET, (int)(rt->stringsCapacity));
+		exit(1);
+	}
+
+	//the entries are already unique, so only an empty slot is needed
+	unsigned int mask = rt->stringsCapacity - 1;
+	for (unsigned int i = 0; i < oldCapacity; i++) {
+		if (oldStrings[i].jump != 0) {
+			unsigned int j = oldStrings[i].hash & mask;
+			while (rt->strings[j].jump != 0) {
+				j = (j + 1) & mask;
+			}
+			rt->strings[j] = oldStrings[i];
+		}
+	}
+
+	free(oldStrings);
+}
+
 static unsigned int emitString(Toy_Routine** rt, Toy_String* str) {
+	//grab the raw characters
+	char* buffer = NULL;
+	const char* cstring = NULL;
+
+	if (str->type == TOY_STRING_NODE) {
+		buffer = Toy_getStringRawBuffer(str);
+		cstring = buffer;
+	}
+	else if (str->type == TOY_STRING_LEAF) {
+		cstring = str->as.leaf.data;
+	}
+	else if (str->type == TOY_STRING_NAME) {
+		cstring = str->as.name.data;
+	}
+
+	//keep the load factor at or below one half
+	if (((*rt)->stringsCount + 1) * 2 > (*rt)->stringsCapacity) {
+		growRoutineStrings(*rt);
+	}
+
+	unsigned int hash = Toy_hashString(str);
+	Toy_RoutineString* slot = findRoutineString(*rt, hash, cstring, str->length);
+
+	//a repeat shares the first copy's jump index
+	if (slot->jump != 0) {
+		EMIT_INT(rt, code, slot->jump - 1);
+		free(buffer);
+		return 1;
+	}
+
+	slot->hash = hash;
+	slot->jump = (*rt)->jumpsCount + 1;
+	(*rt)->stringsCount++;
+
 	//4-byte alignment
 	unsigned int length = str->length + 1;
 	if (length % 4 != 0) {
@@ -68,22 +152,13 @@ static unsigned int emitString(Toy_Routine** rt, Toy_String* str) {
 	//grab the current start address
 	unsigned int startAddr = (*rt)->dataCount;
 
-	//move the string into the data section
+	//move the string into the data section, zeroing the padding so the output is deterministic
 	expand((void**)(&((*rt)->data)), &((*rt)->dataCapacity), &((*rt)->dataCount), length);
-
-	if (str->type == TOY_STRING_NODE) {
-		char* buffer = Toy_getStringRawBuffer(str);
-		memcpy((*rt)->data + (*rt)->dataCount, buffer, str->length + 1);
-		free(buffer);
-	}
-	else if (str->type == TOY_STRING_LEAF) {
-		memcpy((*rt)->data + (*rt)->dataCount, str->as.leaf.data, str->length + 1);
-	}
-	else if (str->type == TOY_STRING_NAME) {
-		memcpy((*rt)->data + (*rt)->dataCount, str->as.name.data, str->length + 1);
-	}
+	memset((*rt)->data + (*rt)->dataCount, 0, length);
+	memcpy((*rt)->data + (*rt)->dataCount, cstring, str->length + 1);
 
 	(*rt)->dataCount += length;
+	free(buffer);
 
 	//mark the jump position
 	emitToJumpTable(rt, startAddr);
@@ -213,10 +288,7 @@ static unsigned int writeInstructionCompare(Toy_Routine** rt, Toy_AstCompare ast
 		EMIT_BYTE(rt, code,TOY_OPCODE_COMPARE_EQUAL);
 	}
 	else if (ast.flag == TOY_AST_FLAG_COMPARE_NOT) {
-		EMIT_BYTE(rt, code,TOY_OPCODE_COMPARE_EQUAL);
-		EMIT_BYTE(rt, code,TOY_OPCODE_NEGATE); //squeezed
-		EMIT_BYTE(rt, code,0);
-		EMIT_BYTE(rt, code,0);
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_COMPARE_EQUAL, TOY_OPCODE_NEGATE, 0, 0); //squeezed
 
 		return 1;
 	}
@@ -311,15 +383,28 @@ static unsigned int writeInstructionPrint(Toy_Routine** rt, Toy_AstPrint ast) {
 	return 0;
 }
 
+static unsigned int writeInstructionYield(Toy_Routine** rt, Toy_AstYield ast) {
+	//the value handed to the host
+	writeRoutineCode(rt, ast.child);
+
+	//output the yield opcode
+	EMIT_BYTE(rt, code,TOY_OPCODE_YIELD);
+
+	//4-byte alignment
+	EMIT_BYTE(rt, code,0);
+	EMIT_BYTE(rt, code,0);
+	EMIT_BYTE(rt, code,0);
+
+	return 0;
+}
+
 static unsigned int writeInstructionVarDeclare(Toy_Routine** rt, Toy_AstVarDeclare ast) {
 	//initial value
 	writeRoutineCode(rt, ast.expr);
 
 	//delcare with the given name string
-	EMIT_BYTE(rt, code, TOY_OPCODE_DECLARE);
-	EMIT_BYTE(rt, code, Toy_getNameStringType(ast.name));
-	EMIT_BYTE(rt, code, ast.name->length); //quick optimisation to skip a 'strlen()' call
-	EMIT_BYTE(rt, code, Toy_getNameStringConstant(ast.name) ? 1 : 0); //check for constness
+	//the length is a quick optimisation to skip a 'strlen()' call, then check for constness
+	EMIT_INSTRUCTION(rt, code, TOY_OPCODE_DECLARE, Toy_getNameStringType(ast.name), ast.name->length, Toy_getNameStringConstant(ast.name) ? 1 : 0);
 
 	emitString(rt, ast.name);
 
@@ -331,10 +416,7 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 
 	//name, duplicate, right, opcode
 	if (ast.flag == TOY_AST_FLAG_ASSIGN) {
-		EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-		EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-		EMIT_BYTE(rt, code, TOY_STRING_NAME);
-		EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_READ, TOY_VALUE_STRING, TOY_STRING_NAME, ast.name->length); //store the length (max 255)
 
 		emitString(rt, ast.name);
 		result += writeRoutineCode(rt, ast.expr);
@@ -343,17 +425,11 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 		EMIT_BYTE(rt, code, 0);
 	}
 	else if (ast.flag == TOY_AST_FLAG_ADD_ASSIGN) {
-		EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-		EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-		EMIT_BYTE(rt, code, TOY_STRING_NAME);
-		EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_READ, TOY_VALUE_STRING, TOY_STRING_NAME, ast.name->length); //store the length (max 255)
 
 		emitString(rt, ast.name);
 
-		EMIT_BYTE(rt, code,TOY_OPCODE_DUPLICATE);
-		EMIT_BYTE(rt, code,TOY_OPCODE_ACCESS); //squeezed
-		EMIT_BYTE(rt, code,0);
-		EMIT_BYTE(rt, code,0);
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_DUPLICATE, TOY_OPCODE_ACCESS, 0, 0); //squeezed
 
 		result += writeRoutineCode(rt, ast.expr);
 
@@ -361,17 +437,11 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 		EMIT_BYTE(rt, code,TOY_OPCODE_ASSIGN); //squeezed
 	}
 	else if (ast.flag == TOY_AST_FLAG_SUBTRACT_ASSIGN) {
-		EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-		EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-		EMIT_BYTE(rt, code, TOY_STRING_NAME);
-		EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_READ, TOY_VALUE_STRING, TOY_STRING_NAME, ast.name->length); //store the length (max 255)
 
 		emitString(rt, ast.name);
 
-		EMIT_BYTE(rt, code,TOY_OPCODE_DUPLICATE);
-		EMIT_BYTE(rt, code,TOY_OPCODE_ACCESS); //squeezed
-		EMIT_BYTE(rt, code,0);
-		EMIT_BYTE(rt, code,0);
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_DUPLICATE, TOY_OPCODE_ACCESS, 0, 0); //squeezed
 
 		result += writeRoutineCode(rt, ast.expr);
 
@@ -379,17 +449,11 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 		EMIT_BYTE(rt, code,TOY_OPCODE_ASSIGN); //squeezed
 	}
 	else if (ast.flag == TOY_AST_FLAG_MULTIPLY_ASSIGN) {
-		EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-		EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-		EMIT_BYTE(rt, code, TOY_STRING_NAME);
-		EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_READ, TOY_VALUE_STRING, TOY_STRING_NAME, ast.name->length); //store the length (max 255)
 
 		emitString(rt, ast.name);
 
-		EMIT_BYTE(rt, code,TOY_OPCODE_DUPLICATE);
-		EMIT_BYTE(rt, code,TOY_OPCODE_ACCESS); //squeezed
-		EMIT_BYTE(rt, code,0);
-		EMIT_BYTE(rt, code,0);
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_DUPLICATE, TOY_OPCODE_ACCESS, 0, 0); //squeezed
 
 		result += writeRoutineCode(rt, ast.expr);
 
@@ -397,17 +461,11 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 		EMIT_BYTE(rt, code,TOY_OPCODE_ASSIGN); //squeezed
 	}
 	else if (ast.flag == TOY_AST_FLAG_DIVIDE_ASSIGN) {
-		EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-		EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-		EMIT_BYTE(rt, code, TOY_STRING_NAME);
-		EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_READ, TOY_VALUE_STRING, TOY_STRING_NAME, ast.name->length); //store the length (max 255)
 
 		emitString(rt, ast.name);
 
-		EMIT_BYTE(rt, code,TOY_OPCODE_DUPLICATE);
-		EMIT_BYTE(rt, code,TOY_OPCODE_ACCESS); //squeezed
-		EMIT_BYTE(rt, code,0);
-		EMIT_BYTE(rt, code,0);
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_DUPLICATE, TOY_OPCODE_ACCESS, 0, 0); //squeezed
 
 		result += writeRoutineCode(rt, ast.expr);
 
@@ -415,17 +473,11 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 		EMIT_BYTE(rt, code,TOY_OPCODE_ASSIGN); //squeezed
 	}
 	else if (ast.flag == TOY_AST_FLAG_MODULO_ASSIGN) {
-		EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-		EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-		EMIT_BYTE(rt, code, TOY_STRING_NAME);
-		EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_READ, TOY_VALUE_STRING, TOY_STRING_NAME, ast.name->length); //store the length (max 255)
 
 		emitString(rt, ast.name);
 
-		EMIT_BYTE(rt, code,TOY_OPCODE_DUPLICATE);
-		EMIT_BYTE(rt, code,TOY_OPCODE_ACCESS); //squeezed
-		EMIT_BYTE(rt, code,0);
-		EMIT_BYTE(rt, code,0);
+		EMIT_INSTRUCTION(rt, code, TOY_OPCODE_DUPLICATE, TOY_OPCODE_ACCESS, 0, 0); //squeezed
 
 		result += writeRoutineCode(rt, ast.expr);
 
@@ -446,20 +498,11 @@ static unsigned int writeInstructionAssign(Toy_Routine** rt, Toy_AstVarAssign as
 }
 
 static unsigned int writeInstructionAccess(Toy_Routine** rt, Toy_AstVarAccess ast) {
-	//push the name
-	EMIT_BYTE(rt, code, TOY_OPCODE_READ);
-	EMIT_BYTE(rt, code, TOY_VALUE_STRING);
-	EMIT_BYTE(rt, code, TOY_STRING_NAME);
-	EMIT_BYTE(rt, code, ast.name->length); //store the length (max 255)
+	//the name is read straight from the data section, so accessing never builds a string
+	EMIT_INSTRUCTION(rt, code, TOY_OPCODE_ACCESS, ast.name->length, 0, 0); //store the length (max 255)
 
 	emitString(rt, ast.name);
 
-	//convert name to value
-	EMIT_BYTE(rt, code, TOY_OPCODE_ACCESS);
-	EMIT_BYTE(rt, code,0);
-	EMIT_BYTE(rt, code,0);
-	EMIT_BYTE(rt, code,0);
-
 	return 1;
 }
 
@@ -479,20 +522,16 @@ static unsigned int writeRoutineCode(Toy_Routine** rt, Toy_Ast* ast) {
 	switch(ast->type) {
 		case TOY_AST_BLOCK:
 			if (ast->block.innerScope) {
-				EMIT_BYTE(rt, code, TOY_OPCODE_SCOPE_PUSH);
-				EMIT_BYTE(rt, code, 0);
-				EMIT_BYTE(rt, code, 0);
-				EMIT_BYTE(rt, code, 0);
+				EMIT_INSTRUCTION(rt, code, TOY_OPCODE_SCOPE_PUSH, 0, 0, 0);
 			}
 
-			result += writeRoutineCode(rt, ast->block.child);
-			result += writeRoutineCode(rt, ast->block.next);
+			//walk the chain instead of recursing into 'next', so long scripts can't overflow the stack
+			for (Toy_Ast* iter = ast; iter != NULL; iter = iter->block.next) {
+				result += writeRoutineCode(rt, iter->block.child);
+			}
 
 			if (ast->block.innerScope) {
-				EMIT_BYTE(rt, code, TOY_OPCODE_SCOPE_POP);
-				EMIT_BYTE(rt, code, 0);
-				EMIT_BYTE(rt, code, 0);
-				EMIT_BYTE(rt, code, 0);
+				EMIT_INSTRUCTION(rt, code, TOY_OPCODE_SCOPE_POP, 0, 0, 0);
 			}
 			break;
 
@@ -528,6 +567,10 @@ static unsigned int writeRoutineCode(Toy_Routine** rt, Toy_Ast* ast) {
 			result += writeInstructionPrint(rt, ast->print);
 			break;
 
+		case TOY_AST_YIELD:
+			result += writeInstructionYield(rt, ast->yield);
+			break;
+
 		case TOY_AST_VAR_DECLARE:
 			result += writeInstructionVarDeclare(rt, ast->varDeclare);
 			break;
@@ -561,89 +604,176 @@ static unsigned int writeRoutineCode(Toy_Routine** rt, Toy_Ast* ast) {
 	return result;
 }
 
-static void* writeRoutine(Toy_Routine* rt, Toy_Ast* ast) {
+static void emitVarint(void** handle, unsigned int* capacity, unsigned int* count, unsigned int value) {
+	while (value >= 0x80) {
+		emitByte(handle, capacity, count, (value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	emitByte(handle, capacity, count, value);
+}
+
+//the second word of the two-word instructions, which are never the last in the code section
+static unsigned int readOperand(Toy_Routine* rt, unsigned int pc) {
+	unsigned int operand = 0;
+
+	if (pc + 8 <= rt->codeCount) {
+		memcpy(&operand, rt->code + pc + 4, sizeof(operand));
+	}
+
+	return operand;
+}
+
+//rewrites the finished code section in the dense encoding, see toy_routine.h
+static void densifyRoutineCode(Toy_Routine* rt) {
+	void* buffer = NULL;
+	unsigned int capacity = 0, count = 0;
+
+	unsigned int pc = 0;
+	while (pc < rt->codeCount) {
+		unsigned char* instruction = rt->code + pc;
+
+		emitByte(&buffer, &capacity, &count, instruction[0]);
+
+		switch(instruction[0]) {
+			case TOY_OPCODE_READ:
+				emitByte(&buffer, &capacity, &count, instruction[1]);
+
+				switch(instruction[1]) {
+					case TOY_VALUE_BOOLEAN:
+						emitByte(&buffer, &capacity, &count, instruction[2]);
+						pc += 4;
+						break;
+
+					case TOY_VALUE_INTEGER: {
+						//zigzag, so small negatives stay short
+						unsigned int operand = readOperand(rt, pc);
+						emitVarint(&buffer, &capacity, &count, (operand << 1) ^ (unsigned int)((int)operand >> 31));
+						pc += 8;
+						break;
+					}
+
+					case TOY_VALUE_FLOAT:
+						emitInt(&buffer, &capacity, &count, readOperand(rt, pc));
+						pc += 8;
+						break;
+
+					case TOY_VALUE_STRING:
+						emitByte(&buffer, &capacity, &count, instruction[2]);
+						emitByte(&buffer, &capacity, &count, instruction[3]);
+						emitVarint(&buffer, &capacity, &count, readOperand(rt, pc) / 4);
+						pc += 8;
+						break;
+
+					default:
+						pc += 4;
+						break;
+				}
+				break;
+
+			case TOY_OPCODE_DECLARE:
+				emitByte(&buffer, &capacity, &count, instruction[1]);
+				emitByte(&buffer, &capacity, &count, instruction[2]);
+				emitByte(&buffer, &capacity, &count, instruction[3]);
+				emitVarint(&buffer, &capacity, &count, readOperand(rt, pc) / 4);
+				pc += 8;
+				break;
+
+			case TOY_OPCODE_ACCESS:
+				emitByte(&buffer, &capacity, &count, instruction[1]);
+				emitVarint(&buffer, &capacity, &count, readOperand(rt, pc) / 4);
+				pc += 8;
+				break;
+
+			case TOY_OPCODE_DUPLICATE:
+			case TOY_OPCODE_ADD:
+			case TOY_OPCODE_SUBTRACT:
+			case TOY_OPCODE_MULTIPLY:
+			case TOY_OPCODE_DIVIDE:
+			case TOY_OPCODE_MODULO:
+			case TOY_OPCODE_COMPARE_EQUAL:
+			case TOY_OPCODE_ASSERT:
+			case TOY_OPCODE_INDEX:
+				emitByte(&buffer, &capacity, &count, instruction[1]);
+				pc += 4;
+				break;
+
+			default:
+				pc += 4;
+				break;
+		}
+	}
+
+	//4-byte alignment for the sections that follow
+	while (count % 4 != 0) {
+		emitByte(&buffer, &capacity, &count, 0);
+	}
+
+	free(rt->code);
+	rt->code = buffer;
+	rt->codeCapacity = capacity;
+	rt->codeCount = count;
+}
+
+static void writeRoutine(Toy_Routine* rt, Toy_Ast* ast, bool dense, void** handle, unsigned int* capacity, unsigned int* count) {
 	//build the routine's parts
 	//TODO: param
 	//code
 	writeRoutineCode(&rt, ast);
-	EMIT_BYTE(&rt, code, TOY_OPCODE_RETURN); //temp terminator
-	EMIT_BYTE(&rt, code, 0); //4-byte alignment
-	EMIT_BYTE(&rt, code, 0);
-	EMIT_BYTE(&rt, code, 0);
+	EMIT_INSTRUCTION(&rt, code, TOY_OPCODE_RETURN, 0, 0, 0); //temp terminator
 
-	//write the header and combine the parts
-	void* buffer = NULL;
-	unsigned int capacity = 0, count = 0;
-	// int paramAddr = 0, codeAddr = 0, subsAddr = 0;
-	int codeAddr = 0;
-	int jumpsAddr = 0;
-	int dataAddr = 0;
-
-	emitInt(&buffer, &capacity, &count, 0); //total size (overwritten later)
-	emitInt(&buffer, &capacity, &count, rt->paramCount); //param size
-	emitInt(&buffer, &capacity, &count, rt->jumpsCount); //jumps size
-	emitInt(&buffer, &capacity, &count, rt->dataCount); //data size
-	emitInt(&buffer, &capacity, &count, rt->subsCount); //routine size
-
-	//generate blank spaces, cache their positions in the *Addr variables (for storing the start positions)
+	if (dense) {
+		densifyRoutineCode(rt);
+	}
+
+	//the parts are finished, so the whole routine can be sized before it's written
+	unsigned int headerSize = 20;
+	headerSize += rt->paramCount > 0 ? 4 : 0;
+	headerSize += rt->codeCount > 0 ? 4 : 0;
+	headerSize += rt->jumpsCount > 0 ? 4 : 0;
+	headerSize += rt->dataCount > 0 ? 4 : 0;
+	headerSize += rt->subsCount > 0 ? 4 : 0;
+
+	unsigned int codeAddr = headerSize;
+	unsigned int jumpsAddr = codeAddr + rt->codeCount;
+	unsigned int dataAddr = jumpsAddr + rt->jumpsCount;
+	unsigned int totalSize = dataAddr + rt->dataCount;
+
+	//grow the destination once, so nothing below reallocates
+	expand(handle, capacity, count, totalSize);
+
+	//write the header
+	emitInt(handle, capacity, count, totalSize | (dense ? TOY_ROUTINE_FLAG_DENSE : 0)); //total size and encoding
+	emitInt(handle, capacity, count, rt->paramCount); //param size
+	emitInt(handle, capacity, count, rt->jumpsCount); //jumps size
+	emitInt(handle, capacity, count, rt->dataCount); //data size
+	emitInt(handle, capacity, count, rt->subsCount); //routine size
+
+	//the start of each part, relative to the routine
 	if (rt->paramCount > 0) {
-		// paramAddr = count;
-		emitInt((void**)&buffer, &capacity, &count, 0); //params
+		emitInt(handle, capacity, count, 0); //TODO: params
 	}
 	if (rt->codeCount > 0) {
-		codeAddr = count;
-		emitInt((void**)&buffer, &capacity, &count, 0); //code
+		emitInt(handle, capacity, count, codeAddr);
 	}
 	if (rt->jumpsCount > 0) {
-		jumpsAddr = count;
-		emitInt((void**)&buffer, &capacity, &count, 0); //jumps
+		emitInt(handle, capacity, count, jumpsAddr);
 	}
 	if (rt->dataCount > 0) {
-		dataAddr = count;
-		emitInt((void**)&buffer, &capacity, &count, 0); //data
+		emitInt(handle, capacity, count, dataAddr);
 	}
 	if (rt->subsCount > 0) {
-		// subsAddr = count;
-		emitInt((void**)&buffer, &capacity, &count, 0); //subs
+		emitInt(handle, capacity, count, 0); //TODO: subs
 	}
 
 	//append various parts to the buffer
 	//TODO: param region
-
-	if (rt->codeCount > 0) {
-		expand(&buffer, &capacity, &count, rt->codeCount);
-		memcpy((buffer + count), rt->code, rt->codeCount);
-
-		*((int*)(buffer + codeAddr)) = count;
-		count += rt->codeCount;
-	}
-
-	if (rt->jumpsCount > 0) {
-		expand(&buffer, &capacity, &count, rt->jumpsCount);
-		memcpy((buffer + count), rt->jumps, rt->jumpsCount);
-
-		*((int*)(buffer + jumpsAddr)) = count;
-		count += rt->jumpsCount;
-	}
-
-	if (rt->dataCount > 0) {
-		expand(&buffer, &capacity, &count, rt->dataCount);
-		memcpy((buffer + count), rt->data, rt->dataCount);
-
-		*((int*)(buffer + dataAddr)) = count;
-		count += rt->dataCount;
-	}
-
+	emitBytes(handle, capacity, count, rt->code, rt->codeCount);
+	emitBytes(handle, capacity, count, rt->jumps, rt->jumpsCount);
+	emitBytes(handle, capacity, count, rt->data, rt->dataCount);
 	//TODO: subs region
-
-	//finally, record the total size within the header, and return the result
-	*((int*)buffer) = count;
-
-	return buffer;
 }
 
-//exposed functions
-void* Toy_compileRoutine(Toy_Ast* ast) {
+static void compileRoutine(Toy_Ast* ast, bool dense, void** handle, unsigned int* capacity, unsigned int* count) {
 	//setup
 	Toy_Routine rt;
 
@@ -667,9 +797,12 @@ void* Toy_compileRoutine(Toy_Ast* ast) {
 	rt.subsCapacity = 0;
 	rt.subsCount = 0;
 
-	//build
-	void * buffer = writeRoutine(&rt, ast);
+	rt.strings = NULL;
+	rt.stringsCapacity = 0;
+	rt.stringsCount = 0;
 
+	//build
+	writeRoutine(&rt, ast, dense, handle, capacity, count);
 
 	//cleanup the temp object
 	free(rt.param);
@@ -677,6 +810,28 @@ void* Toy_compileRoutine(Toy_Ast* ast) {
 	free(rt.jumps);
 	free(rt.data);
 	free(rt.subs);
+	free(rt.strings);
+}
+
+//exposed functions
+void* Toy_compileRoutine(Toy_Ast* ast) {
+	void* buffer = NULL;
+	unsigned int capacity = 0, count = 0;
+
+	compileRoutine(ast, false, &buffer, &capacity, &count);
 
 	return buffer;
 }
+
+void* Toy_compileDenseRoutine(Toy_Ast* ast) {
+	void* buffer = NULL;
+	unsigned int capacity = 0, count = 0;
+
+	compileRoutine(ast, true, &buffer, &capacity, &count);
+
+	return buffer;
+}
+
+void Toy_private_appendRoutine(Toy_Ast* ast, bool dense, unsigned char** handle, unsigned int* capacity, unsigned int* count) {
+	compileRoutine(ast, dense, (void**)handle, capacity, count);
+}
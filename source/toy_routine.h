@@ -3,6 +3,12 @@
 #include "toy_common.h"
 #include "toy_ast.h"
 
+//one string already in 'data', found by its hash
+typedef struct Toy_RoutineString {
+	unsigned int hash;
+	unsigned int jump; //the jump index + 1, so 0 marks an empty slot
+} Toy_RoutineString;
+
 //internal structure that holds the individual parts of a compiled routine
 typedef struct Toy_Routine {
 	unsigned char* param; //c-string params in sequence (could be moved below the jump table?)
@@ -24,7 +30,26 @@ typedef struct Toy_Routine {
 	unsigned char* subs; //subroutines, recursively
 	unsigned int subsCapacity;
 	unsigned int subsCount;
+
+	Toy_RoutineString* strings; //open addressing, so each unique string is only stored once
+	unsigned int stringsCapacity;
+	unsigned int stringsCount;
 } Toy_Routine;
 
 TOY_API void* Toy_compileRoutine(Toy_Ast* ast);
+TOY_API void* Toy_compileDenseRoutine(Toy_Ast* ast); //same, but with the compact encoding below
+TOY_API void Toy_private_appendRoutine(Toy_Ast* ast, bool dense, unsigned char** handle, unsigned int* capacity, unsigned int* count); //writes straight into an existing buffer, growing it as needed
+
+//a routine's first word is its total size, with the encoding flags in the top bit
+#define TOY_ROUTINE_FLAG_DENSE 0x80000000u
+#define TOY_ROUTINE_SIZE_MASK  0x7FFFFFFFu
+
+//NOTE: the dense encoding drops the padding within the code section, and only keeps the operand bytes each opcode reads:
+//  READ        type, then nothing for null, 1 byte for booleans, a zigzag varint for integers, 4 raw bytes for floats,
+//              or the string type, length and a varint jump slot for strings
+//  DECLARE     type, length, constness and a varint jump slot
+//  ACCESS      length and a varint jump slot
+//  DUPLICATE, ADD to MODULO, COMPARE_EQUAL, ASSERT, INDEX
+//              the one byte they read, either squeezed or a count
+//a jump slot is the jump index divided by 4, and the code section is still padded to a multiple of 4
 
@@ -26,6 +26,17 @@ static Toy_TableEntry* lookupScope(Toy_Scope* scope, Toy_String* key, unsigned i
 		return NULL;
 	}
 
+	//persistent scopes hold their entries in a trie instead
+	if (scope->persistent != NULL) {
+		Toy_TableEntry* entryPtr = Toy_private_findPersistentEntry(&scope->persistent, TOY_VALUE_FROM_STRING(key), false, NULL);
+		return entryPtr == NULL && recursive ? lookupScope(scope->next, key, hash, recursive) : entryPtr;
+	}
+
+	//skip empty scopes without probing
+	if (scope->table == NULL || scope->table->count == 0) {
+		return recursive ? lookupScope(scope->next, key, hash, recursive) : NULL;
+	}
+
 	//copy and modify the code from Toy_lookupTable, so it can behave slightly differently
 	unsigned int probe = hash % scope->table->capacity;
 
@@ -45,12 +56,98 @@ static Toy_TableEntry* lookupScope(Toy_Scope* scope, Toy_String* key, unsigned i
 	}
 }
 
+//copy-on-write: give the scope its own table before it's modified
+static void ensureUniqueTable(Toy_Scope* scope) {
+	if (scope->table == NULL || scope->table->refCount <= 1) {
+		return;
+	}
+
+	//same capacity means the same layout, so the contents can be copied wholesale instead of rehashed
+	Toy_Table* table = Toy_allocateTableFromPool(scope->pool, scope->table->capacity);
+	memcpy(table, scope->table, sizeof(Toy_Table) + scope->table->capacity * sizeof(Toy_TableEntry));
+	table->refCount = 1;
+
+	//both tables now hold the contents
+	unsigned int iterator = 0;
+	for (Toy_TableEntry* entry = Toy_iterateTable(table, &iterator); entry != NULL; entry = Toy_iterateTable(table, &iterator)) {
+		entry->key = Toy_copyValue(entry->key);
+		entry->value = Toy_copyValue(entry->value);
+	}
+
+	scope->table->refCount--;
+	scope->table = table;
+}
+
+static void releaseTable(Toy_Scope* scope) {
+	if (scope->persistent != NULL) {
+		Toy_freePersistentTable(scope->persistent); //the nodes are freed once no copy still uses them
+		scope->persistent = NULL;
+	}
+	else if (scope->table != NULL && scope->table->refCount > 1) {
+		scope->table->refCount--; //still used by a copy
+	}
+	else {
+		Toy_releaseTableToPool(scope->pool, scope->table);
+	}
+
+	scope->table = NULL;
+}
+
+//like lookupScope, but reports how long the entry can be written through, and copies it first if it's shared
+static Toy_TableEntry* lookupScopeWithOwner(Toy_Scope* scope, Toy_String* key, unsigned int hash, bool forWrite, Toy_ScopeGuard* guard) {
+	for (Toy_Scope* iter = scope; iter; iter = iter->next) {
+		//only the path to the entry is copied, and copies bump the version
+		if (iter->persistent != NULL) {
+			bool copied = false;
+			Toy_TableEntry* entryPtr = Toy_private_findPersistentEntry(&iter->persistent, TOY_VALUE_FROM_STRING(key), forWrite, &copied);
+
+			if (entryPtr == NULL) {
+				continue;
+			}
+
+			if (guard != NULL) {
+				guard->counter = forWrite ? &iter->persistent->version : NULL; //found for reading, the path may still be shared
+				guard->value = iter->persistent->version;
+				guard->copied = copied;
+			}
+
+			return entryPtr;
+		}
+
+		Toy_TableEntry* entryPtr = lookupScope(iter, key, hash, false);
+
+		if (entryPtr == NULL) {
+			continue;
+		}
+
+		bool copied = forWrite && iter->table->refCount > 1;
+
+		if (copied) {
+			ensureUniqueTable(iter);
+			entryPtr = lookupScope(iter, key, hash, false);
+		}
+
+		//the whole table is copied, so it's unshared while its refCount is 1
+		if (guard != NULL) {
+			guard->counter = &iter->table->refCount;
+			guard->value = 1;
+			guard->copied = copied;
+		}
+
+		return entryPtr;
+	}
+
+	return NULL;
+}
+
 //exposed functions
 Toy_Scope* Toy_pushScope(Toy_Bucket** bucketHandle, Toy_Scope* scope) {
 	Toy_Scope* newScope = Toy_partitionBucket(bucketHandle, sizeof(Toy_Scope));
 
 	newScope->next = scope;
-	newScope->table = Toy_allocateTable();
+	newScope->table = NULL; //blocks without declarations never need a table
+	newScope->persistent = NULL;
+	newScope->pool = scope != NULL ? scope->pool : NULL;
 	newScope->refCount = 0;
 
 	incrementRefCount(newScope);
@@ -58,6 +155,12 @@ Toy_Scope* Toy_pushScope(Toy_Bucket** bucketHandle, Toy_Scope* scope) {
 	return newScope;
 }
 
+Toy_Scope* Toy_pushPersistentScope(Toy_Bucket** bucketHandle, Toy_Scope* scope) {
+	Toy_Scope* newScope = Toy_pushScope(bucketHandle, scope);
+	newScope->persistent = Toy_allocatePersistentTable();
+	return newScope;
+}
+
 Toy_Scope* Toy_popScope(Toy_Scope* scope) {
 	if (scope == NULL) {
 		return NULL;
@@ -66,34 +169,33 @@ Toy_Scope* Toy_popScope(Toy_Scope* scope) {
 	decrementRefCount(scope);
 
 	if (scope->refCount == 0) {
-		Toy_freeTable(scope->table);
-		scope->table = NULL;
+		releaseTable(scope);
 	}
 
 	return scope->next;
 }
 
 Toy_Scope* Toy_deepCopyScope(Toy_Bucket** bucketHandle, Toy_Scope* scope) {
-	//copy/pasted from pushScope, so I can allocate the table manually
+	//copy/pasted from pushScope, so I can share the table
 	Toy_Scope* newScope = Toy_partitionBucket(bucketHandle, sizeof(Toy_Scope));
 
 	newScope->next = scope->next;
-	newScope->table = Toy_private_adjustTableCapacity(NULL, scope->table->capacity);
+	newScope->table = scope->table;
+	newScope->persistent = scope->persistent != NULL ? Toy_copyPersistentTable(scope->persistent) : NULL;
+	newScope->pool = scope->pool;
 	newScope->refCount = 0;
 
 	incrementRefCount(newScope);
 
-	//forcibly copy the contents
-	for (int i = 0; i < scope->table->capacity; i++) {
-		if (!TOY_VALUE_IS_NULL(scope->table->data[i].key)) {
-			Toy_insertTable(&newScope->table, scope->table->data[i].key, scope->table->data[i].value);
-		}
+	//the table is only copied when either scope modifies it
+	if (newScope->table != NULL) {
+		newScope->table->refCount++;
 	}
 
 	return newScope;
 }
 
-void Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
+bool Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
 	if (key->type != TOY_STRING_NAME) {
 		fprintf(stderr, TOY_CC_ERROR "ERROR: Toy_Scope only allows name strings as keys\n" TOY_CC_RESET);
 		exit(-1);
@@ -105,7 +207,7 @@ void Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
 		char buffer[key->length + 256];
 		sprintf(buffer, "Can't redefine a variable: %s", key->as.name.data);
 		Toy_error(buffer);
-		return;
+		return false;
 	}
 
 	//type check
@@ -114,7 +216,7 @@ void Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
 		char buffer[key->length + 256];
 		sprintf(buffer, "Incorrect value type assigned to in variable declaration '%s' (expected %d, got %d)", key->as.name.data, (int)kt, (int)value.type);
 		Toy_error(buffer);
-		return;
+		return false;
 	}
 
 	//constness check
@@ -122,45 +224,43 @@ void Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
 		char buffer[key->length + 256];
 		sprintf(buffer, "Can't declare %s as const with value 'null'", key->as.name.data);
 		Toy_error(buffer);
-		return;
+		return false;
+	}
+
+	//only the path to the new entry is copied, if it's shared
+	if (scope->persistent != NULL) {
+		Toy_insertPersistentTable(&scope->persistent, TOY_VALUE_FROM_STRING(Toy_copyString(key)), value);
+		return true;
+	}
+
+	if (scope->table == NULL) {
+		scope->table = Toy_allocateTableFromPool(scope->pool, TOY_TABLE_INITIAL_CAPACITY);
+	}
+	else {
+		ensureUniqueTable(scope);
 	}
 
 	Toy_insertTable(&scope->table, TOY_VALUE_FROM_STRING(Toy_copyString(key)), value);
+
+	return true;
 }
 
-void Toy_assignScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
+bool Toy_assignScope(Toy_Scope* scope, Toy_String* key, Toy_Value value) {
 	if (key->type != TOY_STRING_NAME) {
 		fprintf(stderr, TOY_CC_ERROR "ERROR: Toy_Scope only allows name strings as keys\n" TOY_CC_RESET);
 		exit(-1);
 	}
 
-	Toy_TableEntry* entryPtr = lookupScope(scope, key, Toy_hashString(key), true);
+	Toy_TableEntry* entryPtr = lookupScopeWithOwner(scope, key, Toy_hashString(key), true, NULL);
 
 	if (entryPtr == NULL) {
 		char buffer[key->length + 256];
 		sprintf(buffer, "Undefined variable: %s", key->as.name.data);
 		Toy_error(buffer);
-		return;
-	}
-
-	//type check
-	Toy_ValueType kt = Toy_getNameStringType( TOY_VALUE_AS_STRING(entryPtr->key) );
-	if (kt != TOY_VALUE_ANY && value.type != TOY_VALUE_NULL && kt != value.type) {
-		char buffer[key->length + 256];
-		sprintf(buffer, "Incorrect value type assigned to in variable assignment '%s' (expected %d, got %d)", key->as.name.data, (int)kt, (int)value.type);
-		Toy_error(buffer);
-		return;
+		return false;
 	}
 
-	//constness check
-	if (Toy_getNameStringConstant( TOY_VALUE_AS_STRING(entryPtr->key) )) {
-		char buffer[key->length + 256];
-		sprintf(buffer, "Can't assign to const %s", key->as.name.data);
-		Toy_error(buffer);
-		return;
-	}
-
-	entryPtr->value = value;
+	return Toy_private_assignScopeEntry(entryPtr, key, value);
 }
 
 Toy_Value Toy_accessScope(Toy_Scope* scope, Toy_String* key) {
@@ -181,6 +281,33 @@ Toy_Value Toy_accessScope(Toy_Scope* scope, Toy_String* key) {
 	return entryPtr->value;
 }
 
+Toy_TableEntry* Toy_private_findScopeEntry(Toy_Scope* scope, Toy_String* key, bool forWrite, Toy_ScopeGuard* guard) {
+	return lookupScopeWithOwner(scope, key, Toy_hashString(key), forWrite, guard);
+}
+
+bool Toy_private_assignScopeEntry(Toy_TableEntry* entryPtr, Toy_String* key, Toy_Value value) {
+	//type check
+	Toy_ValueType kt = Toy_getNameStringType( TOY_VALUE_AS_STRING(entryPtr->key) );
+	if (kt != TOY_VALUE_ANY && value.type != TOY_VALUE_NULL && kt != value.type) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Incorrect value type assigned to in variable assignment '%s' (expected %d, got %d)", key->as.name.data, (int)kt, (int)value.type);
+		Toy_error(buffer);
+		return false;
+	}
+
+	//constness check
+	if (Toy_getNameStringConstant( TOY_VALUE_AS_STRING(entryPtr->key) )) {
+		char buffer[key->length + 256];
+		sprintf(buffer, "Can't assign to const %s", key->as.name.data);
+		Toy_error(buffer);
+		return false;
+	}
+
+	entryPtr->value = value;
+
+	return true;
+}
+
 bool Toy_isDeclaredScope(Toy_Scope* scope, Toy_String* key) {
 	if (key->type != TOY_STRING_NAME) {
 		fprintf(stderr, TOY_CC_ERROR "ERROR: Toy_Scope only allows name strings as keys\n" TOY_CC_RESET);
@@ -6,11 +6,14 @@
 #include "toy_value.h"
 #include "toy_string.h"
 #include "toy_table.h"
+#include "toy_persistent_table.h"
 
 //wraps Toy_Table, restricting keys to name strings, and handles scopes as a linked list
 typedef struct Toy_Scope {
 	struct Toy_Scope* next;
-	Toy_Table* table;
+	Toy_Table* table; //allocated on the first declaration
+	Toy_PersistentTable* persistent; //used instead of the table by persistent scopes
+	Toy_TablePool* pool; //inherited from the parent scope, can be NULL
 	unsigned int refCount;
 } Toy_Scope;
 
@@ -18,11 +21,27 @@ typedef struct Toy_Scope {
 TOY_API Toy_Scope* Toy_pushScope(Toy_Bucket** bucketHandle, Toy_Scope* scope);
 TOY_API Toy_Scope* Toy_popScope(Toy_Scope* scope);
 
+//backed by a persistent table instead, for warmed state that's copied many times; lookups are slower, but modifying a copy only copies the path to the entry
+//to fork a VM's globals, install one as its top scope before binding it
+TOY_API Toy_Scope* Toy_pushPersistentScope(Toy_Bucket** bucketHandle, Toy_Scope* scope);
+
+//O(1) - the copy shares the table until either scope modifies it, or shares the trie and copies paths for persistent scopes
 TOY_API Toy_Scope* Toy_deepCopyScope(Toy_Bucket** bucketHandle, Toy_Scope* scope);
 
-//manage the contents
-TOY_API void Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value);
-TOY_API void Toy_assignScope(Toy_Scope* scope, Toy_String* key, Toy_Value value);
+//manage the contents - these return false after reporting an error through Toy_error()
+TOY_API bool Toy_declareScope(Toy_Scope* scope, Toy_String* key, Toy_Value value);
+TOY_API bool Toy_assignScope(Toy_Scope* scope, Toy_String* key, Toy_Value value);
 TOY_API Toy_Value Toy_accessScope(Toy_Scope* scope, Toy_String* key);
 
 TOY_API bool Toy_isDeclaredScope(Toy_Scope* scope, Toy_String* key);
+
+//NOTE: exposed for the VM's inline caches, which hold onto the entries between instructions
+//an entry can be written through while '*counter == value', otherwise it may be shared with a copied scope
+typedef struct Toy_ScopeGuard {
+	const unsigned int* counter; //NULL if the entry can't be written through
+	unsigned int value;
+	bool copied; //finding the entry for writing copied it out of a shared table or path
+} Toy_ScopeGuard;
+
+TOY_API Toy_TableEntry* Toy_private_findScopeEntry(Toy_Scope* scope, Toy_String* key, bool forWrite, Toy_ScopeGuard* guard); //NULL if undeclared, writes copy a shared table or path first
+TOY_API bool Toy_private_assignScopeEntry(Toy_TableEntry* entryPtr, Toy_String* key, Toy_Value value); //type and const checks
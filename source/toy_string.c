@@ -117,6 +117,21 @@ Toy_String* Toy_createNameStringLength(Toy_Bucket** bucketHandle, const char* cn
 	return ret;
 }
 
+Toy_String* Toy_private_initNameStringInBuffer(void* buffer, const char* cname, unsigned int length) {
+	Toy_String* ret = (Toy_String*)buffer;
+
+	ret->type = TOY_STRING_NAME;
+	ret->length = length;
+	ret->refCount = 1;
+	ret->cachedHash = 0;
+	memcpy(ret->as.name.data, cname, length);
+	ret->as.name.data[length] = '\0';
+	ret->as.name.type = TOY_VALUE_UNKNOWN;
+	ret->as.name.constant = false;
+
+	return ret;
+}
+
 Toy_String* Toy_copyString(Toy_String* str) {
 	if (str->refCount == 0) {
 		fprintf(stderr, TOY_CC_ERROR "ERROR: Can't copy a string with refcount of zero\n" TOY_CC_RESET);
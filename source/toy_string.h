@@ -41,6 +41,9 @@ TOY_API Toy_String* Toy_createStringLength(Toy_Bucket** bucketHandle, const char
 
 TOY_API Toy_String* Toy_createNameStringLength(Toy_Bucket** bucketHandle, const char* cname, unsigned int length, Toy_ValueType type, bool constant); //for variable names
 
+//NOTE: exposed for the VM, to look up names without allocating; the buffer needs room for 'sizeof(Toy_String) + length + 1' bytes
+TOY_API Toy_String* Toy_private_initNameStringInBuffer(void* buffer, const char* cname, unsigned int length);
+
 TOY_API Toy_String* Toy_copyString(Toy_String* str);
 TOY_API Toy_String* Toy_deepCopyString(Toy_Bucket** bucketHandle, Toy_String* str);
 
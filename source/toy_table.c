@@ -52,6 +52,49 @@ static void probeAndInsert(Toy_Table** tableHandle, Toy_Value key, Toy_Value val
 	}
 }
 
+static unsigned int calcCapacityForCount(unsigned int count) {
+	//find the smallest capacity that won't immediately expand on the next insert
+	unsigned int capacity = TOY_TABLE_INITIAL_CAPACITY;
+
+	while (count >= capacity * TOY_TABLE_EXPANSION_THRESHOLD) {
+		capacity *= TOY_TABLE_EXPANSION_RATE;
+	}
+
+	return capacity;
+}
+
+//finds the pool's index for a capacity, or -1 if it's not kept
+static int calcPoolIndex(unsigned int capacity) {
+	unsigned int c = TOY_TABLE_INITIAL_CAPACITY;
+
+	for (int i = 0; i < TOY_TABLE_POOL_CAPACITIES; i++) {
+		if (c == capacity) {
+			return i;
+		}
+		c *= TOY_TABLE_EXPANSION_RATE;
+	}
+
+	return -1;
+}
+
+//used by Toy_buildTable, to write the entries in order of their home slots
+typedef struct HomeSlot {
+	unsigned int home;
+	unsigned int index;
+} HomeSlot;
+
+static int compareHomeSlots(const void* lhs, const void* rhs) {
+	const HomeSlot* l = lhs;
+	const HomeSlot* r = rhs;
+
+	if (l->home != r->home) {
+		return l->home < r->home ? -1 : 1;
+	}
+
+	//keep it stable, so duplicate keys still resolve in the given order
+	return l->index < r->index ? -1 : l->index > r->index;
+}
+
 //exposed functions
 Toy_Table* Toy_private_adjustTableCapacity(Toy_Table* oldTable, unsigned int newCapacity) {
 	//allocate and zero a new table in memory
@@ -65,6 +108,7 @@ Toy_Table* Toy_private_adjustTableCapacity(Toy_Table* oldTable, unsigned int new
 	newTable->count = 0;
 	newTable->minPsl = 0;
 	newTable->maxPsl = 0;
+	newTable->refCount = 1; //only shared by Toy_Scope, for copy-on-write
 
 	//unlike other structures, the empty space in a table needs to be null
 	memset(newTable + 1, 0, newTable->capacity * sizeof(Toy_TableEntry));
@@ -89,12 +133,64 @@ Toy_Table* Toy_allocateTable() {
 	return Toy_private_adjustTableCapacity(NULL, TOY_TABLE_INITIAL_CAPACITY);
 }
 
+Toy_Table* Toy_allocateTableWithCapacity(unsigned int capacity) {
+	//the DOOM hack needs a power of 2
+	unsigned int actual = TOY_TABLE_INITIAL_CAPACITY;
+
+	while (actual < capacity) {
+		actual *= TOY_TABLE_EXPANSION_RATE;
+	}
+
+	return Toy_private_adjustTableCapacity(NULL, actual);
+}
+
+Toy_Table* Toy_buildTable(Toy_Value* keys, Toy_Value* values, unsigned int count, bool sortByHome) {
+	for (unsigned int i = 0; i < count; i++) {
+		if (TOY_VALUE_IS_NULL(keys[i]) || TOY_VALUE_IS_BOOLEAN(keys[i])) { //TODO: disallow functions and opaques
+			Toy_error(TOY_CC_ERROR "ERROR: Bad table key\n" TOY_CC_RESET);
+		}
+	}
+
+	//size once, so the inserts can skip the threshold checks
+	Toy_Table* table = Toy_private_adjustTableCapacity(NULL, calcCapacityForCount(count));
+
+	if (sortByHome == false || count < 2) {
+		for (unsigned int i = 0; i < count; i++) {
+			probeAndInsert(&table, keys[i], values[i]);
+		}
+
+		return table;
+	}
+
+	//sort by home slot, so the writes move sequentially through the table
+	HomeSlot* order = malloc(count * sizeof(HomeSlot));
+
+	if (order == NULL) {
+		Toy_error(TOY_CC_ERROR "ERROR: Failed to allocate space while building a 'Toy_Table'\n" TOY_CC_RESET);
+		return table;
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		order[i] = (HomeSlot){ .home = Toy_hashValue(keys[i]) % table->capacity, .index = i };
+	}
+
+	qsort(order, count, sizeof(HomeSlot), compareHomeSlots);
+
+	for (unsigned int i = 0; i < count; i++) {
+		probeAndInsert(&table, keys[order[i].index], values[order[i].index]);
+	}
+
+	free(order);
+	return table;
+}
+
 void Toy_freeTable(Toy_Table* table) {
 	if (table != NULL) {
 		//if some values will be removed, free them first
-		for (unsigned int i = 0; i < table->capacity; i++) {
-			Toy_freeValue(table->data[i].key);
-			Toy_freeValue(table->data[i].value);
+		unsigned int iterator = 0;
+		for (Toy_TableEntry* entry = Toy_iterateTable(table, &iterator); entry != NULL; entry = Toy_iterateTable(table, &iterator)) {
+			Toy_freeValue(entry->key);
+			Toy_freeValue(entry->value);
 		}
 
 		free(table);
@@ -146,7 +242,6 @@ void Toy_removeTable(Toy_Table** tableHandle, Toy_Value key) {
 
 	//lookup
 	unsigned int probe = Toy_hashValue(key) % (*tableHandle)->capacity;
-	unsigned int wipe = probe; //wiped at the end
 
 	while (true) {
 		//found the entry
@@ -165,22 +260,99 @@ void Toy_removeTable(Toy_Table** tableHandle, Toy_Value key) {
 	}
 
 	//shift along the later entries
-	for (unsigned int i = (*tableHandle)->minPsl; i < (*tableHandle)->maxPsl; i++) {
-		//DOOM hack used twice
-		unsigned int p = (probe + i + 0) & ((*tableHandle)->capacity-1); //prev
-		unsigned int u = (probe + i + 1) & ((*tableHandle)->capacity-1); //current
-
-		(*tableHandle)->data[p] = (*tableHandle)->data[u];
-		(*tableHandle)->data[p].psl--;
+	while (true) {
+		unsigned int u = (probe + 1) & ((*tableHandle)->capacity - 1); //DOOM hack
 
 		//if you hit something where it should be, or nothing at all, stop
-		if (TOY_VALUE_IS_NULL((*tableHandle)->data[u].key) || (*tableHandle)->data[p].psl == 0) {
-			wipe = u;
+		if (TOY_VALUE_IS_NULL((*tableHandle)->data[u].key) || (*tableHandle)->data[u].psl == 0) {
 			break;
 		}
+
+		(*tableHandle)->data[probe] = (*tableHandle)->data[u];
+		(*tableHandle)->data[probe].psl--;
+		probe = u;
 	}
 
 	//finally, wipe the removed entry
-	(*tableHandle)->data[wipe] = (Toy_TableEntry){ .key = TOY_VALUE_FROM_NULL(), .value = TOY_VALUE_FROM_NULL(), .psl = 0 };
+	(*tableHandle)->data[probe] = (Toy_TableEntry){ .key = TOY_VALUE_FROM_NULL(), .value = TOY_VALUE_FROM_NULL(), .psl = 0 };
 	(*tableHandle)->count--;
+
+	//contract the capacity, but never below the initial size
+	if ((*tableHandle)->capacity > TOY_TABLE_INITIAL_CAPACITY && (*tableHandle)->count < (*tableHandle)->capacity * TOY_TABLE_CONTRACTION_THRESHOLD) {
+		(*tableHandle) = Toy_private_adjustTableCapacity((*tableHandle), (*tableHandle)->capacity / TOY_TABLE_EXPANSION_RATE);
+	}
+}
+
+void Toy_initTablePool(Toy_TablePool* pool) {
+	for (int i = 0; i < TOY_TABLE_POOL_CAPACITIES; i++) {
+		pool->counts[i] = 0;
+	}
+}
+
+void Toy_freeTablePool(Toy_TablePool* pool) {
+	for (int i = 0; i < TOY_TABLE_POOL_CAPACITIES; i++) {
+		while (pool->counts[i] > 0) {
+			free(pool->tables[i][--pool->counts[i]]); //already emptied on release
+		}
+	}
+}
+
+Toy_Table* Toy_allocateTableFromPool(Toy_TablePool* pool, unsigned int capacity) {
+	int index = calcPoolIndex(capacity);
+
+	if (pool != NULL && index >= 0 && pool->counts[index] > 0) {
+		return pool->tables[index][--pool->counts[index]];
+	}
+
+	return Toy_allocateTableWithCapacity(capacity);
+}
+
+void Toy_releaseTableToPool(Toy_TablePool* pool, Toy_Table* table) {
+	if (table == NULL) {
+		return;
+	}
+
+	int index = calcPoolIndex(table->capacity);
+
+	//no room, so free it normally
+	if (pool == NULL || index < 0 || pool->counts[index] >= TOY_TABLE_POOL_LIMIT) {
+		Toy_freeTable(table);
+		return;
+	}
+
+	//empty the table, leaving it in the same state as a fresh allocation
+	unsigned int iterator = 0;
+	for (Toy_TableEntry* entry = Toy_iterateTable(table, &iterator); entry != NULL; entry = Toy_iterateTable(table, &iterator)) {
+		Toy_freeValue(entry->key);
+		Toy_freeValue(entry->value);
+	}
+
+	table->count = 0;
+	table->minPsl = 0;
+	table->maxPsl = 0;
+	table->refCount = 1;
+	memset(table + 1, 0, table->capacity * sizeof(Toy_TableEntry));
+
+	pool->tables[index][pool->counts[index]++] = table;
+}
+
+Toy_TableEntry* Toy_iterateTable(Toy_Table* table, unsigned int* iterator) {
+	while ((*iterator) < table->capacity) {
+		Toy_TableEntry* entry = &(table->data[(*iterator)++]);
+
+		if (!TOY_VALUE_IS_NULL(entry->key)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+void Toy_compactTable(Toy_Table** tableHandle) {
+	unsigned int newCapacity = calcCapacityForCount((*tableHandle)->count);
+
+	//only rehash if it actually shrinks
+	if (newCapacity < (*tableHandle)->capacity) {
+		(*tableHandle) = Toy_private_adjustTableCapacity((*tableHandle), newCapacity);
+	}
 }
@@ -16,15 +16,45 @@ typedef struct Toy_Table { //32 | 64 BITNESS
 	unsigned int count;    //4  | 4
 	unsigned int minPsl;   //4  | 4
 	unsigned int maxPsl;   //4  | 4
+	unsigned int refCount; //4  | 4
 	Toy_TableEntry data[]; //-  | -
-} Toy_Table;               //16 | 16
+} Toy_Table;               //20 | 20
 
 TOY_API Toy_Table* Toy_allocateTable();
+TOY_API Toy_Table* Toy_allocateTableWithCapacity(unsigned int capacity); //rounded up to a power of 2
 TOY_API void Toy_freeTable(Toy_Table* table);
 TOY_API void Toy_insertTable(Toy_Table** tableHandle, Toy_Value key, Toy_Value value);
 TOY_API Toy_Value Toy_lookupTable(Toy_Table** tableHandle, Toy_Value key);
 TOY_API void Toy_removeTable(Toy_Table** tableHandle, Toy_Value key);
 
+//build a table from N known pairs, sized once up front (later duplicate keys override earlier ones)
+TOY_API Toy_Table* Toy_buildTable(Toy_Value* keys, Toy_Value* values, unsigned int count, bool sortByHome);
+
+//visits only the occupied slots; start the iterator at 0, returns NULL when finished
+TOY_API Toy_TableEntry* Toy_iterateTable(Toy_Table* table, unsigned int* iterator);
+
+//shrink the capacity to the smallest size that can hold the contents
+TOY_API void Toy_compactTable(Toy_Table** tableHandle);
+
+//recycles freed tables, keyed by capacity, to avoid malloc/free churn
+#ifndef TOY_TABLE_POOL_CAPACITIES
+#define TOY_TABLE_POOL_CAPACITIES 4 //the initial capacity, and a few expansions above it
+#endif
+
+#ifndef TOY_TABLE_POOL_LIMIT
+#define TOY_TABLE_POOL_LIMIT 8 //the most tables held for each capacity
+#endif
+
+typedef struct Toy_TablePool {
+	Toy_Table* tables[TOY_TABLE_POOL_CAPACITIES][TOY_TABLE_POOL_LIMIT];
+	unsigned int counts[TOY_TABLE_POOL_CAPACITIES];
+} Toy_TablePool;
+
+TOY_API void Toy_initTablePool(Toy_TablePool* pool);
+TOY_API void Toy_freeTablePool(Toy_TablePool* pool);
+TOY_API Toy_Table* Toy_allocateTableFromPool(Toy_TablePool* pool, unsigned int capacity); //pool can be NULL
+TOY_API void Toy_releaseTableToPool(Toy_TablePool* pool, Toy_Table* table); //pool can be NULL, frees the contents
+
 //NOTE: exposed to skip unnecessary allocations within Toy_Scope
 TOY_API Toy_Table* Toy_private_adjustTableCapacity(Toy_Table* oldTable, unsigned int newCapacity);
 
@@ -42,3 +72,9 @@ TOY_API Toy_Table* Toy_private_adjustTableCapacity(Toy_Table* oldTable, unsigned
 #ifndef TOY_TABLE_EXPANSION_THRESHOLD
 #define TOY_TABLE_EXPANSION_THRESHOLD 0.8
 #endif
+
+//contract when the contents drops below a certain percentage of the capacity
+//NOTE: must stay below (EXPANSION_THRESHOLD / EXPANSION_RATE), or a table on the boundary will thrash
+#ifndef TOY_TABLE_CONTRACTION_THRESHOLD
+#define TOY_TABLE_CONTRACTION_THRESHOLD 0.25
+#endif
@@ -0,0 +1,489 @@
+#include "toy_transpiler.h"
+#include "toy_console_colors.h"
+
+#include "toy_opcodes.h"
+#include "toy_value.h"
+#include "toy_string.h"
+#include "toy_routine.h"
+#include "toy_bytecode.h"
+#include "toy_verifier.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//the generated source, grown as needed
+typedef struct Toy_TranspilerBuffer {
+	char* ptr;
+	unsigned int capacity;
+	unsigned int count;
+} Toy_TranspilerBuffer;
+
+//the enum names, so the generated code reads like the VM
+static const char* valueTypeNames[] = {
+	"TOY_VALUE_NULL",
+	"TOY_VALUE_BOOLEAN",
+	"TOY_VALUE_INTEGER",
+	"TOY_VALUE_FLOAT",
+	"TOY_VALUE_STRING",
+	"TOY_VALUE_ARRAY",
+	"TOY_VALUE_TABLE",
+	"TOY_VALUE_FUNCTION",
+	"TOY_VALUE_OPAQUE",
+	"TOY_VALUE_TYPE",
+	"TOY_VALUE_ANY",
+	"TOY_VALUE_UNKNOWN",
+};
+
+static const char* getOpcodeName(Toy_OpcodeType opcode) {
+	switch(opcode) {
+		case TOY_OPCODE_ADD: return "TOY_OPCODE_ADD";
+		case TOY_OPCODE_SUBTRACT: return "TOY_OPCODE_SUBTRACT";
+		case TOY_OPCODE_MULTIPLY: return "TOY_OPCODE_MULTIPLY";
+		case TOY_OPCODE_DIVIDE: return "TOY_OPCODE_DIVIDE";
+		case TOY_OPCODE_MODULO: return "TOY_OPCODE_MODULO";
+		case TOY_OPCODE_COMPARE_EQUAL: return "TOY_OPCODE_COMPARE_EQUAL";
+		case TOY_OPCODE_COMPARE_LESS: return "TOY_OPCODE_COMPARE_LESS";
+		case TOY_OPCODE_COMPARE_LESS_EQUAL: return "TOY_OPCODE_COMPARE_LESS_EQUAL";
+		case TOY_OPCODE_COMPARE_GREATER: return "TOY_OPCODE_COMPARE_GREATER";
+		case TOY_OPCODE_COMPARE_GREATER_EQUAL: return "TOY_OPCODE_COMPARE_GREATER_EQUAL";
+		case TOY_OPCODE_AND: return "TOY_OPCODE_AND";
+		case TOY_OPCODE_OR: return "TOY_OPCODE_OR";
+		case TOY_OPCODE_TRUTHY: return "TOY_OPCODE_TRUTHY";
+		case TOY_OPCODE_NEGATE: return "TOY_OPCODE_NEGATE";
+		default: return NULL; //only the opcodes passed on to the VM are named
+	}
+}
+
+//utils
+static void emitText(Toy_TranspilerBuffer* out, const char* text) {
+	unsigned int length = strlen(text);
+
+	if (out->count + length + 1 > out->capacity) {
+		while (out->count + length + 1 > out->capacity) { //expand as much as needed
+			out->capacity = out->capacity < 1024 ? 1024 : out->capacity * 2;
+		}
+
+		out->ptr = realloc(out->ptr, out->capacity);
+
+		if (out->ptr == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a transpiler buffer of %d capacity\n" TOY_CC_RESET, (int)(out->capacity));
+			exit(1);
+		}
+	}
+
+	memcpy(out->ptr + out->count, text, length + 1);
+	out->count += length;
+}
+
+//a C string literal; '?' is escaped to avoid trigraphs, and octal escapes are always three digits so the next character can't extend them
+static void emitStringLiteral(Toy_TranspilerBuffer* out, const char* str) {
+	emitText(out, "\"");
+
+	for (const unsigned char* c = (const unsigned char*)str; *c != '\0'; c++) {
+		char buffer[8];
+
+		if (*c == '"' || *c == '\\' || *c == '?') {
+			snprintf(buffer, 8, "\\%c", *c);
+		}
+		else if (*c == '\n') {
+			snprintf(buffer, 8, "\\n");
+		}
+		else if (*c == '\t') {
+			snprintf(buffer, 8, "\\t");
+		}
+		else if (*c < 0x20 || *c > 0x7E) {
+			snprintf(buffer, 8, "\\%03o", *c);
+		}
+		else {
+			snprintf(buffer, 8, "%c", *c);
+		}
+
+		emitText(out, buffer);
+	}
+
+	emitText(out, "\"");
+}
+
+//module names come from file names, which aren't always valid identifiers
+static char* makeIdentifier(const char* prefix, const char* name) {
+	unsigned int length = strlen(prefix) + (name != NULL ? strlen(name) + 1 : 0);
+	char* identifier = malloc(length + 2);
+
+	if (identifier == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate an identifier of %d length\n" TOY_CC_RESET, (int)length);
+		exit(1);
+	}
+
+	snprintf(identifier, length + 2, "%s%s%s%s", (prefix[0] >= '0' && prefix[0] <= '9') || prefix[0] == '\0' ? "_" : "", prefix, name != NULL ? "_" : "", name != NULL ? name : "");
+
+	for (char* c = identifier; *c != '\0'; c++) {
+		if (!((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9'))) {
+			*c = '_';
+		}
+	}
+
+	return identifier;
+}
+
+//decoding, the same way as the VM
+static unsigned int readWord(const unsigned char* ptr) {
+	unsigned int word;
+	memcpy(&word, ptr, sizeof(word));
+	return word;
+}
+
+static void fixAlignment(unsigned int* pc) {
+	*pc = (*pc + 3) & ~0b11;
+}
+
+//the verifier has already rejected the varints that don't fit an int, but this never reads past the 5th byte either way
+static unsigned int readVarint(const unsigned char* routine, unsigned int* pc) {
+	unsigned int value = 0;
+	for (unsigned int shift = 0; shift < 35; shift += 7) {
+		unsigned char byte = routine[(*pc)++];
+		value |= (unsigned int)(byte & (shift == 28 ? 0x0F : 0x7F)) << shift;
+		if ((byte & 0x80) == 0 || shift == 28) {
+			break;
+		}
+	}
+
+	return value;
+}
+
+//the jump index is only ever used as the entry number within the jump table
+static unsigned int readJumpSlot(const unsigned char* routine, unsigned int* pc, bool dense) {
+	if (dense) {
+		return readVarint(routine, pc);
+	}
+
+	fixAlignment(pc);
+	unsigned int jump = readWord(routine + *pc);
+	*pc += 4;
+	return jump / 4;
+}
+
+//emits one instruction, returning false at the end of the routine
+static bool transpileInstruction(Toy_TranspilerBuffer* out, const unsigned char* routine, unsigned int* pc, bool dense, unsigned int site, unsigned int* resumes) {
+	char buffer[256];
+
+	if (!dense) {
+		fixAlignment(pc);
+	}
+
+	Toy_OpcodeType opcode = routine[(*pc)++];
+
+	switch(opcode) {
+		//variable instructions
+		case TOY_OPCODE_READ: {
+			Toy_ValueType type = routine[(*pc)++];
+
+			if (type == TOY_VALUE_NULL) {
+				snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_NULL());\n");
+			}
+			else if (type == TOY_VALUE_BOOLEAN) {
+				snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(%s));\n", routine[(*pc)++] ? "true" : "false");
+			}
+			else if (type == TOY_VALUE_INTEGER) {
+				int value;
+				if (dense) {
+					unsigned int zigzag = readVarint(routine, pc);
+					value = (int)((zigzag >> 1) ^ -(zigzag & 1));
+				}
+				else {
+					fixAlignment(pc);
+					memcpy(&value, routine + *pc, sizeof(value));
+					*pc += sizeof(value);
+				}
+
+				//the most negative int has no literal of its own
+				if (value == INT_MIN) {
+					snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(%d - 1));\n", INT_MIN + 1);
+				}
+				else {
+					snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(%d));\n", value);
+				}
+			}
+			else if (type == TOY_VALUE_FLOAT) {
+				float value;
+				if (!dense) {
+					fixAlignment(pc);
+				}
+				memcpy(&value, routine + *pc, sizeof(value));
+				*pc += sizeof(value);
+
+				//hex floats are exact, but there's no literal for the non-finite values
+				if (isinf(value)) {
+					snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_FLOAT(%sHUGE_VALF));\n", value < 0 ? "-" : "");
+				}
+				else if (isnan(value)) {
+					snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_FLOAT(NAN));\n");
+				}
+				else {
+					snprintf(buffer, 256, "\tToy_pushStack(&vm->stack, TOY_VALUE_FROM_FLOAT(%af));\n", value);
+				}
+			}
+			else {
+				//anything else was rejected by the verifier
+				enum Toy_StringType stringType = routine[(*pc)++];
+				unsigned int len = routine[(*pc)++];
+				unsigned int slot = readJumpSlot(routine, pc, dense);
+
+				snprintf(buffer, 256, "\tToy_private_nativeReadString(vm, %u, %s, %u);\n", slot, stringType == TOY_STRING_NAME ? "true" : "false", len);
+			}
+
+			emitText(out, buffer);
+			break;
+		}
+
+		case TOY_OPCODE_DECLARE: {
+			Toy_ValueType type = routine[(*pc)++];
+			unsigned int len = routine[(*pc)++];
+			bool constant = routine[(*pc)++];
+			unsigned int slot = readJumpSlot(routine, pc, dense);
+
+			snprintf(buffer, 256, "\tToy_private_nativeDeclare(vm, %s, %u, %s, %u);\n", valueTypeNames[type], len, constant ? "true" : "false", slot);
+			emitText(out, buffer);
+			break;
+		}
+
+		case TOY_OPCODE_ASSIGN:
+			snprintf(buffer, 256, "\tToy_private_nativeAssign(vm, %u);\n", site);
+			emitText(out, buffer);
+			break;
+
+		case TOY_OPCODE_ACCESS: {
+			unsigned int len = routine[(*pc)++];
+			unsigned int slot = readJumpSlot(routine, pc, dense);
+
+			snprintf(buffer, 256, "\tToy_private_nativeAccess(vm, %u, %u, %u);\n", site, len, slot);
+			emitText(out, buffer);
+			break;
+		}
+
+		case TOY_OPCODE_DUPLICATE: {
+			bool access = routine[(*pc)++] == TOY_OPCODE_ACCESS;
+
+			snprintf(buffer, 256, "\tToy_private_nativeDuplicate(vm, %s, %u);\n", access ? "true" : "false", site);
+			emitText(out, buffer);
+			break;
+		}
+
+		//arithmetic instructions
+		case TOY_OPCODE_ADD:
+		case TOY_OPCODE_SUBTRACT:
+		case TOY_OPCODE_MULTIPLY:
+		case TOY_OPCODE_DIVIDE:
+		case TOY_OPCODE_MODULO: {
+			snprintf(buffer, 256, "\tToy_private_nativeArithmetic(vm, %s);\n", getOpcodeName(opcode));
+			emitText(out, buffer);
+
+			//compound assignments
+			if (routine[(*pc)++] == TOY_OPCODE_ASSIGN) {
+				snprintf(buffer, 256, "\tToy_private_nativeAssign(vm, %u);\n", site);
+				emitText(out, buffer);
+			}
+			break;
+		}
+
+		//comparison instructions
+		case TOY_OPCODE_COMPARE_EQUAL:
+		case TOY_OPCODE_COMPARE_LESS:
+		case TOY_OPCODE_COMPARE_LESS_EQUAL:
+		case TOY_OPCODE_COMPARE_GREATER:
+		case TOY_OPCODE_COMPARE_GREATER_EQUAL: {
+			bool negate = opcode == TOY_OPCODE_COMPARE_EQUAL && routine[(*pc)++] == TOY_OPCODE_NEGATE;
+
+			snprintf(buffer, 256, "\tToy_private_nativeComparison(vm, %s, %s);\n", getOpcodeName(opcode), negate ? "true" : "false");
+			emitText(out, buffer);
+			break;
+		}
+
+		//logical instructions
+		case TOY_OPCODE_AND:
+		case TOY_OPCODE_OR:
+		case TOY_OPCODE_TRUTHY:
+		case TOY_OPCODE_NEGATE:
+			snprintf(buffer, 256, "\tToy_private_nativeLogical(vm, %s);\n", getOpcodeName(opcode));
+			emitText(out, buffer);
+			break;
+
+		//control instructions
+		case TOY_OPCODE_RETURN:
+			emitText(out, "\treturn;\n");
+			return false;
+
+		case TOY_OPCODE_YIELD:
+			//the next run picks up from the case after the yield
+			(*resumes)++;
+			snprintf(buffer, 256, "\tvm->routineCounter = %u;\n\tToy_private_nativeYield(vm);\n\treturn;\n\n\tcase %u:\n", *resumes, *resumes);
+			emitText(out, buffer);
+			break;
+
+		case TOY_OPCODE_SCOPE_PUSH:
+			emitText(out, "\tvm->scope = Toy_pushScope(&vm->scopeBucket, vm->scope);\n");
+			break;
+
+		case TOY_OPCODE_SCOPE_POP:
+			emitText(out, "\tvm->scope = Toy_popScope(vm->scope);\n\tvm->scopeVersion++;\n");
+			break;
+
+		//various action instructions
+		case TOY_OPCODE_ASSERT:
+			snprintf(buffer, 256, "\tToy_private_nativeAssert(vm, %u);\n", (unsigned int)routine[(*pc)++]);
+			emitText(out, buffer);
+			break;
+
+		case TOY_OPCODE_PRINT:
+			emitText(out, "\tToy_private_nativePrint(vm);\n");
+			break;
+
+		case TOY_OPCODE_CONCAT:
+			emitText(out, "\tToy_private_nativeConcat(vm);\n");
+			break;
+
+		case TOY_OPCODE_INDEX:
+			snprintf(buffer, 256, "\tToy_private_nativeIndex(vm, %u);\n", (unsigned int)routine[(*pc)++]);
+			emitText(out, buffer);
+			break;
+
+		default:
+			//anything else was rejected by the verifier
+			return false;
+	}
+
+	return true;
+}
+
+static bool transpileRoutine(Toy_TranspilerBuffer* out, const unsigned char* routine, unsigned int length, const char* name) {
+	//only verified routines are transpiled, so the generated code can skip every check the verifier covers
+	char msg[256];
+	if (!Toy_verifyRoutine(routine, length, msg, 256)) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Routine '%s' failed verification: %s\n" TOY_CC_RESET, name, msg);
+		return false;
+	}
+
+	//the same header as Toy_bindVMToRoutine() reads
+	bool dense = (readWord(routine) & TOY_ROUTINE_FLAG_DENSE) != 0;
+	unsigned int paramSize = readWord(routine + 4);
+	unsigned int jumpsSize = readWord(routine + 8);
+	unsigned int dataSize = readWord(routine + 12);
+
+	unsigned int addr = paramSize > 0 ? 24 : 20;
+	unsigned int codeAddr = readWord(routine + addr);
+	addr += 4;
+	unsigned int jumpsAddr = jumpsSize > 0 ? readWord(routine + addr) : 0;
+	addr += jumpsSize > 0 ? 4 : 0;
+	unsigned int dataAddr = dataSize > 0 ? readWord(routine + addr) : 0;
+
+	char buffer[256];
+	unsigned int stringCount = jumpsSize / 4;
+
+	//the jump table, resolved
+	if (stringCount > 0) {
+		emitText(out, "static const char* ");
+		emitText(out, name);
+		emitText(out, "_strings[] = {\n");
+
+		for (unsigned int i = 0; i < stringCount; i++) {
+			emitText(out, "\t");
+			emitStringLiteral(out, (const char*)(routine + dataAddr + readWord(routine + jumpsAddr + i * 4)));
+			emitText(out, ",\n");
+		}
+
+		emitText(out, "};\n\n");
+	}
+
+	//the code, with a case to resume from after each yield
+	emitText(out, "static void ");
+	emitText(out, name);
+	emitText(out, "_run(Toy_VM* vm) {\n\tswitch(vm->routineCounter) {\n\tcase 0:\n");
+
+	unsigned int pc = codeAddr;
+	unsigned int site = 0;
+	unsigned int resumes = 0;
+
+	while (transpileInstruction(out, routine, &pc, dense, site, &resumes)) {
+		site++;
+	}
+
+	emitText(out, "\t}\n}\n\n");
+
+	//the routine itself
+	emitText(out, "const Toy_NativeRoutine ");
+	emitText(out, name);
+	emitText(out, " = {\n\t.run = ");
+	emitText(out, name);
+	emitText(out, "_run,\n\t.strings = ");
+
+	if (stringCount > 0) {
+		emitText(out, name);
+		emitText(out, "_strings,\n");
+	}
+	else {
+		emitText(out, "NULL,\n");
+	}
+
+	snprintf(buffer, 256, "\t.stringCount = %u,\n\t.siteCount = %u,\n};\n\n", stringCount, site + 1);
+	emitText(out, buffer);
+
+	return true;
+}
+
+//exposed functions
+char* Toy_transpileBytecode(const unsigned char* bytecode, unsigned int length, const char* name) {
+	//offset by the header size, same as Toy_bindVM()
+	unsigned int offset = Toy_getBytecodeHeaderSize();
+
+	if (length < offset + 4) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Can't transpile truncated bytecode of %d bytes\n" TOY_CC_RESET, (int)length);
+		return NULL;
+	}
+
+	//the generated code calls into this version's VM
+	if (bytecode[0] != TOY_VERSION_MAJOR || bytecode[1] > TOY_VERSION_MINOR) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Can't transpile bytecode version %d.%d.%d with version %d.%d.%d\n" TOY_CC_RESET, bytecode[0], bytecode[1], bytecode[2], TOY_VERSION_MAJOR, TOY_VERSION_MINOR, TOY_VERSION_PATCH);
+		return NULL;
+	}
+
+	Toy_TranspilerBuffer out = { .ptr = NULL, .capacity = 0, .count = 0 };
+	char buffer[256];
+
+	snprintf(buffer, 256, "//transpiled by Toy_transpileBytecode() from version %d.%d.%d bytecode, bind with Toy_bindVMToNative()\n", bytecode[0], bytecode[1], bytecode[2]);
+	emitText(&out, buffer);
+	emitText(&out, "#include \"toy_vm.h\"\n\n#include <math.h>\n\n");
+
+	unsigned int count = Toy_getBundleModuleCount(bytecode, length);
+	bool transpiled = true;
+
+	if (count == 0) {
+		char* identifier = makeIdentifier(name, NULL);
+		transpiled = transpileRoutine(&out, bytecode + offset, length - offset, identifier);
+		free(identifier);
+	}
+
+	//one routine per module, named after both
+	for (unsigned int i = 0; i < count && transpiled; i++) {
+		const char* moduleName = Toy_getBundleModuleName(bytecode, length, i);
+		const unsigned char* module = Toy_getBundleModule(bytecode, length, i);
+
+		if (moduleName == NULL || module == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid index entry %d found in the bundle\n" TOY_CC_RESET, (int)i);
+			transpiled = false;
+			break;
+		}
+
+		char* identifier = makeIdentifier(name, moduleName);
+		transpiled = transpileRoutine(&out, module, length - (unsigned int)(module - bytecode), identifier);
+		free(identifier);
+	}
+
+	if (!transpiled) {
+		free(out.ptr);
+		return NULL;
+	}
+
+	return out.ptr;
+}
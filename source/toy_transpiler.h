@@ -0,0 +1,11 @@
+#pragma once
+
+#include "toy_common.h"
+
+//writes a C translation unit that runs the bytecode without the VM's dispatch loop, for hosts willing to compile their scripts ahead of time
+//each routine becomes a 'const Toy_NativeRoutine' called 'name', or 'name_module' for each module of a bundle, to be bound with Toy_bindVMToNative()
+//returns a malloc'd string for the caller to free, or NULL when the bytecode is from another version, or is truncated, or a routine fails verification
+TOY_API char* Toy_transpileBytecode(const unsigned char* bytecode, unsigned int length, const char* name);
+
+//NOTE: the generated code only includes toy_vm.h and math.h, and links against the same library as the VM;
+//each instruction becomes a call to the VM's own instruction body, or a direct call to the stack or scope for the simplest ones
@@ -0,0 +1,428 @@
+#include "toy_verifier.h"
+
+#include "toy_opcodes.h"
+#include "toy_value.h"
+#include "toy_string.h"
+#include "toy_routine.h"
+#include "toy_stack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//the parts of a routine the instructions refer to
+typedef struct Toy_VerifierState {
+	const unsigned char* routine;
+	unsigned int routineSize;
+
+	unsigned int codeAddr;
+	unsigned int codeEnd;
+	unsigned int jumpsAddr;
+	unsigned int jumpsSize;
+	unsigned int dataAddr;
+	unsigned int dataSize;
+
+	bool dense;
+
+	char* msg;
+	unsigned int msgLength;
+} Toy_VerifierState;
+
+//utils
+static unsigned int readWord(const unsigned char* ptr) {
+	unsigned int word;
+	memcpy(&word, ptr, sizeof(word));
+	return word;
+}
+
+static unsigned int readNextWord(const unsigned char* routine, unsigned int* addr) {
+	unsigned int word = readWord(routine + *addr);
+	*addr += 4;
+	return word;
+}
+
+static bool fail(Toy_VerifierState* state, unsigned int addr, const char* problem) {
+	snprintf(state->msg, state->msgLength, "%s at %u", problem, addr);
+	return false;
+}
+
+//a section must fit within the routine, and can't overlap the header
+static bool checkSection(Toy_VerifierState* state, unsigned int addr, unsigned int size, unsigned int headerEnd, const char* problem) {
+	if (addr < headerEnd || addr % 4 != 0 || addr > state->routineSize || size > state->routineSize - addr) {
+		return fail(state, addr, problem);
+	}
+
+	return true;
+}
+
+//the jump index points into the jump table, which holds an offset into the data section
+static bool checkJump(Toy_VerifierState* state, unsigned int pc, unsigned int index, unsigned int nameLength) {
+	if (index % 4 != 0 || index >= state->jumpsSize) {
+		return fail(state, pc, "Invalid jump index found");
+	}
+
+	unsigned int offset = readWord(state->routine + state->jumpsAddr + index);
+
+	if (offset >= state->dataSize || nameLength > state->dataSize - offset) {
+		return fail(state, pc, "Invalid data offset found");
+	}
+
+	//the string must end within the data section, since the padding after it isn't always zeroed
+	if (memchr(state->routine + state->dataAddr + offset, '\0', state->dataSize - offset) == NULL) {
+		return fail(state, pc, "Unterminated string found");
+	}
+
+	return true;
+}
+
+//returns the varint's length, or 0 if it runs past the code or is longer than an int needs
+static unsigned int readVarint(Toy_VerifierState* state, unsigned int pc, unsigned int* value) {
+	*value = 0;
+
+	for (unsigned int i = 0; i < 5 && pc + i < state->codeEnd; i++) {
+		unsigned char byte = state->routine[pc + i];
+
+		//the 5th byte only has 4 bits left to fill, and can't continue
+		if (i == 4 && byte > 0x0F) {
+			return 0;
+		}
+
+		*value |= (unsigned int)(byte & 0x7F) << (7 * i);
+
+		if ((byte & 0x80) == 0) {
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+//returns the instruction's length, or 0 if it's truncated; the single-byte operands sit right after the opcode in both encodings
+static unsigned int decodeInstruction(Toy_VerifierState* state, unsigned int pc, unsigned int* jump) {
+	const unsigned char* routine = state->routine;
+	Toy_OpcodeType opcode = routine[pc];
+
+	if (!state->dense) {
+		//most instructions fit in one word, but the ones with an immediate value or a jump take two
+		unsigned int length = 4;
+
+		if (opcode == TOY_OPCODE_DECLARE || opcode == TOY_OPCODE_ACCESS ||
+			(opcode == TOY_OPCODE_READ && (routine[pc + 1] == TOY_VALUE_INTEGER || routine[pc + 1] == TOY_VALUE_FLOAT || routine[pc + 1] == TOY_VALUE_STRING)))
+		{
+			length = 8;
+		}
+
+		if (pc + length > state->codeEnd) {
+			return 0;
+		}
+
+		*jump = length == 8 ? readWord(routine + pc + 4) : 0;
+		return length;
+	}
+
+	//see toy_routine.h for the dense layout
+	unsigned int fixed = 1;
+	bool varint = false;
+
+	switch(opcode) {
+		case TOY_OPCODE_READ:
+			if (pc + 2 > state->codeEnd) {
+				return 0;
+			}
+
+			switch(routine[pc + 1]) {
+				case TOY_VALUE_BOOLEAN: fixed = 3; break;
+				case TOY_VALUE_INTEGER: fixed = 2; varint = true; break;
+				case TOY_VALUE_FLOAT: fixed = 6; break;
+				case TOY_VALUE_STRING: fixed = 4; varint = true; break;
+				default: fixed = 2; break;
+			}
+			break;
+
+		case TOY_OPCODE_DECLARE:
+			fixed = 4;
+			varint = true;
+			break;
+
+		case TOY_OPCODE_ACCESS:
+			fixed = 2;
+			varint = true;
+			break;
+
+		case TOY_OPCODE_DUPLICATE:
+		case TOY_OPCODE_ADD:
+		case TOY_OPCODE_SUBTRACT:
+		case TOY_OPCODE_MULTIPLY:
+		case TOY_OPCODE_DIVIDE:
+		case TOY_OPCODE_MODULO:
+		case TOY_OPCODE_COMPARE_EQUAL:
+		case TOY_OPCODE_ASSERT:
+		case TOY_OPCODE_INDEX:
+			fixed = 2;
+			break;
+
+		default:
+			break;
+	}
+
+	if (pc + fixed > state->codeEnd) {
+		return 0;
+	}
+
+	*jump = 0;
+	if (!varint) {
+		return fixed;
+	}
+
+	//the integers are read the same way, but never used as a jump
+	unsigned int value;
+	unsigned int extra = readVarint(state, pc + fixed, &value);
+
+	//a slot past the table would wrap when scaled, so it's replaced by an index checkJump() always rejects
+	*jump = value < state->jumpsSize / 4 ? value * 4 : state->jumpsSize;
+
+	return extra == 0 ? 0 : fixed + extra;
+}
+
+static bool checkDepth(Toy_VerifierState* state, unsigned int pc, int depth, int needed) {
+	if (depth < needed) {
+		return fail(state, pc, "Stack underflow found");
+	}
+
+	return true;
+}
+
+//exposed functions
+bool Toy_verifyRoutine(const unsigned char* routine, unsigned int length, char* msg, unsigned int msgLength) {
+	Toy_VerifierState state = { .routine = routine, .msg = msg, .msgLength = msgLength };
+
+	//the five sizes, then the code address, are always present
+	if (length < 6 * 4) {
+		return fail(&state, 0, "Truncated routine header found");
+	}
+
+	state.routineSize = readWord(routine) & TOY_ROUTINE_SIZE_MASK;
+	state.dense = (readWord(routine) & TOY_ROUTINE_FLAG_DENSE) != 0;
+	if (state.routineSize < 6 * 4) {
+		return fail(&state, 0, "Truncated routine header found");
+	}
+
+	//every offset below is checked against the routine's size, so this bounds them all
+	if (state.routineSize > length) {
+		return fail(&state, 0, "Truncated routine found");
+	}
+
+	unsigned int paramSize = readWord(routine + 4);
+	state.jumpsSize = readWord(routine + 8);
+	state.dataSize = readWord(routine + 12);
+	unsigned int subsSize = readWord(routine + 16);
+
+	unsigned int headerEnd = 4 * (6 + (paramSize > 0) + (state.jumpsSize > 0) + (state.dataSize > 0) + (subsSize > 0));
+	if (state.routineSize < headerEnd) {
+		return fail(&state, 0, "Truncated routine header found");
+	}
+
+	//same order as Toy_bindVMToRoutine()
+	unsigned int addr = 20;
+	unsigned int paramAddr = paramSize > 0 ? readNextWord(routine, &addr) : 0;
+	state.codeAddr = readNextWord(routine, &addr);
+	state.jumpsAddr = state.jumpsSize > 0 ? readNextWord(routine, &addr) : 0;
+	state.dataAddr = state.dataSize > 0 ? readNextWord(routine, &addr) : 0;
+	unsigned int subsAddr = subsSize > 0 ? readNextWord(routine, &addr) : 0;
+
+	if ((paramSize > 0 && !checkSection(&state, paramAddr, paramSize, headerEnd, "Invalid param section found")) ||
+		!checkSection(&state, state.codeAddr, 0, headerEnd, "Invalid code section found") ||
+		(state.jumpsSize > 0 && !checkSection(&state, state.jumpsAddr, state.jumpsSize, headerEnd, "Invalid jumps section found")) ||
+		(state.dataSize > 0 && !checkSection(&state, state.dataAddr, state.dataSize, headerEnd, "Invalid data section found")) ||
+		(subsSize > 0 && !checkSection(&state, subsAddr, subsSize, headerEnd, "Invalid subs section found")))
+	{
+		return false;
+	}
+
+	if (state.jumpsSize % 4 != 0) {
+		return fail(&state, state.jumpsAddr, "Misaligned jumps section found");
+	}
+
+	//the code runs up to whichever section follows it
+	state.codeEnd = state.routineSize;
+	unsigned int starts[] = { paramAddr, state.jumpsAddr, state.dataAddr, subsAddr };
+	for (unsigned int i = 0; i < sizeof(starts) / sizeof(starts[0]); i++) {
+		if (starts[i] > state.codeAddr && starts[i] < state.codeEnd) {
+			state.codeEnd = starts[i];
+		}
+	}
+
+	//there are no branches yet, so one pass in order covers every path
+	unsigned int pc = state.codeAddr;
+	int depth = 0;
+	int scopeDepth = 0;
+
+	for (;;) {
+		if (pc + (state.dense ? 1 : 4) > state.codeEnd) {
+			return fail(&state, pc, "Code without a return found");
+		}
+
+		Toy_OpcodeType opcode = routine[pc];
+		unsigned int jump = 0;
+		unsigned int length = decodeInstruction(&state, pc, &jump);
+
+		if (length == 0) {
+			return fail(&state, pc, "Truncated instruction found");
+		}
+
+		switch(opcode) {
+			case TOY_OPCODE_READ: {
+				Toy_ValueType type = routine[pc + 1];
+
+				if (type == TOY_VALUE_STRING) {
+					enum Toy_StringType stringType = routine[pc + 2];
+					if (stringType != TOY_STRING_LEAF && stringType != TOY_STRING_NAME) {
+						return fail(&state, pc, "Invalid string type found");
+					}
+
+					if (!checkJump(&state, pc, jump, stringType == TOY_STRING_NAME ? routine[pc + 3] : 0)) {
+						return false;
+					}
+				}
+				else if (type != TOY_VALUE_NULL && type != TOY_VALUE_BOOLEAN && type != TOY_VALUE_INTEGER && type != TOY_VALUE_FLOAT) {
+					return fail(&state, pc, "Invalid value type found");
+				}
+
+				depth++;
+				break;
+			}
+
+			case TOY_OPCODE_DECLARE:
+			case TOY_OPCODE_ACCESS: {
+				if (opcode == TOY_OPCODE_DECLARE && routine[pc + 1] > TOY_VALUE_UNKNOWN) {
+					return fail(&state, pc, "Invalid value type found");
+				}
+
+				if (!checkJump(&state, pc, jump, opcode == TOY_OPCODE_DECLARE ? routine[pc + 2] : routine[pc + 1]) ||
+					(opcode == TOY_OPCODE_DECLARE && !checkDepth(&state, pc, depth, 1)))
+				{
+					return false;
+				}
+
+				depth += opcode == TOY_OPCODE_DECLARE ? -1 : 1;
+				break;
+			}
+
+			case TOY_OPCODE_ASSIGN:
+				if (!checkDepth(&state, pc, depth, 2)) {
+					return false;
+				}
+				depth -= 2;
+				break;
+
+			case TOY_OPCODE_DUPLICATE:
+				//the squeezed access swaps the duplicated name for its value
+				if (!checkDepth(&state, pc, depth, 1)) {
+					return false;
+				}
+				depth++;
+				break;
+
+			case TOY_OPCODE_ADD:
+			case TOY_OPCODE_SUBTRACT:
+			case TOY_OPCODE_MULTIPLY:
+			case TOY_OPCODE_DIVIDE:
+			case TOY_OPCODE_MODULO:
+				//the squeezed assign also takes the result and the name beneath it
+				if (!checkDepth(&state, pc, depth, routine[pc + 1] == TOY_OPCODE_ASSIGN ? 3 : 2)) {
+					return false;
+				}
+				depth -= routine[pc + 1] == TOY_OPCODE_ASSIGN ? 3 : 1;
+				break;
+
+			case TOY_OPCODE_COMPARE_EQUAL:
+			case TOY_OPCODE_COMPARE_LESS:
+			case TOY_OPCODE_COMPARE_LESS_EQUAL:
+			case TOY_OPCODE_COMPARE_GREATER:
+			case TOY_OPCODE_COMPARE_GREATER_EQUAL:
+			case TOY_OPCODE_AND:
+			case TOY_OPCODE_OR:
+			case TOY_OPCODE_CONCAT:
+				if (!checkDepth(&state, pc, depth, 2)) {
+					return false;
+				}
+				depth--;
+				break;
+
+			case TOY_OPCODE_TRUTHY:
+			case TOY_OPCODE_NEGATE:
+				if (!checkDepth(&state, pc, depth, 1)) {
+					return false;
+				}
+				break;
+
+			case TOY_OPCODE_RETURN:
+				if (scopeDepth != 0) {
+					return fail(&state, pc, "Unbalanced scopes found");
+				}
+				return true;
+
+			case TOY_OPCODE_YIELD:
+			case TOY_OPCODE_PRINT:
+				if (!checkDepth(&state, pc, depth, 1)) {
+					return false;
+				}
+				depth--;
+				break;
+
+			case TOY_OPCODE_SCOPE_PUSH:
+				scopeDepth++;
+				break;
+
+			case TOY_OPCODE_SCOPE_POP:
+				if (scopeDepth == 0) {
+					return fail(&state, pc, "Unbalanced scopes found");
+				}
+				scopeDepth--;
+				break;
+
+			case TOY_OPCODE_ASSERT: {
+				int count = routine[pc + 1];
+
+				if (count != 1 && count != 2) {
+					return fail(&state, pc, "Invalid assert argument count found");
+				}
+
+				if (!checkDepth(&state, pc, depth, count)) {
+					return false;
+				}
+				depth -= count;
+				break;
+			}
+
+			case TOY_OPCODE_INDEX: {
+				int count = routine[pc + 1];
+
+				if (count != 2 && count != 3) {
+					return fail(&state, pc, "Incorrect number of elements found in index");
+				}
+
+				if (!checkDepth(&state, pc, depth, count)) {
+					return false;
+				}
+				depth -= count - 1;
+				break;
+			}
+
+			case TOY_OPCODE_PASS:
+			case TOY_OPCODE_ERROR:
+			case TOY_OPCODE_EOF:
+			default: {
+				char buffer[64];
+				snprintf(buffer, 64, "Invalid opcode %d found", (int)opcode);
+				return fail(&state, pc, buffer);
+			}
+		}
+
+		//valid code can still push more than the stack allows, such as a long run of expression statements
+		if (depth > (int)TOY_STACK_OVERFLOW) {
+			return fail(&state, pc, "Stack overflow found");
+		}
+
+		pc += length;
+	}
+}
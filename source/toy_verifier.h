@@ -0,0 +1,9 @@
+#pragma once
+
+#include "toy_common.h"
+
+//checks a routine once, before it's run: the header sizes and addresses, each instruction's operands,
+//the jump table and data section entries they refer to, that the stack and scopes never underflow, and that the stack never overflows
+//'length' is how many bytes are readable from 'routine', such as the rest of a mapped file, which the routine's size must fit within
+//on failure, the first problem found is described in 'msg'
+TOY_API bool Toy_verifyRoutine(const unsigned char* routine, unsigned int length, char* msg, unsigned int msgLength);
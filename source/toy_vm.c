@@ -5,7 +5,11 @@
 #include "toy_opcodes.h"
 #include "toy_value.h"
 #include "toy_string.h"
+#include "toy_verifier.h"
+#include "toy_routine.h"
+#include "toy_bytecode.h"
 
+#include <setjmp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,13 +19,13 @@
 	vm->routine[vm->routineCounter++]
 
 #define READ_UNSIGNED_INT(vm) \
-	*((unsigned int*)(vm->routine + readPostfixUtil(&(vm->routineCounter), 4)))
+	*((const unsigned int*)(vm->routine + readPostfixUtil(&(vm->routineCounter), 4)))
 
 #define READ_INT(vm) \
-	*((int*)(vm->routine + readPostfixUtil(&(vm->routineCounter), 4)))
+	*((const int*)(vm->routine + readPostfixUtil(&(vm->routineCounter), 4)))
 
 #define READ_FLOAT(vm) \
-	*((float*)(vm->routine + readPostfixUtil(&(vm->routineCounter), 4)))
+	*((const float*)(vm->routine + readPostfixUtil(&(vm->routineCounter), 4)))
 
 static inline int readPostfixUtil(unsigned int* ptr, int amount) {
 	int ret = *ptr;
@@ -34,8 +38,80 @@ static inline void fixAlignment(Toy_VM* vm) {
 	vm->routineCounter = (vm->routineCounter + 3) & ~0b11;
 }
 
+//access sites are keyed on the instruction word, or on the opcode's byte when there are no words
+static inline unsigned int currentSite(Toy_VM* vm) {
+	return vm->dense ? vm->routineCounter - 1 : (vm->routineCounter - 1) / 4;
+}
+
+//every routine is verified before it's bound, which rules out the branch
+#if defined(__GNUC__) || defined(__clang__)
+	#define UNREACHABLE() __builtin_unreachable()
+#else
+	#define UNREACHABLE()
+#endif
+
+//unwinds back to Toy_runVM(); a NULL message means the error was already reported
+static _Noreturn void panicVM(Toy_VM* vm, const char* msg) {
+	if (msg != NULL) {
+		Toy_error(msg);
+	}
+
+	vm->panic = true;
+	longjmp(vm->panicJump, 1);
+}
+
+//the dense encoding has no padding, and packs the wider operands, see toy_routine.h
+static inline unsigned int readVarint(Toy_VM* vm) {
+	unsigned int value = 0;
+	for (unsigned int shift = 0; ; shift += 7) {
+		unsigned char byte = READ_BYTE(vm);
+
+		//the 5th byte only has 4 bits left to fill, and can't continue
+		if (shift == 28 && byte > 0x0F) {
+			panicVM(vm, "Invalid varint found");
+		}
+
+		value |= (unsigned int)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+}
+
+//the entry number within the jump table, rather than its byte offset
+static inline unsigned int readJumpSlot(Toy_VM* vm, const bool dense) {
+	return dense ? readVarint(vm) : READ_UNSIGNED_INT(vm) / 4;
+}
+
+//the jumps were resolved by relocateRoutine(), and the verifier bounded the slots, so a string operand is one load
+static inline const char* findJumpString(Toy_VM* vm, unsigned int slot) {
+	return vm->strings[slot];
+}
+
+//the instruction bodies take decoded operands, so transpiled routines can share them; see the native functions below
+static Toy_Value readConstant(Toy_VM* vm, unsigned int slot, bool isName, unsigned int len) {
+	//each string is only built once per VM, and shared after that
+	Toy_String** constant = &vm->constants[slot * 2 + isName];
+
+	if (*constant == NULL) {
+		const char* cstring = vm->strings[slot];
+
+		//build a string from the data section
+		if (!isName) {
+			*constant = Toy_createString(&vm->stringBucket, cstring);
+		}
+		else {
+			Toy_ValueType valueType = TOY_VALUE_UNKNOWN;
+
+			*constant = Toy_createNameStringLength(&vm->stringBucket, cstring, len, valueType, false);
+		}
+	}
+
+	return TOY_VALUE_FROM_STRING(Toy_copyString(*constant));
+}
+
 //instruction handlers
-static void processRead(Toy_VM* vm) {
+static void processRead(Toy_VM* vm, const bool dense) {
 	Toy_ValueType type = READ_BYTE(vm);
 
 	Toy_Value value = TOY_VALUE_FROM_NULL();
@@ -52,12 +128,26 @@ static void processRead(Toy_VM* vm) {
 		}
 
 		case TOY_VALUE_INTEGER: {
+			if (dense) {
+				unsigned int zigzag = readVarint(vm);
+				value = TOY_VALUE_FROM_INTEGER((int)((zigzag >> 1) ^ -(zigzag & 1)));
+				break;
+			}
+
 			fixAlignment(vm);
 			value = TOY_VALUE_FROM_INTEGER(READ_INT(vm));
 			break;
 		}
 
 		case TOY_VALUE_FLOAT: {
+			if (dense) {
+				float f;
+				memcpy(&f, vm->routine + vm->routineCounter, sizeof(f));
+				vm->routineCounter += sizeof(f);
+				value = TOY_VALUE_FROM_FLOAT(f);
+				break;
+			}
+
 			fixAlignment(vm);
 			value = TOY_VALUE_FROM_FLOAT(READ_FLOAT(vm));
 			break;
@@ -67,25 +157,9 @@ static void processRead(Toy_VM* vm) {
 			enum Toy_StringType stringType = READ_BYTE(vm);
 			int len = (int)READ_BYTE(vm);
 
-			//grab the jump as an integer
-			unsigned int jump = vm->routine[ vm->jumpsAddr + READ_INT(vm) ];
-
-			//jumps are relative to the data address
-			char* cstring = (char*)(vm->routine + vm->dataAddr + jump);
-
-			//build a string from the data section
-			if (stringType == TOY_STRING_LEAF) {
-				value = TOY_VALUE_FROM_STRING(Toy_createString(&vm->stringBucket, cstring));
-			}
-			else if (stringType == TOY_STRING_NAME) {
-				Toy_ValueType valueType = TOY_VALUE_UNKNOWN;
-
-				value = TOY_VALUE_FROM_STRING(Toy_createNameStringLength(&vm->stringBucket, cstring, len, valueType, false));
-			}
-			else {
-				Toy_error("Invalid string type found");
-			}
+			unsigned int slot = readJumpSlot(vm, dense);
 
+			value = readConstant(vm, slot, stringType == TOY_STRING_NAME, len);
 			break;
 		}
 
@@ -124,90 +198,195 @@ static void processRead(Toy_VM* vm) {
 			// break;
 		}
 
-		default:
-			fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid value type %d found, exiting\n" TOY_CC_RESET, type);
-			exit(-1);
+		default: {
+			UNREACHABLE();
+			break;
+		}
 	}
 
 	//push onto the stack
 	Toy_pushStack(&vm->stack, value);
 
 	//leave the counter in a good spot
-	fixAlignment(vm);
+	if (!dense) {
+		fixAlignment(vm);
+	}
 }
 
-static void processDeclare(Toy_VM* vm) {
-	Toy_ValueType type = READ_BYTE(vm); //variable type
-	unsigned int len = READ_BYTE(vm); //name length
-	bool constant = READ_BYTE(vm); //constness
+//keyed on the instruction word, so each access site remembers its own variable; sites sharing a slot evict each other
+static inline Toy_TableEntry* probeCache(Toy_VM* vm, unsigned int site, bool forWrite) {
+	Toy_InlineCache* cache = &vm->caches[site & vm->cacheMask];
 
-	//grab the jump
-	unsigned int jump = *(unsigned int*)(vm->routine + vm->jumpsAddr + READ_INT(vm));
+	//writes can't go through a table or path shared with a copied scope
+	if (cache->site == site && cache->scope == vm->scope && cache->version == vm->scopeVersion && (!forWrite || (cache->guard != NULL && *cache->guard == cache->guardValue))) {
+		vm->stats.cacheHits++;
+		return cache->entry;
+	}
 
-	//grab the data
-	char* cstring = (char*)(vm->routine + vm->dataAddr + jump);
+	return NULL;
+}
+
+static Toy_TableEntry* fillCache(Toy_VM* vm, unsigned int site, Toy_String* name, bool forWrite) {
+	Toy_InlineCache* cache = &vm->caches[site & vm->cacheMask];
+
+	vm->stats.cacheMisses++;
+
+	Toy_ScopeGuard guard = { NULL, 0, false };
+	Toy_TableEntry* entry = Toy_private_findScopeEntry(vm->scope, name, forWrite, &guard);
+
+	if (guard.copied) {
+		vm->scopeVersion++; //the other caches may still point into the shared table or path
+	}
+
+	//don't cache misses, so the error is still raised by the scope
+	if (entry != NULL) {
+		cache->site = site;
+		cache->scope = vm->scope;
+		cache->entry = entry;
+		cache->guard = guard.counter;
+		cache->guardValue = guard.value;
+		cache->version = vm->scopeVersion;
+	}
+
+	return entry;
+}
 
+static Toy_TableEntry* lookupCachedEntry(Toy_VM* vm, unsigned int site, Toy_String* name, bool forWrite) {
+	Toy_TableEntry* entry = probeCache(vm, site, forWrite);
+	return entry != NULL ? entry : fillCache(vm, site, name, forWrite);
+}
+
+static void declareName(Toy_VM* vm, Toy_ValueType type, unsigned int len, bool constant, const char* cstring) {
 	//build the name string
 	Toy_String* name = Toy_createNameStringLength(&vm->stringBucket, cstring, len, type, constant);
 
 	//get the value
 	Toy_Value value = Toy_popStack(&vm->stack);
 
-	//declare it
-	Toy_declareScope(vm->scope, name, value);
+	//declare it, which may shadow or move existing entries
+	bool declared = Toy_declareScope(vm->scope, name, value);
+	vm->scopeVersion++;
 
 	//cleanup
 	Toy_freeString(name);
+
+	if (!declared) {
+		panicVM(vm, NULL);
+	}
 }
 
-static void processAssign(Toy_VM* vm) {
+static void processDeclare(Toy_VM* vm, const bool dense) {
+	Toy_ValueType type = READ_BYTE(vm); //variable type
+	unsigned int len = READ_BYTE(vm); //name length
+	bool constant = READ_BYTE(vm); //constness
+
+	//grab the data
+	const char* cstring = findJumpString(vm, readJumpSlot(vm, dense));
+
+	declareName(vm, type, len, constant, cstring);
+}
+
+//the site is the assignment's own, for the instructions taking their name from the stack
+static void processAssign(Toy_VM* vm, unsigned int site) {
 	//get the value & name
 	Toy_Value value = Toy_popStack(&vm->stack);
 	Toy_Value name = Toy_popStack(&vm->stack);
 
 	//check name string type
 	if (!TOY_VALUE_IS_STRING(name) && TOY_VALUE_AS_STRING(name)->type != TOY_STRING_NAME) {
-		Toy_error("Invalid assignment target");
-		return;
+		panicVM(vm, "Invalid assignment target");
 	}
 
 	//assign it
-	Toy_assignScope(vm->scope, TOY_VALUE_AS_STRING(name), value);
+	Toy_TableEntry* entry = lookupCachedEntry(vm, site, TOY_VALUE_AS_STRING(name), true);
+	bool assigned = entry != NULL ? Toy_private_assignScopeEntry(entry, TOY_VALUE_AS_STRING(name), value) : Toy_assignScope(vm->scope, TOY_VALUE_AS_STRING(name), value);
 
 	//cleanup
 	Toy_freeValue(name);
+
+	if (!assigned) {
+		panicVM(vm, NULL);
+	}
+}
+
+static void accessName(Toy_VM* vm, unsigned int site, unsigned int len, const char* cstring) {
+	//only build the name when the cache misses, and never in the bucket
+	Toy_TableEntry* entry = probeCache(vm, site, false);
+	Toy_Value value = TOY_VALUE_FROM_NULL();
+
+	if (entry != NULL) {
+		value = entry->value;
+	}
+	else {
+		_Alignas(Toy_String) char buffer[sizeof(Toy_String) + 256]; //names are at most 255 chars
+		Toy_String* name = Toy_private_initNameStringInBuffer(buffer, cstring, len);
+
+		entry = fillCache(vm, site, name, false);
+
+		if (entry == NULL) {
+			Toy_accessScope(vm->scope, name); //reports the error
+			panicVM(vm, NULL);
+		}
+
+		value = entry->value;
+	}
+
+	Toy_pushStack(&vm->stack, Toy_copyValue(value));
+}
+
+static void processAccess(Toy_VM* vm, const bool dense) {
+	unsigned int site = currentSite(vm); //before the operands are read
+	unsigned int len = READ_BYTE(vm); //name length
+
+	if (!dense) {
+		fixAlignment(vm);
+	}
+
+	//grab the data
+	const char* cstring = findJumpString(vm, readJumpSlot(vm, dense));
+
+	accessName(vm, site, len, cstring);
 }
 
-static void processAccess(Toy_VM* vm) {
+//the squeezed form, used by compound assignments which still need the name on the stack afterwards
+static void processAccessFromStack(Toy_VM* vm, unsigned int site) {
 	Toy_Value name = Toy_popStack(&vm->stack);
 
 	//check name string type
 	if (!TOY_VALUE_IS_STRING(name) && TOY_VALUE_AS_STRING(name)->type != TOY_STRING_NAME) {
-		Toy_error("Invalid access target");
-		return;
+		panicVM(vm, "Invalid access target");
 	}
 
 	//find and push the value
-	Toy_Value value = Toy_accessScope(vm->scope, TOY_VALUE_AS_STRING(name));
-	Toy_pushStack(&vm->stack, Toy_copyValue(value));
+	Toy_TableEntry* entry = lookupCachedEntry(vm, site, TOY_VALUE_AS_STRING(name), false);
+
+	if (entry == NULL) {
+		Toy_accessScope(vm->scope, TOY_VALUE_AS_STRING(name)); //reports the error
+		panicVM(vm, NULL);
+	}
+
+	Toy_pushStack(&vm->stack, Toy_copyValue(entry->value));
 
 	//cleanup
 	Toy_freeValue(name);
 }
 
-static void processDuplicate(Toy_VM* vm) {
-	Toy_Value value = Toy_copyValue(Toy_peekStack(&vm->stack));
-	Toy_pushStack(&vm->stack, value);
-	Toy_freeValue(value);
+static void duplicateTop(Toy_VM* vm, bool access, unsigned int site) {
+	//the stack owns the copy, which shares the original's string
+	Toy_pushStack(&vm->stack, Toy_copyValue(Toy_peekStack(&vm->stack)));
 
 	//check for compound assignments
-	Toy_OpcodeType squeezed = READ_BYTE(vm);
-	if (squeezed == TOY_OPCODE_ACCESS) {
-		processAccess(vm);
+	if (access) {
+		processAccessFromStack(vm, site);
 	}
 }
 
-static void processArithmetic(Toy_VM* vm, Toy_OpcodeType opcode) {
+static void processDuplicate(Toy_VM* vm) {
+	Toy_OpcodeType squeezed = READ_BYTE(vm);
+	duplicateTop(vm, squeezed == TOY_OPCODE_ACCESS, currentSite(vm));
+}
+
+static void applyArithmetic(Toy_VM* vm, Toy_OpcodeType opcode) {
 	Toy_Value right = Toy_popStack(&vm->stack);
 	Toy_Value left = Toy_popStack(&vm->stack);
 
@@ -215,28 +394,25 @@ static void processArithmetic(Toy_VM* vm, Toy_OpcodeType opcode) {
 	if ((!TOY_VALUE_IS_INTEGER(left) && !TOY_VALUE_IS_FLOAT(left)) || (!TOY_VALUE_IS_INTEGER(right) && !TOY_VALUE_IS_FLOAT(right))) {
 		char buffer[256];
 		snprintf(buffer, 256, "Invalid types '%s' and '%s' passed in arithmetic", Toy_private_getValueTypeAsCString(left.type), Toy_private_getValueTypeAsCString(right.type));
-		Toy_error(buffer);
 		Toy_freeValue(left);
 		Toy_freeValue(right);
-		return;
+		panicVM(vm, buffer);
 	}
 
 	//check for divide by zero
 	if (opcode == TOY_OPCODE_DIVIDE || opcode == TOY_OPCODE_MODULO) {
 		if ((TOY_VALUE_IS_INTEGER(right) && TOY_VALUE_AS_INTEGER(right) == 0) || (TOY_VALUE_IS_FLOAT(right) && TOY_VALUE_AS_FLOAT(right) == 0)) {
-			Toy_error("Can't divide or modulo by zero");
 			Toy_freeValue(left);
 			Toy_freeValue(right);
-			return;
+			panicVM(vm, "Can't divide or modulo by zero");
 		}
 	}
 
 	//check for modulo by a float
 	if (opcode == TOY_OPCODE_MODULO && TOY_VALUE_IS_FLOAT(right)) {
-		Toy_error("Can't modulo by a float");
 		Toy_freeValue(left);
 		Toy_freeValue(right);
-		return;
+		panicVM(vm, "Can't modulo by a float");
 	}
 
 	//coerce ints into floats if needed
@@ -267,21 +443,26 @@ static void processArithmetic(Toy_VM* vm, Toy_OpcodeType opcode) {
 		result = TOY_VALUE_FROM_INTEGER( TOY_VALUE_AS_INTEGER(left) % TOY_VALUE_AS_INTEGER(right) );
 	}
 	else {
-		fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid opcode %d passed to processArithmetic, exiting\n" TOY_CC_RESET, opcode);
-		exit(-1);
+		char buffer[256];
+		snprintf(buffer, 256, "Invalid opcode %d passed to processArithmetic", opcode);
+		panicVM(vm, buffer);
 	}
 
 	//finally
 	Toy_pushStack(&vm->stack, result);
+}
+
+static void processArithmetic(Toy_VM* vm, Toy_OpcodeType opcode) {
+	applyArithmetic(vm, opcode);
 
 	//check for compound assignments
 	Toy_OpcodeType squeezed = READ_BYTE(vm);
 	if (squeezed == TOY_OPCODE_ASSIGN) {
-		processAssign(vm);
+		processAssign(vm, currentSite(vm));
 	}
 }
 
-static void processComparison(Toy_VM* vm, Toy_OpcodeType opcode) {
+static void compareTop(Toy_VM* vm, Toy_OpcodeType opcode, bool negate) {
 	Toy_Value right = Toy_popStack(&vm->stack);
 	Toy_Value left = Toy_popStack(&vm->stack);
 
@@ -289,8 +470,7 @@ static void processComparison(Toy_VM* vm, Toy_OpcodeType opcode) {
 	if (opcode == TOY_OPCODE_COMPARE_EQUAL) {
 		bool equal = Toy_checkValuesAreEqual(left, right);
 
-		//equality has an optional "negate" opcode within it's word
-		if (READ_BYTE(vm) != TOY_OPCODE_NEGATE) {
+		if (!negate) {
 			Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(equal) );
 		}
 		else {
@@ -303,10 +483,9 @@ static void processComparison(Toy_VM* vm, Toy_OpcodeType opcode) {
 	if (Toy_checkValuesAreComparable(left, right) == false) {
 		char buffer[256];
 		snprintf(buffer, 256, "Can't compare value types '%s' and '%s'", Toy_private_getValueTypeAsCString(left.type), Toy_private_getValueTypeAsCString(right.type));
-		Toy_error(buffer);
 		Toy_freeValue(left);
 		Toy_freeValue(right);
-		return;
+		panicVM(vm, buffer);
 	}
 
 	//get the comparison
@@ -332,6 +511,12 @@ static void processComparison(Toy_VM* vm, Toy_OpcodeType opcode) {
 	}
 }
 
+static void processComparison(Toy_VM* vm, Toy_OpcodeType opcode) {
+	//equality has an optional "negate" opcode within its word
+	bool negate = opcode == TOY_OPCODE_COMPARE_EQUAL && READ_BYTE(vm) == TOY_OPCODE_NEGATE;
+	compareTop(vm, opcode, negate);
+}
+
 static void processLogical(Toy_VM* vm, Toy_OpcodeType opcode) {
 	if (opcode == TOY_OPCODE_AND) {
 		Toy_Value right = Toy_popStack(&vm->stack);
@@ -356,30 +541,25 @@ static void processLogical(Toy_VM* vm, Toy_OpcodeType opcode) {
 		Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN( !Toy_checkValueIsTruthy(top) ));
 	}
 	else {
-		fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid opcode %d passed to processLogical, exiting\n" TOY_CC_RESET, opcode);
-		exit(-1);
+		char buffer[256];
+		snprintf(buffer, 256, "Invalid opcode %d passed to processLogical", opcode);
+		panicVM(vm, buffer);
 	}
 }
 
-static void processAssert(Toy_VM* vm) {
-	unsigned int count = READ_BYTE(vm);
-
+static void assertTop(Toy_VM* vm, unsigned int count) {
 	Toy_Value value = TOY_VALUE_FROM_NULL();
 	Toy_Value message = TOY_VALUE_FROM_NULL();
 
-	//determine the args
+	//determine the args, the verifier only allows 1 or 2
 	if (count == 1) {
 		message = TOY_VALUE_FROM_STRING(Toy_createString(&vm->stringBucket, "assertion failed"));
 		value = Toy_popStack(&vm->stack);
 	}
-	else if (count == 2) {
+	else {
 		message = Toy_popStack(&vm->stack);
 		value = Toy_popStack(&vm->stack);
 	}
-	else {
-		fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid assert argument count %d found, exiting\n" TOY_CC_RESET, (int)count);
-		exit(-1);
-	}
 
 	//do the check
 	if (TOY_VALUE_IS_NULL(value) || Toy_checkValueIsTruthy(value) == false) {
@@ -392,6 +572,10 @@ static void processAssert(Toy_VM* vm) {
 	Toy_freeValue(message);
 }
 
+static void processAssert(Toy_VM* vm) {
+	assertTop(vm, READ_BYTE(vm));
+}
+
 static void processPrint(Toy_VM* vm) {
 	//print the value on top of the stack, popping it
 	Toy_Value value = Toy_popStack(&vm->stack);
@@ -399,13 +583,21 @@ static void processPrint(Toy_VM* vm) {
 	Toy_freeValue(value);
 }
 
+static void processYield(Toy_VM* vm) {
+	//hand the value on top of the stack to the host, leaving everything else for the resume
+	Toy_freeValue(vm->yieldValue);
+	vm->yieldValue = Toy_popStack(&vm->stack);
+	vm->suspended = true;
+}
+
 static void processConcat(Toy_VM* vm) {
 	Toy_Value right = Toy_popStack(&vm->stack);
 	Toy_Value left = Toy_popStack(&vm->stack);
 
 	if (!TOY_VALUE_IS_STRING(left) || !TOY_VALUE_IS_STRING(right)) {
-		Toy_error("Failed to concatenate a value that is not a string");
-		return;
+		Toy_freeValue(left);
+		Toy_freeValue(right);
+		panicVM(vm, "Failed to concatenate a value that is not a string");
 	}
 
 	//all good
@@ -413,45 +605,39 @@ static void processConcat(Toy_VM* vm) {
 	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_STRING(result));
 }
 
-static void processIndex(Toy_VM* vm) {
-	unsigned char count = READ_BYTE(vm); //value[index, length] ; 1[2, 3]
+static void indexTop(Toy_VM* vm, unsigned int count) {
+	//value[index, length] ; 1[2, 3]
 
 	Toy_Value value = TOY_VALUE_FROM_NULL();
 	Toy_Value index = TOY_VALUE_FROM_NULL();
 	Toy_Value length = TOY_VALUE_FROM_NULL();
 
+	//the verifier only allows 2 or 3
 	if (count == 3) {
 		length = Toy_popStack(&vm->stack);
 		index = Toy_popStack(&vm->stack);
 		value = Toy_popStack(&vm->stack);
 	}
-	else if (count == 2) {
+	else {
 		index = Toy_popStack(&vm->stack);
 		value = Toy_popStack(&vm->stack);
 	}
-	else {
-		Toy_error("Incorrect number of elements found in index");
-		//TODO: clear stack
-		return;
-	}
 
 	//process based on value's type
 	if (TOY_VALUE_IS_STRING(value)) {
 		//type checks
 		if (!TOY_VALUE_IS_INTEGER(index)) {
-			Toy_error("Failed to index a string");
 			Toy_freeValue(value);
 			Toy_freeValue(index);
 			Toy_freeValue(length);
-			return;
+			panicVM(vm, "Failed to index a string");
 		}
 
 		if (!(TOY_VALUE_IS_NULL(length) || TOY_VALUE_IS_INTEGER(length))) {
-			Toy_error("Failed to index-length a string");
 			Toy_freeValue(value);
 			Toy_freeValue(index);
 			Toy_freeValue(length);
-			return;
+			panicVM(vm, "Failed to index-length a string");
 		}
 
 		//extract values
@@ -473,8 +659,7 @@ static void processIndex(Toy_VM* vm) {
 			free(cstr);
 		}
 		else {
-			fprintf(stderr, TOY_CC_ERROR "ERROR: Unknown string type found in processIndex, exiting\n" TOY_CC_RESET);
-			exit(-1);
+			panicVM(vm, "Unknown string type found in processIndex");
 		}
 
 		//finally
@@ -482,8 +667,12 @@ static void processIndex(Toy_VM* vm) {
 	}
 
 	else {
-		fprintf(stderr, TOY_CC_ERROR "ERROR: Unknown value type '%s' found in processIndex, exiting\n" TOY_CC_RESET, Toy_private_getValueTypeAsCString(value.type));
-		exit(-1);
+		char buffer[256];
+		snprintf(buffer, 256, "Unknown value type '%s' found in processIndex", Toy_private_getValueTypeAsCString(value.type));
+		Toy_freeValue(value);
+		Toy_freeValue(index);
+		Toy_freeValue(length);
+		panicVM(vm, buffer);
 	}
 
 	Toy_freeValue(value);
@@ -491,98 +680,259 @@ static void processIndex(Toy_VM* vm) {
 	Toy_freeValue(length);
 }
 
-static void process(Toy_VM* vm) {
-	while(true) {
-		//prep by aligning to the 4-byte word
+static void processIndex(Toy_VM* vm) {
+	indexTop(vm, READ_BYTE(vm));
+}
+
+//executes one instruction, returning false when the routine is finished or yields
+//NOTE: 'dense' is always a constant, so each caller gets its own copy with or without the padding
+static inline bool step(Toy_VM* vm, const bool dense) {
+	//prep by aligning to the 4-byte word
+	if (!dense) {
 		fixAlignment(vm);
+	}
 
-		Toy_OpcodeType opcode = READ_BYTE(vm);
+	Toy_OpcodeType opcode = READ_BYTE(vm);
 
-		switch(opcode) {
-			//variable instructions
-			case TOY_OPCODE_READ:
-				processRead(vm);
-				break;
+	switch(opcode) {
+		//variable instructions
+		case TOY_OPCODE_READ:
+			processRead(vm, dense);
+			break;
 
-			case TOY_OPCODE_DECLARE:
-				processDeclare(vm);
-				break;
+		case TOY_OPCODE_DECLARE:
+			processDeclare(vm, dense);
+			break;
 
-			case TOY_OPCODE_ASSIGN:
-				processAssign(vm);
-				break;
+		case TOY_OPCODE_ASSIGN:
+			processAssign(vm, currentSite(vm));
+			break;
 
-			case TOY_OPCODE_ACCESS:
-				processAccess(vm);
-				break;
+		case TOY_OPCODE_ACCESS:
+			processAccess(vm, dense);
+			break;
 
-			case TOY_OPCODE_DUPLICATE:
-				processDuplicate(vm);
-				break;
+		case TOY_OPCODE_DUPLICATE:
+			processDuplicate(vm);
+			break;
 
-			//arithmetic instructions
-			case TOY_OPCODE_ADD:
-			case TOY_OPCODE_SUBTRACT:
-			case TOY_OPCODE_MULTIPLY:
-			case TOY_OPCODE_DIVIDE:
-			case TOY_OPCODE_MODULO:
-				processArithmetic(vm, opcode);
-				break;
+		//arithmetic instructions
+		case TOY_OPCODE_ADD:
+		case TOY_OPCODE_SUBTRACT:
+		case TOY_OPCODE_MULTIPLY:
+		case TOY_OPCODE_DIVIDE:
+		case TOY_OPCODE_MODULO:
+			processArithmetic(vm, opcode);
+			break;
 
-			//comparison instructions
-			case TOY_OPCODE_COMPARE_EQUAL:
-			case TOY_OPCODE_COMPARE_LESS:
-			case TOY_OPCODE_COMPARE_LESS_EQUAL:
-			case TOY_OPCODE_COMPARE_GREATER:
-			case TOY_OPCODE_COMPARE_GREATER_EQUAL:
-				processComparison(vm, opcode);
-				break;
+		//comparison instructions
+		case TOY_OPCODE_COMPARE_EQUAL:
+		case TOY_OPCODE_COMPARE_LESS:
+		case TOY_OPCODE_COMPARE_LESS_EQUAL:
+		case TOY_OPCODE_COMPARE_GREATER:
+		case TOY_OPCODE_COMPARE_GREATER_EQUAL:
+			processComparison(vm, opcode);
+			break;
 
-			//logical instructions
-			case TOY_OPCODE_AND:
-			case TOY_OPCODE_OR:
-			case TOY_OPCODE_TRUTHY:
-			case TOY_OPCODE_NEGATE:
-				processLogical(vm, opcode);
-				break;
+		//logical instructions
+		case TOY_OPCODE_AND:
+		case TOY_OPCODE_OR:
+		case TOY_OPCODE_TRUTHY:
+		case TOY_OPCODE_NEGATE:
+			processLogical(vm, opcode);
+			break;
 
-			//control instructions
-			case TOY_OPCODE_RETURN:
-				//temp terminator
-				return;
+		//control instructions
+		case TOY_OPCODE_RETURN:
+			//temp terminator
+			return false;
 
-			case TOY_OPCODE_SCOPE_PUSH:
-				vm->scope = Toy_pushScope(&vm->scopeBucket, vm->scope);
-				break;
+		case TOY_OPCODE_YIELD:
+			processYield(vm);
+			return false;
 
-			case TOY_OPCODE_SCOPE_POP:
-				vm->scope = Toy_popScope(vm->scope);
-				break;
+		case TOY_OPCODE_SCOPE_PUSH:
+			vm->scope = Toy_pushScope(&vm->scopeBucket, vm->scope);
+			break;
 
-			//various action instructions
-			case TOY_OPCODE_ASSERT:
-				processAssert(vm);
-				break;
+		case TOY_OPCODE_SCOPE_POP:
+			vm->scope = Toy_popScope(vm->scope);
+			vm->scopeVersion++; //the popped table may be recycled
+			break;
 
-			case TOY_OPCODE_PRINT:
-				processPrint(vm);
-				break;
+		//various action instructions
+		case TOY_OPCODE_ASSERT:
+			processAssert(vm);
+			break;
 
-			case TOY_OPCODE_CONCAT:
-				processConcat(vm);
-				break;
+		case TOY_OPCODE_PRINT:
+			processPrint(vm);
+			break;
 
-			case TOY_OPCODE_INDEX:
-				processIndex(vm);
-				break;
+		case TOY_OPCODE_CONCAT:
+			processConcat(vm);
+			break;
 
-			case TOY_OPCODE_PASS:
-			case TOY_OPCODE_ERROR:
-			case TOY_OPCODE_EOF:
-				fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid opcode %d found, exiting\n" TOY_CC_RESET, opcode);
-				exit(-1);
+		case TOY_OPCODE_INDEX:
+			processIndex(vm);
+			break;
+
+		case TOY_OPCODE_PASS:
+		case TOY_OPCODE_ERROR:
+		case TOY_OPCODE_EOF:
+		default: {
+			UNREACHABLE();
+			return false;
 		}
 	}
+
+	return true;
+}
+
+//the budget is checked once per instruction, so only the budgeted runs pay for it
+static inline bool processSteps(Toy_VM* vm, unsigned int budget, const bool dense) {
+	if (budget == 0) {
+		while (step(vm, dense)) /* */;
+		return true;
+	}
+
+	while (budget-- > 0) {
+		if (!step(vm, dense)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//returns false when the budget ran out first
+static bool process(Toy_VM* vm, unsigned int budget) {
+	//transpiled routines run to their next yield or return in one call, so the budget doesn't apply
+	if (vm->native != NULL) {
+		vm->native->run(vm);
+		return true;
+	}
+
+	return vm->dense ? processSteps(vm, budget, true) : processSteps(vm, budget, false);
+}
+
+//one pointer per string, and room for the constants built from them
+static void allocateConstants(Toy_VM* vm, unsigned int stringCount) {
+	free(vm->strings);
+	free(vm->constants);
+
+	vm->stringCount = stringCount;
+	vm->strings = malloc((vm->stringCount > 0 ? vm->stringCount : 1) * sizeof(const char*));
+
+	//filled in as the strings are first read
+	vm->constantCount = vm->stringCount * 2;
+	vm->constants = calloc(vm->constantCount > 0 ? vm->constantCount : 1, sizeof(Toy_String*));
+
+	if (vm->strings == NULL || vm->constants == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate the constants for a routine of %d strings\n" TOY_CC_RESET, (int)stringCount);
+		exit(1);
+	}
+}
+
+//resolves each jump to a pointer into the data section once, instead of on every read
+static void relocateRoutine(Toy_VM* vm) {
+	allocateConstants(vm, vm->jumpsSize / 4);
+
+	for (unsigned int i = 0; i < vm->stringCount; i++) {
+		unsigned int jump;
+		memcpy(&jump, vm->routine + vm->jumpsAddr + i * 4, sizeof(jump));
+
+		//jumps are relative to the data address
+		vm->strings[i] = (const char*)(vm->routine + vm->dataAddr + jump);
+	}
+}
+
+static void allocateMemory(Toy_VM* vm) {
+	//allocate the stack, scope, and memory, keeping whatever an earlier bind left
+	if (vm->stringBucket == NULL) {
+		vm->stringBucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+	}
+	if (vm->scopeBucket == NULL) {
+		vm->scopeBucket = Toy_allocateBucket(TOY_BUCKET_SMALL);
+	}
+	if (vm->stack == NULL) {
+		vm->stack = Toy_allocateStack();
+	}
+	if (vm->scope == NULL) {
+		//only allocate a new top-level scope when needed, otherwise REPL will break
+		vm->scope = Toy_pushScope(&vm->scopeBucket, NULL);
+		vm->scope->pool = &vm->tablePool; //inherited by the inner scopes
+	}
+}
+
+//only a fraction of the sites access a variable, so the side table is smaller than the routine
+static void allocateCaches(Toy_VM* vm, unsigned int siteCount) {
+	unsigned int cacheCount = 16;
+	while (cacheCount < siteCount / TOY_VM_CACHE_SPREAD) {
+		cacheCount *= 2;
+	}
+
+	free(vm->caches);
+	vm->caches = calloc(cacheCount, sizeof(Toy_InlineCache));
+	vm->cacheMask = cacheCount - 1;
+
+	if (vm->caches == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate the inline caches for a routine of %d sites\n" TOY_CC_RESET, (int)siteCount);
+		exit(1);
+	}
+}
+
+//exposed to transpiled routines, which have already decoded the operands and pass their own site numbers
+void Toy_private_nativeReadString(Toy_VM* vm, unsigned int slot, bool isName, unsigned int len) {
+	Toy_pushStack(&vm->stack, readConstant(vm, slot, isName, len));
+}
+
+void Toy_private_nativeDeclare(Toy_VM* vm, Toy_ValueType type, unsigned int len, bool constant, unsigned int slot) {
+	declareName(vm, type, len, constant, vm->strings[slot]);
+}
+
+void Toy_private_nativeAssign(Toy_VM* vm, unsigned int site) {
+	processAssign(vm, site);
+}
+
+void Toy_private_nativeAccess(Toy_VM* vm, unsigned int site, unsigned int len, unsigned int slot) {
+	accessName(vm, site, len, vm->strings[slot]);
+}
+
+void Toy_private_nativeDuplicate(Toy_VM* vm, bool access, unsigned int site) {
+	duplicateTop(vm, access, site);
+}
+
+void Toy_private_nativeArithmetic(Toy_VM* vm, Toy_OpcodeType opcode) {
+	applyArithmetic(vm, opcode);
+}
+
+void Toy_private_nativeComparison(Toy_VM* vm, Toy_OpcodeType opcode, bool negate) {
+	compareTop(vm, opcode, negate);
+}
+
+void Toy_private_nativeLogical(Toy_VM* vm, Toy_OpcodeType opcode) {
+	processLogical(vm, opcode);
+}
+
+void Toy_private_nativeAssert(Toy_VM* vm, unsigned int count) {
+	assertTop(vm, count);
+}
+
+void Toy_private_nativePrint(Toy_VM* vm) {
+	processPrint(vm);
+}
+
+void Toy_private_nativeYield(Toy_VM* vm) {
+	processYield(vm);
+}
+
+void Toy_private_nativeConcat(Toy_VM* vm) {
+	processConcat(vm);
+}
+
+void Toy_private_nativeIndex(Toy_VM* vm, unsigned int count) {
+	indexTop(vm, count);
 }
 
 //exposed functions
@@ -592,42 +942,120 @@ void Toy_initVM(Toy_VM* vm) {
 	vm->scopeBucket = NULL;
 	vm->stack = NULL;
 	vm->scope = NULL;
+	Toy_initTablePool(&vm->tablePool);
+
+	vm->strings = NULL;
+	vm->stringCount = 0;
+	vm->constants = NULL;
+	vm->constantCount = 0;
+	vm->caches = NULL;
+	vm->cacheMask = 0;
+	vm->scopeVersion = 0;
+	vm->stats = (Toy_VMStats){ 0 };
+	vm->yieldValue = TOY_VALUE_FROM_NULL();
+	vm->printContext = (Toy_PrintContext){ 0 };
 
 	Toy_resetVM(vm);
 }
 
-void Toy_bindVM(Toy_VM* vm, unsigned char* bytecode) {
+//false when the image can't be run by this version
+static bool checkBytecodeVersion(Toy_VM* vm, const unsigned char* bytecode) {
 	if (bytecode[0] != TOY_VERSION_MAJOR || bytecode[1] > TOY_VERSION_MINOR) {
-		fprintf(stderr, TOY_CC_ERROR "ERROR: Wrong bytecode version found: expected %d.%d.%d found %d.%d.%d, exiting\n" TOY_CC_RESET, TOY_VERSION_MAJOR, TOY_VERSION_MINOR, TOY_VERSION_PATCH, bytecode[0], bytecode[1], bytecode[2]);
-		exit(-1);
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Wrong bytecode version found: expected %d.%d.%d found %d.%d.%d\n" TOY_CC_RESET, TOY_VERSION_MAJOR, TOY_VERSION_MINOR, TOY_VERSION_PATCH, bytecode[0], bytecode[1], bytecode[2]);
+		vm->panic = true; //until the VM is reset
+		return false;
 	}
 
 	if (bytecode[2] != TOY_VERSION_PATCH) {
 		fprintf(stderr, TOY_CC_WARN "WARNING: Wrong bytecode version found: expected %d.%d.%d found %d.%d.%d, continuing\n" TOY_CC_RESET, TOY_VERSION_MAJOR, TOY_VERSION_MINOR, TOY_VERSION_PATCH, bytecode[0], bytecode[1], bytecode[2]);
 	}
 
-	if (strcmp((char*)(bytecode + 3), TOY_VERSION_BUILD) != 0) {
-		fprintf(stderr, TOY_CC_WARN "WARNING: Wrong bytecode build info found: expected '%s' found '%s', continuing\n" TOY_CC_RESET, TOY_VERSION_BUILD, (char*)(bytecode + 3));
+	//the build info is compared within the header, which holds exactly this version's string
+	if (strncmp((const char*)(bytecode + 3), TOY_VERSION_BUILD, strlen(TOY_VERSION_BUILD) + 1) != 0) {
+		fprintf(stderr, TOY_CC_WARN "WARNING: Wrong bytecode build info found: expected '%s' found '%.*s', continuing\n" TOY_CC_RESET, TOY_VERSION_BUILD, (int)strlen(TOY_VERSION_BUILD), (const char*)(bytecode + 3));
 	}
 
-	//offset by the header size
-	int offset = 3 + strlen(TOY_VERSION_BUILD) + 1;
-	if (offset % 4 != 0) {
-		offset += 4 - (offset % 4); //ceil
+	return true;
+}
+
+//the version header's size, or 0 when the image is too short to hold it and the word after it, or is the wrong version
+static unsigned int readBytecodeHeader(Toy_VM* vm, const unsigned char* bytecode, unsigned int length) {
+	unsigned int offset = Toy_getBytecodeHeaderSize();
+
+	if (length < offset + 4) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Truncated bytecode of %d bytes found\n" TOY_CC_RESET, (int)length);
+		vm->panic = true; //until the VM is reset
+		return 0;
 	}
 
-	//delegate
-	Toy_bindVMToRoutine(vm, bytecode + offset);
+	if (!checkBytecodeVersion(vm, bytecode)) {
+		return 0;
+	}
+
+	return offset;
+}
+
+bool Toy_bindVM(Toy_VM* vm, const unsigned char* bytecode, unsigned int length) {
+	unsigned int offset = readBytecodeHeader(vm, bytecode, length);
+	if (offset == 0) {
+		return false;
+	}
 
 	//cache these
 	vm->bc = bytecode;
+
+	//a bundle runs its first module
+	if (Toy_getBundleModuleCount(bytecode, length) > 0) {
+		const unsigned char* module = Toy_getBundleModule(bytecode, length, 0);
+
+		if (module == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Invalid module offset found in the bundle\n" TOY_CC_RESET);
+			vm->panic = true; //until the VM is reset
+			return false;
+		}
+
+		return Toy_bindVMToRoutine(vm, module, length - (unsigned int)(module - bytecode));
+	}
+
+	//delegate
+	return Toy_bindVMToRoutine(vm, bytecode + offset, length - offset);
 }
 
-void Toy_bindVMToRoutine(Toy_VM* vm, unsigned char* routine) {
+bool Toy_bindVMToModule(Toy_VM* vm, const unsigned char* bytecode, unsigned int length, const char* name) {
+	if (readBytecodeHeader(vm, bytecode, length) == 0) {
+		return false;
+	}
+
+	//only the index is read, the other modules are never touched
+	const unsigned char* module = Toy_findBundleModule(bytecode, length, name);
+
+	if (module == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Module '%s' not found in the bundle\n" TOY_CC_RESET, name);
+		return false;
+	}
+
+	vm->bc = bytecode;
+
+	return Toy_bindVMToRoutine(vm, module, length - (unsigned int)(module - bytecode));
+}
+
+bool Toy_bindVMToRoutine(Toy_VM* vm, const unsigned char* routine, unsigned int length) {
+	//checked once here, instead of on every run; the runtime checks don't cover the header or the code's bounds, so a rejected routine is never run
+	char msg[256];
+
+	if (!Toy_verifyRoutine(routine, length, msg, 256)) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Routine failed verification: %s\n" TOY_CC_RESET, msg);
+		vm->panic = true; //until the VM is reset
+		return false;
+	}
+
 	vm->routine = routine;
+	vm->native = NULL;
 
 	//read the header metadata
 	vm->routineSize = READ_UNSIGNED_INT(vm);
+	vm->dense = (vm->routineSize & TOY_ROUTINE_FLAG_DENSE) != 0;
+	vm->routineSize &= TOY_ROUTINE_SIZE_MASK;
 	vm->paramSize = READ_UNSIGNED_INT(vm);
 	vm->jumpsSize = READ_UNSIGNED_INT(vm);
 	vm->dataSize = READ_UNSIGNED_INT(vm);
@@ -652,35 +1080,98 @@ void Toy_bindVMToRoutine(Toy_VM* vm, unsigned char* routine) {
 		vm->subsAddr = READ_UNSIGNED_INT(vm);
 	}
 
-	//allocate the stack, scope, and memory
-	vm->stringBucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-	vm->scopeBucket = Toy_allocateBucket(TOY_BUCKET_SMALL);
-	vm->stack = Toy_allocateStack();
-	if (vm->scope == NULL) {
-		//only allocate a new top-level scope when needed, otherwise REPL will break
-		vm->scope = Toy_pushScope(&vm->scopeBucket, NULL);
-	}
+	allocateMemory(vm);
+	relocateRoutine(vm);
+
+	//every word could be an access site
+	allocateCaches(vm, vm->routineSize / 4);
+
+	return true;
+}
+
+void Toy_bindVMToNative(Toy_VM* vm, const Toy_NativeRoutine* native) {
+	//the transpiler only accepts verified routines
+	vm->native = native;
+
+	allocateMemory(vm);
+
+	//the strings are already C literals, so there's nothing to relocate
+	allocateConstants(vm, native->stringCount);
+	memcpy(vm->strings, native->strings, native->stringCount * sizeof(const char*));
+
+	allocateCaches(vm, native->siteCount);
+}
+
+Toy_VMStatus Toy_runVM(Toy_VM* vm) {
+	return Toy_runVMFor(vm, 0);
 }
 
-void Toy_runVM(Toy_VM* vm) {
-	//TODO: read params into scope
+Toy_VMStatus Toy_runVMFor(Toy_VM* vm, unsigned int budget) {
+	//a panicked VM needs to be reset first
+	if (vm->panic) {
+		return TOY_VM_STATUS_PANIC;
+	}
+
+	//a yielded VM picks up where it left off
+	if (!vm->suspended) {
+		//TODO: read params into scope
 
-	//prep the routine counter for execution
-	vm->routineCounter = vm->codeAddr;
+		//prep the routine counter for execution
+		vm->routineCounter = vm->codeAddr;
+		vm->entryScope = vm->scope;
+	}
+
+	vm->suspended = false; //set again by a yield, or by running out of budget
+
+	//route this thread's output to the VM's own callbacks, restoring the outer ones when done
+	Toy_PrintContext* outerContext = Toy_swapPrintContext(&vm->printContext);
+
+	//runtime errors land here, so the handlers don't need to check for them
+	if (setjmp(vm->panicJump) != 0) {
+		//drop the blocks and temporaries of the failed run, keeping the outer scope for the next one
+		while (vm->scope != vm->entryScope) {
+			vm->scope = Toy_popScope(vm->scope);
+		}
+		vm->scopeVersion++;
+
+		while (vm->stack->count > 0) {
+			Toy_freeValue(Toy_popStack(&vm->stack));
+		}
+
+		Toy_swapPrintContext(outerContext);
+		return TOY_VM_STATUS_PANIC;
+	}
 
 	//begin
-	process(vm);
+	bool finished = process(vm, budget);
+
+	Toy_swapPrintContext(outerContext);
+
+	if (!finished) {
+		vm->suspended = true;
+		return TOY_VM_STATUS_YIELDED;
+	}
+
+	return vm->suspended ? TOY_VM_STATUS_YIELDED_VALUE : TOY_VM_STATUS_OK;
 }
 
 void Toy_freeVM(Toy_VM* vm) {
+	//the yielded value may point into the buckets
+	Toy_freeValue(vm->yieldValue);
+	vm->yieldValue = TOY_VALUE_FROM_NULL();
+
 	//clear the stack, scope and memory
 	Toy_freeStack(vm->stack);
 	Toy_popScope(vm->scope);
+	Toy_freeTablePool(&vm->tablePool);
 	Toy_freeBucket(&vm->stringBucket);
 	Toy_freeBucket(&vm->scopeBucket);
 
-	//free the bytecode
-	free(vm->bc);
+	//so a later bind allocates them again
+	vm->stack = NULL;
+	vm->scope = NULL;
+
+	//NOTE: the bytecode belongs to the caller
 
 	Toy_resetVM(vm);
 }
@@ -690,6 +1181,7 @@ void Toy_resetVM(Toy_VM* vm) {
 
 	vm->routine = NULL;
 	vm->routineSize = 0;
+	vm->native = NULL;
 
 	vm->paramSize = 0;
 	vm->jumpsSize = 0;
@@ -703,6 +1195,39 @@ void Toy_resetVM(Toy_VM* vm) {
 	vm->subsAddr = 0;
 
 	vm->routineCounter = 0;
+	vm->dense = false;
+
+	vm->panic = false;
+	vm->suspended = false;
+	vm->entryScope = NULL;
+
+	Toy_freeValue(vm->yieldValue);
+	vm->yieldValue = TOY_VALUE_FROM_NULL();
+
+	//the relocations, constants and caches belong to the routine; the strings themselves are in the data section and the bucket
+	free(vm->strings);
+	vm->strings = NULL;
+	vm->stringCount = 0;
+
+	free(vm->constants);
+	vm->constants = NULL;
+	vm->constantCount = 0;
+
+	free(vm->caches);
+	vm->caches = NULL;
+	vm->cacheMask = 0;
 
 	//NOTE: stack, scope and memory are not altered during resets
 }
+
+void Toy_setVMPrintContext(Toy_VM* vm, Toy_PrintContext context) {
+	vm->printContext = context;
+}
+
+Toy_VMStats Toy_getVMStats(Toy_VM* vm) {
+	return vm->stats;
+}
+
+void Toy_invalidateVMCaches(Toy_VM* vm) {
+	vm->scopeVersion++;
+}
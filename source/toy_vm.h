@@ -5,13 +5,49 @@
 #include "toy_bucket.h"
 #include "toy_stack.h"
 #include "toy_scope.h"
+#include "toy_print.h"
+#include "toy_opcodes.h"
+
+#include <setjmp.h>
+
+//remembers where a variable was found the last time an access site ran
+typedef struct Toy_InlineCache {      //32 | 64 BITNESS
+	Toy_Scope* scope;                 //4  | 8
+	Toy_TableEntry* entry;            //4  | 8
+	const unsigned int* guard;        //4  | 8
+	unsigned int guardValue;          //4  | 4
+	unsigned int version;             //4  | 4
+	unsigned int site;                //4  | 4
+} Toy_InlineCache;                    //24 | 40
+
+typedef struct Toy_VMStats {
+	unsigned int cacheHits;
+	unsigned int cacheMisses;
+} Toy_VMStats;
+
+typedef enum Toy_VMStatus {
+	TOY_VM_STATUS_OK,
+	TOY_VM_STATUS_PANIC, //a runtime error was reported through Toy_error()
+	TOY_VM_STATUS_YIELDED, //out of budget, the next run resumes from the same instruction
+	TOY_VM_STATUS_YIELDED_VALUE, //the script used 'yield', the next run resumes after it
+} Toy_VMStatus;
+
+struct Toy_VM;
+
+//a routine transpiled to C by Toy_transpileBytecode(), run in place of the bytecode
+typedef struct Toy_NativeRoutine {
+	void (*run)(struct Toy_VM* vm); //resumes from vm->routineCounter, which is 0 at the start and set by each yield
+	const char** strings; //the routine's jump table, already resolved
+	unsigned int stringCount;
+	unsigned int siteCount; //sites are numbered from 0, and key the inline caches
+} Toy_NativeRoutine;
 
 typedef struct Toy_VM {
-	//hold the raw bytecode
-	unsigned char* bc;
+	//the raw bytecode, borrowed from the caller - it's never written to, so one image can be shared by any number of VMs
+	const unsigned char* bc;
 
 	//raw instructions to be executed
-	unsigned char* routine;
+	const unsigned char* routine;
 	unsigned int routineSize;
 
 	unsigned int paramSize;
@@ -27,6 +63,12 @@ typedef struct Toy_VM {
 
 	unsigned int routineCounter;
 
+	//set by Toy_bindVMToNative() instead of the routine
+	const Toy_NativeRoutine* native;
+
+	//set at bind time from the routine's size word, see TOY_ROUTINE_FLAG_DENSE
+	bool dense;
+
 	//stack - immediate-level values only
 	Toy_Stack* stack;
 
@@ -36,17 +78,72 @@ typedef struct Toy_VM {
 	//easy access to memory
 	Toy_Bucket* stringBucket; //stores the string literals
 	Toy_Bucket* scopeBucket; //stores the scopes
+	Toy_TablePool tablePool; //recycles the scopes' tables
+
+	//each jump resolved to its string in the data section at bind time, so the instructions skip the jump table
+	const char** strings;
+	unsigned int stringCount;
 
-	//TODO: panic flag
+	//the string literals and names read so far, two per jump (leaf, then name), each holding one reference
+	Toy_String** constants;
+	unsigned int constantCount;
+
+	//variable lookups, invalidated by bumping the version whenever a scope's shape changes
+	//NOTE: this is the VM's side table for the shared routine, direct-mapped by the access site's instruction word (or byte, when dense)
+	Toy_InlineCache* caches;
+	unsigned int cacheMask;
+	unsigned int scopeVersion;
+
+	Toy_VMStats stats;
+
+	//runtime errors unwind to Toy_runVM(), leaving the flag set until the VM is reset
+	bool panic;
+	jmp_buf panicJump;
+
+	//set between a yield and the run that resumes it
+	bool suspended;
+	Toy_Scope* entryScope; //where a panic unwinds to
+	Toy_Value yieldValue; //owned by the VM until the next yield, copy it to keep it longer
+
+	//output for this VM only, installed on the running thread by Toy_runVM()
+	Toy_PrintContext printContext;
 } Toy_VM;
 
 TOY_API void Toy_initVM(Toy_VM* vm);
-TOY_API void Toy_bindVM(Toy_VM* vm, unsigned char* bytecode); //process the version data
-TOY_API void Toy_bindVMToRoutine(Toy_VM* vm, unsigned char* routine); //process the routine only
+TOY_API bool Toy_bindVM(Toy_VM* vm, const unsigned char* bytecode, unsigned int length); //process the version data; the bytecode must outlive the VM, which never frees it; false if it's truncated or the routine fails verification
+TOY_API bool Toy_bindVMToModule(Toy_VM* vm, const unsigned char* bytecode, unsigned int length, const char* name); //one module of a bundle, verified and relocated on its own; false if it's missing or fails verification
+TOY_API bool Toy_bindVMToRoutine(Toy_VM* vm, const unsigned char* routine, unsigned int length); //process the routine only, which must fit in 'length' bytes; false if it fails verification, leaving the VM panicked until it's reset
+TOY_API void Toy_bindVMToNative(Toy_VM* vm, const Toy_NativeRoutine* native); //run transpiled C instead of bytecode; budgets are ignored, but yields still suspend it
 
-TOY_API void Toy_runVM(Toy_VM* vm);
+TOY_API Toy_VMStatus Toy_runVM(Toy_VM* vm); //runs to completion, resuming a yielded VM
+TOY_API Toy_VMStatus Toy_runVMFor(Toy_VM* vm, unsigned int budget); //runs at most 'budget' instructions, 0 for no limit
 TOY_API void Toy_freeVM(Toy_VM* vm);
 
 TOY_API void Toy_resetVM(Toy_VM* vm); //prepares for another run without deleting stack, scope and memory
 
+TOY_API void Toy_setVMPrintContext(Toy_VM* vm, Toy_PrintContext context); //NULL callbacks use the global ones
+
+TOY_API Toy_VMStats Toy_getVMStats(Toy_VM* vm);
+TOY_API void Toy_invalidateVMCaches(Toy_VM* vm); //call after modifying the VM's scopes directly
+
 //TODO: inject extra data (hook system for external libraries)
+
+//the instruction bodies, called by the C that Toy_transpileBytecode() writes; the other instructions are inlined there
+TOY_API void Toy_private_nativeReadString(Toy_VM* vm, unsigned int slot, bool isName, unsigned int len);
+TOY_API void Toy_private_nativeDeclare(Toy_VM* vm, Toy_ValueType type, unsigned int len, bool constant, unsigned int slot);
+TOY_API void Toy_private_nativeAssign(Toy_VM* vm, unsigned int site);
+TOY_API void Toy_private_nativeAccess(Toy_VM* vm, unsigned int site, unsigned int len, unsigned int slot);
+TOY_API void Toy_private_nativeDuplicate(Toy_VM* vm, bool access, unsigned int site);
+TOY_API void Toy_private_nativeArithmetic(Toy_VM* vm, Toy_OpcodeType opcode);
+TOY_API void Toy_private_nativeComparison(Toy_VM* vm, Toy_OpcodeType opcode, bool negate);
+TOY_API void Toy_private_nativeLogical(Toy_VM* vm, Toy_OpcodeType opcode);
+TOY_API void Toy_private_nativeAssert(Toy_VM* vm, unsigned int count);
+TOY_API void Toy_private_nativePrint(Toy_VM* vm);
+TOY_API void Toy_private_nativeYield(Toy_VM* vm);
+TOY_API void Toy_private_nativeConcat(Toy_VM* vm);
+TOY_API void Toy_private_nativeIndex(Toy_VM* vm, unsigned int count);
+
+//the side table has one inline cache per this many instruction words, rounded up to a power of 2
+#ifndef TOY_VM_CACHE_SPREAD
+#define TOY_VM_CACHE_SPREAD 4
+#endif
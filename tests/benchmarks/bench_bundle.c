@@ -0,0 +1,109 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void silence(const char* msg, void* userData) {
+	//
+}
+
+static double elapsed(struct timespec start, struct timespec end) {
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s total bundle-size\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//a bundle of 'limit' modules, each a few statements long
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	const char* source = "var a = 1; var b = \"hello\"; a += 2; assert a == 3; print b .. \" world\";";
+	Toy_Ast** modules = malloc(limit * sizeof(Toy_Ast*));
+	char (*names)[32] = malloc(limit * sizeof(*names));
+	const char** namePtrs = malloc(limit * sizeof(char*));
+
+	for (unsigned int i = 0; i < limit; i++) {
+		Toy_Lexer lexer;
+		Toy_bindLexer(&lexer, source);
+		Toy_Parser parser;
+		Toy_bindParser(&parser, &lexer);
+		modules[i] = Toy_scanParser(&bucket, &parser);
+
+		snprintf(names[i], 32, "module%u", i);
+		namePtrs[i] = names[i];
+	}
+
+	Toy_Bytecode bc = Toy_compileBundle(modules, namePtrs, limit, false);
+
+	unsigned int runs = iterations / limit;
+	if (runs == 0) {
+		runs = 1;
+	}
+
+	struct timespec start, end;
+
+	//the last module, so the whole index is scanned
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned int i = 0; i < runs; i++) {
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_setVMPrintContext(&vm, (Toy_PrintContext){ .printCallback = silence, .assertCallback = silence });
+		Toy_bindVMToModule(&vm, bc.ptr, bc.count, names[limit - 1]);
+		Toy_runVM(&vm);
+		Toy_freeVM(&vm);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double lazySeconds = elapsed(start, end);
+
+	//what startup would cost if every module was bound up front
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned int i = 0; i < runs; i++) {
+		for (unsigned int m = 0; m < limit; m++) {
+			Toy_VM vm;
+			Toy_initVM(&vm);
+			const unsigned char* module = Toy_getBundleModule(bc.ptr, bc.count, m);
+			Toy_bindVMToRoutine(&vm, module, bc.count - (unsigned int)(module - bc.ptr));
+			Toy_freeVM(&vm);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double eagerSeconds = elapsed(start, end);
+
+	printf("%u modules in %u bytes\n", limit, bc.count);
+	printf("startup\tus/run\n");
+	printf("one module\t%.2f\n", lazySeconds / runs * 1e6);
+	printf("every module\t%.2f\n", eagerSeconds / runs * 1e6);
+
+	Toy_freeBytecode(bc);
+	Toy_freeBucket(&bucket);
+	free(modules);
+	free(names);
+	free(namePtrs);
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//compile the same tree 'runs' times, returning the seconds taken
+static double run_compile(Toy_Ast* ast, bool dense, unsigned int runs, unsigned int* size) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned int i = 0; i < runs; i++) {
+		Toy_Bytecode bc = dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+		*size = bc.count;
+		Toy_freeBytecode(bc);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s statements statements-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//a generated script of 'limit' statements, only parsed once
+	char* source = malloc(limit * 64 + 32);
+	unsigned int length = sprintf(source, "var a = 0;");
+	for (unsigned int i = 0; i < limit; i++) {
+		length += sprintf(source + length, " { var b%u = a * %u; a += b%u; print \"line\"; }", i % 100, i, i % 100);
+	}
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+
+	unsigned int runs = iterations / limit;
+	if (runs == 0) {
+		runs = 1;
+	}
+
+	printf("encoding\tbytes\tns/statement\n");
+
+	unsigned int size = 0;
+	double aligned = run_compile(ast, false, runs, &size);
+	printf("aligned\t%u\t%.2f\n", size, aligned / runs / limit * 1e9);
+
+	double dense = run_compile(ast, true, runs, &size);
+	printf("dense\t%u\t%.2f\n", size, dense / runs / limit * 1e9);
+
+	Toy_freeBucket(&bucket);
+	free(source);
+
+	return 0;
+}
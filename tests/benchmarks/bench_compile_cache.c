@@ -0,0 +1,94 @@
+//for mkdtemp, rmdir and clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_compile_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SCRIPT_COUNT 100
+
+//compile every script through the cache once, returning the seconds taken
+double run_cache(const char* directory, char** sources) {
+	Toy_CompileCache* cache = Toy_allocateCompileCache(directory);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (int i = 0; i < SCRIPT_COUNT; i++) {
+		Toy_freeBytecode(Toy_compileCached(cache, sources[i], false, false));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	Toy_CompileCacheStats stats = Toy_getCompileCacheStats(cache);
+	printf("%u hits, %u misses, %.3f seconds saved\n", stats.hits, stats.misses, stats.savedSeconds);
+
+	Toy_freeCompileCache(cache);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s statements statements-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//each script is 'limit' statements, and differs from the others by its first line
+	char* sources[SCRIPT_COUNT];
+	for (int s = 0; s < SCRIPT_COUNT; s++) {
+		sources[s] = malloc(limit * 32 + 32);
+		unsigned int length = sprintf(sources[s], "var a = %d;", s);
+		for (unsigned int i = 0; i < limit; i++) {
+			length += sprintf(sources[s] + length, " { var b = a * %u; a += b; }", i);
+		}
+	}
+
+	char directory[] = "/tmp/toy_bench_cache_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		printf("Failed to create a cache directory\n");
+		return -1;
+	}
+
+	//the first pass fills the cache, the rest are warm
+	unsigned int passes = iterations / limit / SCRIPT_COUNT;
+	if (passes < 2) {
+		passes = 2;
+	}
+
+	printf("pass\tseconds\n");
+	for (unsigned int p = 0; p < passes; p++) {
+		double seconds = run_cache(directory, sources);
+		printf("%s\t%.3f\n", p == 0 ? "cold" : "warm", seconds);
+	}
+
+	//cleanup
+	for (int s = 0; s < SCRIPT_COUNT; s++) {
+		char key[32];
+		Toy_private_getCompileCacheKey(key, sources[s], false, false);
+
+		char path[sizeof(directory) + 1 + sizeof(key)];
+		snprintf(path, sizeof(path), "%s/%s", directory, key);
+		remove(path);
+
+		free(sources[s]);
+	}
+
+	rmdir(directory);
+
+	return 0;
+}
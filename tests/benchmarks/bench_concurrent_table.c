@@ -0,0 +1,109 @@
+//for pthreads, sysconf and clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_concurrent_table.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+//utils
+unsigned int hashUInt(unsigned int x) {
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = (x >> 16) ^ x;
+    return x;
+}
+
+typedef struct Worker {
+	pthread_t thread;
+	Toy_ConcurrentTable* table;
+	unsigned int seed;
+	unsigned int iterations;
+	unsigned int limit;
+	unsigned int writePercent;
+} Worker;
+
+void* stress_mixed(void* arg) {
+	Worker* worker = arg;
+	unsigned int seed = worker->seed;
+
+	for (unsigned int i = 0; i < worker->iterations; i++) {
+		//next seed
+		seed = hashUInt(seed);
+
+		//don't exceed a certain number of entries
+		unsigned int masked = seed & (worker->limit - 1); //lol
+		Toy_Value key = TOY_VALUE_FROM_INTEGER(masked);
+
+		if ((seed >> 16) % 100 < worker->writePercent) {
+			Toy_insertConcurrentTable(worker->table, key, TOY_VALUE_FROM_INTEGER(i));
+		}
+		else {
+			Toy_lookupConcurrentTable(worker->table, NULL, key); //integers only, so no bucket is needed
+		}
+	}
+
+	return NULL;
+}
+
+double run_mix(unsigned int threads, unsigned int iterations, unsigned int limit, unsigned int writePercent) {
+	Toy_ConcurrentTable* table = Toy_allocateConcurrentTable();
+	Worker workers[threads];
+
+	//prefill, so reads have something to find
+	for (unsigned int i = 0; i < limit; i++) {
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	//the total work is fixed, and split between the threads
+	for (unsigned int i = 0; i < threads; i++) {
+		workers[i] = (Worker){ .table = table, .seed = 42 + i, .iterations = iterations / threads, .limit = limit, .writePercent = writePercent };
+		pthread_create(&workers[i].thread, NULL, stress_mixed, &workers[i]);
+	}
+
+	for (unsigned int i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	Toy_freeConcurrentTable(table);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s operations keys\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores < 1) {
+		cores = 1;
+	}
+
+	//read-mostly and write-heavy mixes, from 1 to N cores
+	unsigned int mixes[] = { 5, 50 };
+
+	printf("threads\twrite%%\tseconds\tMops/sec\n");
+	for (unsigned int m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+		for (long threads = 1; threads <= cores; threads = (threads * 2 > cores && threads != cores) ? cores : threads * 2) {
+			double seconds = run_mix(threads, iterations, limit, mixes[m]);
+			printf("%ld\t%u\t%.3f\t%.2f\n", threads, mixes[m], seconds, iterations / seconds / 1e6);
+		}
+	}
+
+	return 0;
+}
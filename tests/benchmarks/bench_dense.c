@@ -0,0 +1,131 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//run from tests/benchmarks
+static const char* scripts[] = {
+	"../integrations/test_keyword_assert.toy",
+	"../integrations/test_keyword_print.toy",
+	"../integrations/test_scopes.toy",
+	"../integrations/test_variables.toy",
+};
+
+#define SCRIPT_COUNT (sizeof(scripts) / sizeof(scripts[0]))
+
+static void silence(const char* msg, void* userData) {
+	//
+}
+
+static char* readScript(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fseek(file, 0L, SEEK_END);
+	long length = ftell(file);
+	rewind(file);
+
+	char* buffer = malloc(length + 1);
+	buffer[fread(buffer, 1, length, file)] = '\0';
+	fclose(file);
+
+	return buffer;
+}
+
+//run the bytecode 'runs' times, returning the seconds taken
+static double runSample(Toy_Bytecode bc, unsigned int runs) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned int i = 0; i < runs; i++) {
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_setVMPrintContext(&vm, (Toy_PrintContext){ .printCallback = silence, .assertCallback = silence });
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+		Toy_runVM(&vm);
+		Toy_freeVM(&vm);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+//the scripts are short, so take the fastest of several samples, alternating between the encodings
+static void runBytecode(Toy_Bytecode aligned, Toy_Bytecode dense, unsigned int samples, unsigned int runs, double* alignedSeconds, double* denseSeconds) {
+	*alignedSeconds = *denseSeconds = 1e9;
+
+	for (unsigned int i = 0; i < samples; i++) {
+		double a = runSample(aligned, runs);
+		double d = runSample(dense, runs);
+
+		*alignedSeconds = a < *alignedSeconds ? a : *alignedSeconds;
+		*denseSeconds = d < *denseSeconds ? d : *denseSeconds;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s runs runs-per-sample\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//'limit' runs per sample
+	unsigned int samples = iterations / limit;
+	if (samples == 0) {
+		samples = 1;
+	}
+
+	printf("script\taligned bytes\tdense bytes\taligned us/run\tdense us/run\n");
+
+	for (unsigned int s = 0; s < SCRIPT_COUNT; s++) {
+		char* script = readScript(scripts[s]);
+		if (script == NULL) {
+			printf("Failed to read %s\n", scripts[s]);
+			return -1;
+		}
+
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+		Toy_Lexer lexer;
+		Toy_bindLexer(&lexer, script);
+		Toy_Parser parser;
+		Toy_bindParser(&parser, &lexer);
+		Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+
+		Toy_Bytecode aligned = Toy_compileBytecode(ast);
+		Toy_Bytecode dense = Toy_compileDenseBytecode(ast);
+
+		double alignedSeconds, denseSeconds;
+		runBytecode(aligned, dense, samples, limit, &alignedSeconds, &denseSeconds);
+
+		printf("%s\t%u\t%u\t%.2f\t%.2f\n", strrchr(scripts[s], '/') + 1, aligned.count, dense.count, alignedSeconds / limit * 1e6, denseSeconds / limit * 1e6);
+
+		Toy_freeBytecode(aligned);
+		Toy_freeBytecode(dense);
+		Toy_freeBucket(&bucket);
+		free(script);
+	}
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_scope.h"
+#include "toy_flat_scope.h"
+
+#include <stdio.h>
+#include <time.h>
+
+//access a global from the innermost of 'depth' nested scopes, each declaring a local
+double run_linked(Toy_Bucket** bucketHandle, Toy_String** names, unsigned int depth, unsigned int iterations, unsigned int limit) {
+	Toy_Scope* scope = Toy_pushScope(bucketHandle, NULL);
+
+	for (unsigned int i = 0; i < limit; i++) {
+		Toy_declareScope(scope, names[i], TOY_VALUE_FROM_INTEGER(i));
+	}
+
+	for (unsigned int d = 0; d < depth; d++) {
+		scope = Toy_pushScope(bucketHandle, scope);
+		Toy_declareScope(scope, names[limit], TOY_VALUE_FROM_INTEGER(d));
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	int sum = 0;
+	for (unsigned int i = 0; i < iterations; i++) {
+		sum += TOY_VALUE_AS_INTEGER(Toy_accessScope(scope, names[i & (limit - 1)]));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	while ((scope = Toy_popScope(scope)) != NULL) /* */;
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9 + (sum & 0);
+}
+
+double run_flat(Toy_String** names, unsigned int depth, unsigned int iterations, unsigned int limit) {
+	Toy_FlatScope* scope = Toy_allocateFlatScope();
+
+	for (unsigned int i = 0; i < limit; i++) {
+		Toy_declareFlatScope(scope, names[i], TOY_VALUE_FROM_INTEGER(i));
+	}
+
+	for (unsigned int d = 0; d < depth; d++) {
+		Toy_pushFlatScope(scope);
+		Toy_declareFlatScope(scope, names[limit], TOY_VALUE_FROM_INTEGER(d));
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	int sum = 0;
+	for (unsigned int i = 0; i < iterations; i++) {
+		sum += TOY_VALUE_AS_INTEGER(Toy_accessFlatScope(scope, names[i & (limit - 1)]));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	Toy_freeFlatScope(scope);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9 + (sum & 0);
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s lookups globals\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	//the globals, plus one local name shared by every nested scope
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+	Toy_String* names[limit + 1];
+
+	for (unsigned int i = 0; i <= limit; i++) {
+		char buffer[32];
+		int length = snprintf(buffer, sizeof(buffer), "name%u", i);
+		names[i] = Toy_createNameStringLength(&bucket, buffer, length, TOY_VALUE_INTEGER, false);
+	}
+
+	unsigned int depths[] = { 1, 8, 32, 128 };
+
+	printf("depth\tlinked ns/op\tflat ns/op\n");
+	for (unsigned int d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+		double linked = run_linked(&bucket, names, depths[d], iterations, limit);
+		double flat = run_flat(names, depths[d], iterations, limit);
+		printf("%u\t%.2f\t\t%.2f\n", depths[d], linked / iterations * 1e9, flat / iterations * 1e9);
+	}
+
+	Toy_freeBucket(&bucket);
+
+	return 0;
+}
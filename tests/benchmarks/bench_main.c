@@ -49,7 +49,7 @@ int main(int argc, char* argv[]) {
 
 	//limit to 16mb
 	if (limit * sizeof(Toy_TableEntry) > (1024 * 1024 * 16)) {
-		printf("Error: limit must be below %u for safety reasons\n", (1024 * 1024 * 16)/sizeof(Toy_TableEntry));
+		printf("Error: limit must be below %u for safety reasons\n", (unsigned int)((1024 * 1024 * 16)/sizeof(Toy_TableEntry)));
 		return 0;
 	}
 
@@ -0,0 +1,71 @@
+//for sysconf and clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+//compile and run 'scripts' copies of the source, returning the seconds taken
+double run_pool(unsigned int threads, const char* source, unsigned int scripts) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	Toy_Pool* pool = Toy_allocatePool(threads);
+
+	for (unsigned int i = 0; i < scripts; i++) {
+		Toy_submitPool(pool, source);
+	}
+
+	Toy_waitPool(pool);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	Toy_freePool(pool);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s statements statements-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//each script is 'limit' statements, and the total number of statements is fixed
+	char* source = malloc(limit * 16 + 32);
+	unsigned int length = sprintf(source, "var a = 0;");
+	for (unsigned int i = 0; i < limit; i++) {
+		length += sprintf(source + length, " a += 1;");
+	}
+	sprintf(source + length, " print a;");
+
+	unsigned int scripts = iterations / limit;
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores < 1) {
+		cores = 1;
+	}
+
+	printf("threads\tscripts\tseconds\tscripts/sec\n");
+	for (long threads = 1; threads <= cores; threads = (threads * 2 > cores && threads != cores) ? cores : threads * 2) {
+		double seconds = run_pool(threads, source, scripts);
+		printf("%ld\t%u\t%.3f\t%.2f\n", threads, scripts, seconds, scripts / seconds);
+	}
+
+	free(source);
+
+	return 0;
+}
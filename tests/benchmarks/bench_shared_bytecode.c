@@ -0,0 +1,112 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VM_COUNT 100
+
+//bind every VM to the same image, or to a private copy each, then run them all in turns
+double run_vms(Toy_Bytecode bc, bool shared, unsigned int iterations) {
+	Toy_VM vms[VM_COUNT];
+	unsigned char* copies[VM_COUNT];
+
+	for (int i = 0; i < VM_COUNT; i++) {
+		copies[i] = NULL;
+
+		if (!shared) {
+			copies[i] = malloc(bc.count);
+			memcpy(copies[i], bc.ptr, bc.count);
+		}
+
+		Toy_initVM(&vms[i]);
+		Toy_bindVM(&vms[i], shared ? bc.ptr : copies[i], bc.count);
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned int i = 0; i < iterations / VM_COUNT; i++) {
+		for (int v = 0; v < VM_COUNT; v++) {
+			Toy_runVM(&vms[v]);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (int i = 0; i < VM_COUNT; i++) {
+		Toy_freeVM(&vms[i]);
+		free(copies[i]);
+	}
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s statements statements-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//"{ var a = 0; a += 1; ... }", so every run starts fresh
+	char* source = malloc(limit * 16 + 32);
+	unsigned int length = sprintf(source, "{ var a = 0;");
+	for (unsigned int i = 0; i < limit; i++) {
+		length += sprintf(source + length, " a += 1;");
+	}
+	sprintf(source + length, " }");
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+	Toy_Bytecode bc = Toy_compileBytecode(ast);
+
+	//the per-VM side table, and how well it holds up after a few runs
+	Toy_VM probe;
+	Toy_initVM(&probe);
+	Toy_bindVM(&probe, bc.ptr, bc.count);
+	for (int i = 0; i < 4; i++) {
+		Toy_runVM(&probe);
+	}
+	unsigned long sideTable = (probe.cacheMask + 1) * sizeof(Toy_InlineCache);
+	Toy_VMStats stats = Toy_getVMStats(&probe);
+	Toy_freeVM(&probe);
+
+	unsigned long image = bc.count;
+
+	printf("%d VMs, %lu byte image, %lu byte side table each (%u cache hits, %u misses over 4 runs)\n", VM_COUNT, image, sideTable, stats.cacheHits, stats.cacheMisses);
+	printf("mode\tbytecode bytes\tside table bytes\tseconds\n");
+
+	double copied = run_vms(bc, false, iterations / limit);
+	printf("copied\t%lu\t\t%lu\t\t\t%.3f\n", image * VM_COUNT, sideTable * VM_COUNT, copied);
+
+	double shared = run_vms(bc, true, iterations / limit);
+	printf("shared\t%lu\t\t%lu\t\t\t%.3f\n", image, sideTable * VM_COUNT, shared);
+
+	Toy_freeBytecode(bc);
+	Toy_freeBucket(&bucket);
+	free(source);
+
+	return 0;
+}
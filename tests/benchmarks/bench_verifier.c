@@ -0,0 +1,92 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_verifier.h"
+#include "toy_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//run the routine 'runs' times, after the one bind
+double run_vm(Toy_Bytecode bc, unsigned int runs) {
+	Toy_VM vm;
+	Toy_initVM(&vm);
+	Toy_bindVM(&vm, bc.ptr, bc.count);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned int i = 0; i < runs; i++) {
+		Toy_runVM(&vm);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	Toy_freeVM(&vm);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s statements statements-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//"{ var a = 0; a += 1; assert a > 0; ... }", so every run starts fresh
+	char* source = malloc(limit * 32 + 32);
+	unsigned int length = sprintf(source, "{ var a = 0;");
+	for (unsigned int i = 0; i < limit; i++) {
+		length += sprintf(source + length, " a += 1; assert a > 0;");
+	}
+	sprintf(source + length, " }");
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+	Toy_Bytecode bc = Toy_compileBytecode(ast);
+
+	//the one-time cost, paid at bind
+	int offset = Toy_getBytecodeHeaderSize();
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	char msg[256];
+	bool ok = Toy_verifyRoutine(bc.ptr + offset, bc.count - offset, msg, 256);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double verifySeconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("verified %u bytes in %.3f ms (%s)\n", bc.count, verifySeconds * 1e3, ok ? "ok" : msg);
+
+	unsigned int runs = iterations / limit;
+
+	double seconds = run_vm(bc, runs);
+	printf("ran %u times in %.3f s (%.2f ns/statement), verification was %.4f%% of the total\n", runs, seconds, seconds / runs / limit / 2 * 1e9, verifySeconds / (verifySeconds + seconds) * 100);
+
+	Toy_freeBytecode(bc);
+	Toy_freeBucket(&bucket);
+	free(source);
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+//for pthreads, sysconf and clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_vm.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+//each worker owns a VM, and counts its output through its own print context
+typedef struct Worker {
+	pthread_t thread;
+	const char* source;
+	unsigned int runs;
+	unsigned int prints;
+} Worker;
+
+void countPrints(const char* msg, void* userData) {
+	((Worker*)userData)->prints++;
+}
+
+void* run_worker(void* arg) {
+	Worker* worker = arg;
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, worker->source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+	Toy_Bytecode bc = Toy_compileBytecode(ast);
+
+	Toy_VM vm;
+	Toy_initVM(&vm);
+	Toy_setVMPrintContext(&vm, (Toy_PrintContext){ .printCallback = countPrints, .userData = worker });
+	Toy_bindVM(&vm, bc.ptr, bc.count);
+
+	for (unsigned int i = 0; i < worker->runs; i++) {
+		Toy_runVM(&vm);
+	}
+
+	Toy_freeVM(&vm);
+	Toy_freeBytecode(bc);
+	Toy_freeBucket(&bucket);
+
+	return NULL;
+}
+
+double run_threads(unsigned int threads, const char* source, unsigned int runs, unsigned int* prints) {
+	Worker workers[threads];
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	//the total work is fixed, and split between the threads
+	for (unsigned int i = 0; i < threads; i++) {
+		workers[i] = (Worker){ .source = source, .runs = runs / threads, .prints = 0 };
+		pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]);
+	}
+
+	*prints = 0;
+	for (unsigned int i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		*prints += workers[i].prints;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s statements statements-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//"{ var a = 0; a += 1; print a; ... }", so every run starts fresh
+	char* source = malloc(limit * 24 + 32);
+	unsigned int length = sprintf(source, "{ var a = 0;");
+	for (unsigned int i = 0; i < limit; i++) {
+		length += sprintf(source + length, " a += 1; print a;");
+	}
+	sprintf(source + length, " }");
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores < 1) {
+		cores = 1;
+	}
+
+	//each iteration is one statement pair, from 1 to N cores
+	unsigned int runs = iterations / limit;
+
+	printf("threads\tseconds\tprints\tMprints/sec\n");
+	for (long threads = 1; threads <= cores; threads = (threads * 2 > cores && threads != cores) ? cores : threads * 2) {
+		unsigned int prints = 0;
+		double seconds = run_threads(threads, source, runs, &prints);
+		printf("%ld\t%.3f\t%u\t%.2f\n", threads, seconds, prints, prints / seconds / 1e6);
+	}
+
+	free(source);
+
+	return 0;
+}
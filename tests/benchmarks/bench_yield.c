@@ -0,0 +1,75 @@
+//for clock_gettime under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//a generator of 'limit' values, resumed by the host until it finishes
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Usage: %s resumes yields-per-script\n", argv[0]);
+		return 0;
+	}
+
+	unsigned int iterations = 0;
+	unsigned int limit = 0;
+
+	sscanf(argv[1], "%u", &iterations);
+	sscanf(argv[2], "%u", &limit);
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	//"yield 0; yield 1; ..."
+	char* source = malloc(limit * 24 + 1);
+	unsigned int length = 0;
+	for (unsigned int i = 0; i < limit; i++) {
+		length += sprintf(source + length, "yield %u;", i);
+	}
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(&bucket, &parser);
+	Toy_Bytecode bc = Toy_compileBytecode(ast);
+
+	Toy_VM vm;
+	Toy_initVM(&vm);
+	Toy_bindVM(&vm, bc.ptr, bc.count);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	//each finished run restarts the generator from the top
+	unsigned long long sum = 0;
+	for (unsigned int i = 0; i < iterations; i++) {
+		if (Toy_runVM(&vm) != TOY_VM_STATUS_YIELDED_VALUE) {
+			i--;
+			continue;
+		}
+
+		sum += TOY_VALUE_AS_INTEGER(vm.yieldValue);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%u round trips, %.2f ns per resume/yield (checksum %llu)\n", iterations, seconds / iterations * 1e9, sum);
+
+	Toy_freeVM(&vm);
+	Toy_freeBytecode(bc);
+	Toy_freeBucket(&bucket);
+	free(source);
+
+	return 0;
+}
@@ -276,6 +276,26 @@ int test_type_emission(Toy_Bucket** bucketHandle) {
 		}
 	}
 
+	//emit yield
+	{
+		//build the AST
+		Toy_Ast* ast = NULL;
+		Toy_private_emitAstValue(bucketHandle, &ast, TOY_VALUE_FROM_INTEGER(42));
+		Toy_private_emitAstYield(bucketHandle, &ast);
+
+		//check if it worked
+		if (
+			ast == NULL ||
+			ast->type != TOY_AST_YIELD ||
+			ast->yield.child == NULL ||
+			ast->yield.child->type != TOY_AST_VALUE ||
+			TOY_VALUE_AS_INTEGER(ast->yield.child->value.value) != 42)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: failed to emit a keyword 'yield' as 'Toy_Ast', state unknown\n" TOY_CC_RESET);
+			return -1;
+		}
+	}
+
 	//emit var declare
 	{
 		//build the AST
@@ -6,6 +6,7 @@
 #include "toy_parser.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 //tests
@@ -86,10 +87,7 @@ int test_bytecode_from_source(Toy_Bucket** bucketHandle) {
 		}
 
 		//check contents of the routine (this is copy/pasted from test_routine.c, and tweaked with the offset)
-		int offset = 3 + strlen(TOY_VERSION_BUILD) + 1;
-		if (offset % 4 != 0) {
-			offset += 4 - (offset % 4); //ceil
-		}
+		int offset = Toy_getBytecodeHeaderSize();
 
 		int* ptr = (int*)(bc.ptr + offset);
 
@@ -170,6 +168,156 @@ int test_bytecode_from_source(Toy_Bucket** bucketHandle) {
 	return 0;
 }
 
+int test_bytecode_bundle(Toy_Bucket** bucketHandle) {
+	//the index finds each module by name, and every offset stays aligned
+	{
+		//setup
+		const char* sources[] = { "print 1;", "var a = \"hello\"; print a;", "{ print 3; }" };
+		const char* names[] = { "one", "two", "three" };
+		Toy_Ast* modules[3];
+
+		for (int i = 0; i < 3; i++) {
+			Toy_Lexer lexer;
+			Toy_Parser parser;
+
+			Toy_bindLexer(&lexer, sources[i]);
+			Toy_bindParser(&parser, &lexer);
+			modules[i] = Toy_scanParser(bucketHandle, &parser);
+		}
+
+		//run
+		Toy_Bytecode bc = Toy_compileBundle(modules, names, 3, false);
+
+		//check the index
+		if (bc.count % 4 != 0 ||
+			Toy_getBundleModuleCount(bc.ptr, bc.count) != 3 ||
+			Toy_findBundleModule(bc.ptr, bc.count, "four") != NULL ||
+			Toy_getBundleModuleName(bc.ptr, bc.count, 3) != NULL)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: failed to write the bundle index correctly, size is %d\n" TOY_CC_RESET, (int)bc.count);
+
+			//cleanup and return
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//each module matches the same source compiled alone
+		for (int i = 0; i < 3; i++) {
+			const unsigned char* module = Toy_findBundleModule(bc.ptr, bc.count, names[i]);
+			Toy_Bytecode single = Toy_compileBytecode(modules[i]);
+
+			unsigned int size;
+			memcpy(&size, module, sizeof(size));
+
+			if (module != Toy_getBundleModule(bc.ptr, bc.count, i) ||
+				strcmp(Toy_getBundleModuleName(bc.ptr, bc.count, i), names[i]) != 0 ||
+				(module - bc.ptr) % 4 != 0 ||
+				Toy_getBundleModuleCount(single.ptr, single.count) != 0 ||
+				memcmp(module, single.ptr + (single.count - size), size) != 0)
+			{
+				fprintf(stderr, TOY_CC_ERROR "ERROR: failed to write the bundled module '%s' correctly\n" TOY_CC_RESET, names[i]);
+
+				//cleanup and return
+				Toy_freeBytecode(single);
+				Toy_freeBytecode(bc);
+				return -1;
+			}
+
+			Toy_freeBytecode(single);
+		}
+
+		//cleanup
+		Toy_freeBytecode(bc);
+	}
+
+	//nothing past the image's length is read, including the index, the names and the modules
+	{
+		//setup
+		const char* names[] = { "one", "two" };
+		Toy_Ast* modules[2];
+
+		for (int i = 0; i < 2; i++) {
+			Toy_Lexer lexer;
+			Toy_Parser parser;
+
+			Toy_bindLexer(&lexer, "print 1;");
+			Toy_bindParser(&parser, &lexer);
+			modules[i] = Toy_scanParser(bucketHandle, &parser);
+		}
+
+		Toy_Bytecode bc = Toy_compileBundle(modules, names, 2, false);
+
+		int offset = Toy_getBytecodeHeaderSize();
+
+		unsigned int nameAddr, routineAddr;
+		memcpy(&nameAddr, bc.ptr + offset + 8, sizeof(nameAddr));
+		memcpy(&routineAddr, bc.ptr + offset + 12, sizeof(routineAddr));
+
+		//run
+		unsigned int shortIndex = Toy_getBundleModuleCount(bc.ptr, offset + 16); //only one entry fits
+		const char* shortName = Toy_getBundleModuleName(bc.ptr, nameAddr + 2, 0); //without the terminator
+		const unsigned char* shortModule = Toy_getBundleModule(bc.ptr, routineAddr, 0);
+		const unsigned char* shortFind = Toy_findBundleModule(bc.ptr, routineAddr, "one");
+
+		unsigned int count = 0x40000000;
+		memcpy(bc.ptr + offset + 4, &count, sizeof(count));
+		unsigned int wideIndex = Toy_getBundleModuleCount(bc.ptr, bc.count);
+
+		//check the results
+		if (shortIndex != 0 || shortName != NULL || shortModule != NULL || shortFind != NULL || wideIndex != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: failed to bound the bundle index by the image's length\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeBytecode(bc);
+	}
+
+	return 0;
+}
+
+int test_bytecode_long_script(Toy_Bucket** bucketHandle) {
+	//statements are chained, so a long script shouldn't recurse once per statement
+	{
+		//setup
+		unsigned int statements = 200000;
+		char* source = malloc(statements * 16 + 16);
+		unsigned int length = sprintf(source, "var a = 0;");
+		for (unsigned int i = 0; i < statements; i++) {
+			length += sprintf(source + length, " a += 1;");
+		}
+
+		Toy_Lexer lexer;
+		Toy_Parser parser;
+
+		Toy_bindLexer(&lexer, source);
+		Toy_bindParser(&parser, &lexer);
+		Toy_Ast* ast = Toy_scanParser(bucketHandle, &parser);
+
+		//run
+		Toy_Bytecode bc = Toy_compileBytecode(ast);
+
+		//check the size, each statement is 6 words of code
+		if (bc.count % 4 != 0 || bc.count < statements * 24) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: failed to compile a long script, size is %d\n" TOY_CC_RESET, (int)bc.count);
+
+			//cleanup and return
+			Toy_freeBytecode(bc);
+			free(source);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeBytecode(bc);
+		free(source);
+	}
+
+	return 0;
+}
+
 int main() {
 	//run each test set, returning the total errors given
 	int total = 0, res = 0;
@@ -194,5 +342,25 @@ int main() {
 		total += res;
 	}
 
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_bytecode_bundle(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_bytecode_long_script(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
 	return total;
 }
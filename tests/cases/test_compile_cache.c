@@ -0,0 +1,256 @@
+//for mkdtemp and rmdir under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_compile_cache.h"
+#include "toy_console_colors.h"
+
+#include "toy_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//utils
+static void removeEntry(const char* directory, const char* source, bool removeAssert) {
+	char key[32];
+	Toy_private_getCompileCacheKey(key, source, removeAssert, false);
+
+	char path[strlen(directory) + 1 + sizeof(key)];
+	snprintf(path, sizeof(path), "%s/%s", directory, key);
+	remove(path);
+}
+
+int test_compile_cache_keys() {
+	//the key changes with the source and the options, but nothing else
+	{
+		char a[32], b[32], c[32], d[32], e[32];
+		Toy_private_getCompileCacheKey(a, "print 42;", false, false);
+		Toy_private_getCompileCacheKey(b, "print 42;", false, false);
+		Toy_private_getCompileCacheKey(c, "print 43;", false, false);
+		Toy_private_getCompileCacheKey(d, "print 42;", true, false);
+		Toy_private_getCompileCacheKey(e, "print 42;", false, true);
+
+		if (strcmp(a, b) != 0 ||
+			strcmp(a, c) == 0 ||
+			strcmp(a, d) == 0 ||
+			strcmp(a, e) == 0 ||
+			strlen(a) != 28)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected compile cache keys '%s', '%s', '%s', '%s', '%s'\n" TOY_CC_RESET, a, b, c, d, e);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int test_compile_cache_hits(const char* directory) {
+	//a miss compiles and stores, then a hit returns the same bytecode
+	{
+		//setup
+		const char* source = "var a = 1; print a + 41;";
+		Toy_CompileCache* cache = Toy_allocateCompileCache(directory);
+
+		Toy_Bytecode first = Toy_compileCached(cache, source, false, false);
+		Toy_CompileCacheStats afterMiss = Toy_getCompileCacheStats(cache);
+
+		Toy_Bytecode second = Toy_compileCached(cache, source, false, false);
+		Toy_CompileCacheStats afterHit = Toy_getCompileCacheStats(cache);
+
+		//check the state
+		if (first.ptr == NULL || second.ptr == NULL ||
+			first.count != second.count ||
+			memcmp(first.ptr, second.ptr, first.count) != 0 ||
+
+			afterMiss.hits != 0 ||
+			afterMiss.misses != 1 ||
+			afterMiss.writeFailures != 0 ||
+
+			afterHit.hits != 1 ||
+			afterHit.misses != 1 ||
+			afterHit.rejects != 0)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected results from a 'Toy_CompileCache' hit\n" TOY_CC_RESET);
+			Toy_freeBytecode(first);
+			Toy_freeBytecode(second);
+			Toy_freeCompileCache(cache);
+			removeEntry(directory, source, false);
+			return -1;
+		}
+
+		//the cached bytecode runs like any other
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, second.ptr, second.count);
+
+		if (Toy_runVM(&vm) != TOY_VM_STATUS_OK) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to run bytecode from a 'Toy_CompileCache'\n" TOY_CC_RESET);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(first);
+			Toy_freeBytecode(second);
+			Toy_freeCompileCache(cache);
+			removeEntry(directory, source, false);
+			return -1;
+		}
+
+		//free
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(first);
+		Toy_freeBytecode(second);
+		Toy_freeCompileCache(cache);
+		removeEntry(directory, source, false);
+	}
+
+	//a broken entry is rejected, then replaced
+	{
+		//setup
+		const char* source = "print \"broken\";";
+
+		char key[32];
+		Toy_private_getCompileCacheKey(key, source, false, false);
+
+		char path[strlen(directory) + 1 + sizeof(key)];
+		snprintf(path, sizeof(path), "%s/%s", directory, key);
+
+		FILE* file = fopen(path, "wb");
+		fputs("not bytecode", file);
+		fclose(file);
+
+		Toy_CompileCache* cache = Toy_allocateCompileCache(directory);
+
+		Toy_Bytecode first = Toy_compileCached(cache, source, false, false);
+		Toy_Bytecode second = Toy_compileCached(cache, source, false, false);
+		Toy_CompileCacheStats stats = Toy_getCompileCacheStats(cache);
+
+		//check the state
+		if (first.ptr == NULL || second.ptr == NULL ||
+			stats.hits != 1 ||
+			stats.misses != 1 ||
+			stats.rejects != 1)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to replace a broken 'Toy_CompileCache' entry\n" TOY_CC_RESET);
+			Toy_freeBytecode(first);
+			Toy_freeBytecode(second);
+			Toy_freeCompileCache(cache);
+			removeEntry(directory, source, false);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(first);
+		Toy_freeBytecode(second);
+		Toy_freeCompileCache(cache);
+		removeEntry(directory, source, false);
+	}
+
+	//an entry from a colliding key holds another source, so it's rejected, then replaced
+	{
+		//setup
+		const char* source = "print \"mine\";";
+		const char* other = "print \"theirs\";";
+
+		char key[32], otherKey[32];
+		Toy_private_getCompileCacheKey(key, source, false, false);
+		Toy_private_getCompileCacheKey(otherKey, other, false, false);
+
+		char path[strlen(directory) + 1 + sizeof(key)];
+		snprintf(path, sizeof(path), "%s/%s", directory, key);
+		char otherPath[strlen(directory) + 1 + sizeof(otherKey)];
+		snprintf(otherPath, sizeof(otherPath), "%s/%s", directory, otherKey);
+
+		Toy_CompileCache* cache = Toy_allocateCompileCache(directory);
+
+		//fake the collision by moving the other entry into place
+		Toy_Bytecode theirs = Toy_compileCached(cache, other, false, false);
+		rename(otherPath, path);
+
+		Toy_Bytecode first = Toy_compileCached(cache, source, false, false);
+		Toy_Bytecode second = Toy_compileCached(cache, source, false, false);
+		Toy_CompileCacheStats stats = Toy_getCompileCacheStats(cache);
+
+		//check the state
+		if (theirs.ptr == NULL || first.ptr == NULL || second.ptr == NULL ||
+			(first.count == theirs.count && memcmp(first.ptr, theirs.ptr, first.count) == 0) ||
+			first.count != second.count ||
+			memcmp(first.ptr, second.ptr, first.count) != 0 ||
+			stats.hits != 1 ||
+			stats.misses != 2 ||
+			stats.rejects != 1)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject a 'Toy_CompileCache' entry from another source\n" TOY_CC_RESET);
+			Toy_freeBytecode(theirs);
+			Toy_freeBytecode(first);
+			Toy_freeBytecode(second);
+			Toy_freeCompileCache(cache);
+			removeEntry(directory, source, false);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(theirs);
+		Toy_freeBytecode(first);
+		Toy_freeBytecode(second);
+		Toy_freeCompileCache(cache);
+		removeEntry(directory, source, false);
+	}
+
+	//a parser error isn't cached
+	{
+		//setup
+		const char* source = "var = 1;";
+
+		Toy_CompileCache* cache = Toy_allocateCompileCache(directory);
+
+		Toy_Bytecode first = Toy_compileCached(cache, source, false, false);
+		Toy_Bytecode second = Toy_compileCached(cache, source, false, false);
+		Toy_CompileCacheStats stats = Toy_getCompileCacheStats(cache);
+
+		//check the state
+		if (first.ptr != NULL || second.ptr != NULL ||
+			stats.hits != 0 ||
+			stats.misses != 2 ||
+			stats.writeFailures != 0)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected results from a 'Toy_CompileCache' parser error\n" TOY_CC_RESET);
+			Toy_freeCompileCache(cache);
+			return -1;
+		}
+
+		//free
+		Toy_freeCompileCache(cache);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	char directory[] = "/tmp/toy_compile_cache_XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to create a directory for the compile cache tests\n" TOY_CC_RESET);
+		return -1;
+	}
+
+	{
+		res = test_compile_cache_keys();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_compile_cache_hits(directory);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	rmdir(directory);
+
+	return total;
+}
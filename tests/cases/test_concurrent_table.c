@@ -0,0 +1,202 @@
+//for pthreads under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
+#include "toy_concurrent_table.h"
+#include "toy_console_colors.h"
+
+#include "toy_string.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//replaces a value with the given string
+static Toy_Value stringCallback(Toy_Value oldValue, void* userData) {
+	return TOY_VALUE_FROM_STRING((Toy_String*)userData);
+}
+
+int test_concurrent_table_simple_insert_lookup_and_remove() {
+	//simple insert
+	{
+		//setup
+		Toy_ConcurrentTable* table = Toy_allocateConcurrentTable();
+
+		for (int i = 0; i < 400; i++) {
+			Toy_insertConcurrentTable(table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(300 - i));
+		}
+
+		Toy_removeConcurrentTable(table, TOY_VALUE_FROM_INTEGER(12));
+
+		Toy_Value result = Toy_lookupConcurrentTable(table, NULL, TOY_VALUE_FROM_INTEGER(265));
+		Toy_Value missing = Toy_lookupConcurrentTable(table, NULL, TOY_VALUE_FROM_INTEGER(12));
+
+		//check the state
+		if (table == NULL ||
+			Toy_getConcurrentTableCount(table) != 399 ||
+
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 35 ||
+			TOY_VALUE_IS_NULL(missing) != true
+			)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to use a concurrent table\n" TOY_CC_RESET);
+			Toy_freeConcurrentTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeConcurrentTable(table);
+	}
+
+	//strings are stored as private copies, and copied out into the caller's bucket
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_String* key = Toy_createString(&bucket, "key");
+		Toy_String* rope = Toy_concatStrings(&bucket, Toy_createString(&bucket, "hello "), Toy_createString(&bucket, "world"));
+		Toy_ConcurrentTable* table = Toy_allocateConcurrentTable();
+
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_STRING(key), TOY_VALUE_FROM_STRING(rope));
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_INTEGER(1), TOY_VALUE_FROM_STRING(key));
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_INTEGER(1), TOY_VALUE_FROM_FLOAT(2.5f)); //overwritten, freeing the copy
+
+		//nothing in the table points into the original bucket
+		unsigned int keyRefCount = key->refCount;
+		unsigned int ropeRefCount = rope->refCount;
+		Toy_freeBucket(&bucket);
+
+		Toy_Bucket* other = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Value result = Toy_lookupConcurrentTable(table, &other, TOY_VALUE_FROM_STRING(Toy_createString(&other, "key")));
+		Toy_Value number = Toy_lookupConcurrentTable(table, &other, TOY_VALUE_FROM_INTEGER(1));
+		Toy_Value updated = Toy_updateConcurrentTable(table, &other, TOY_VALUE_FROM_INTEGER(2), stringCallback, Toy_createString(&other, "updated"));
+
+		char* buffer = TOY_VALUE_IS_STRING(result) ? Toy_getStringRawBuffer(TOY_VALUE_AS_STRING(result)) : NULL;
+
+		//check the state
+		if (keyRefCount != 1 ||
+			ropeRefCount != 1 ||
+			Toy_getConcurrentTableCount(table) != 3 ||
+			buffer == NULL ||
+			strcmp(buffer, "hello world") != 0 ||
+			TOY_VALUE_IS_FLOAT(number) != true ||
+			TOY_VALUE_IS_STRING(updated) != true ||
+			strcmp(TOY_VALUE_AS_STRING(updated)->as.leaf.data, "updated") != 0)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to store strings in a concurrent table\n" TOY_CC_RESET);
+			free(buffer);
+			Toy_freeConcurrentTable(table);
+			Toy_freeBucket(&other);
+			return -1;
+		}
+
+		//free
+		free(buffer);
+		Toy_freeConcurrentTable(table);
+		Toy_freeBucket(&other);
+	}
+
+	//values shared by reference are rejected, leaving the old value in place
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_String* name = Toy_createNameStringLength(&bucket, "name", 4, TOY_VALUE_ANY, false);
+		Toy_ConcurrentTable* table = Toy_allocateConcurrentTable();
+
+		fprintf(stderr, TOY_CC_NOTICE "(the next three errors are expected)\n" TOY_CC_RESET);
+
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_STRING(name), TOY_VALUE_FROM_INTEGER(1));
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_INTEGER(1), TOY_VALUE_FROM_STRING(name));
+		Toy_insertConcurrentTable(table, TOY_VALUE_FROM_INTEGER(2), TOY_VALUE_FROM_BOOLEAN(true));
+
+		Toy_Value rejected = Toy_updateConcurrentTable(table, &bucket, TOY_VALUE_FROM_INTEGER(2), stringCallback, name);
+
+		//check the state
+		if (Toy_getConcurrentTableCount(table) != 1 ||
+			TOY_VALUE_IS_BOOLEAN(rejected) != true ||
+			name->refCount != 1)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject shared values in a concurrent table\n" TOY_CC_RESET);
+			Toy_freeConcurrentTable(table);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeConcurrentTable(table);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+//increments a counter under the shard's lock
+static Toy_Value incrementCallback(Toy_Value oldValue, void* userData) {
+	return TOY_VALUE_FROM_INTEGER(TOY_VALUE_IS_INTEGER(oldValue) ? TOY_VALUE_AS_INTEGER(oldValue) + 1 : 1);
+}
+
+static void* incrementWorker(void* arg) {
+	Toy_ConcurrentTable* table = arg;
+
+	for (int i = 0; i < 10000; i++) {
+		Toy_updateConcurrentTable(table, NULL, TOY_VALUE_FROM_INTEGER(i % 8), incrementCallback, NULL);
+	}
+
+	return NULL;
+}
+
+int test_concurrent_table_threaded_updates() {
+	//several threads incrementing shared counters
+	{
+		//setup
+		Toy_ConcurrentTable* table = Toy_allocateConcurrentTable();
+		pthread_t threads[4];
+
+		for (int i = 0; i < 4; i++) {
+			pthread_create(&threads[i], NULL, incrementWorker, table);
+		}
+
+		for (int i = 0; i < 4; i++) {
+			pthread_join(threads[i], NULL);
+		}
+
+		//check the state
+		for (int i = 0; i < 8; i++) {
+			Toy_Value result = Toy_lookupConcurrentTable(table, NULL, TOY_VALUE_FROM_INTEGER(i));
+
+			if (TOY_VALUE_IS_INTEGER(result) != true || TOY_VALUE_AS_INTEGER(result) != 5000) {
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Concurrent table lost an update on counter %d\n" TOY_CC_RESET, i);
+				Toy_freeConcurrentTable(table);
+				return -1;
+			}
+		}
+
+		//free
+		Toy_freeConcurrentTable(table);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_concurrent_table_simple_insert_lookup_and_remove();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_concurrent_table_threaded_updates();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
@@ -0,0 +1,162 @@
+#include "toy_flat_scope.h"
+#include "toy_console_colors.h"
+
+#include "toy_bucket.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int test_flat_scope_elements() {
+	//declare, access and assign an element
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_FlatScope* scope = Toy_allocateFlatScope();
+
+		Toy_String* hello = Toy_createNameStringLength(&bucket, "hello", 5, TOY_VALUE_ANY, false);
+
+		if (Toy_isDeclaredFlatScope(scope, hello)) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected entry found in Toy_FlatScope\n" TOY_CC_RESET);
+			Toy_freeFlatScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		Toy_declareFlatScope(scope, hello, TOY_VALUE_FROM_INTEGER(42));
+		Toy_Value result = Toy_accessFlatScope(scope, hello);
+
+		Toy_assignFlatScope(scope, hello, TOY_VALUE_FROM_FLOAT(3.1415f));
+		Toy_Value resultTwo = Toy_accessFlatScope(scope, hello);
+
+		//check
+		if (!Toy_isDeclaredFlatScope(scope, hello) ||
+			scope->count != 1 ||
+			scope->depth != 0 ||
+
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 42 ||
+			TOY_VALUE_IS_FLOAT(resultTwo) != true ||
+			TOY_VALUE_AS_FLOAT(resultTwo) != 3.1415f ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to declare and assign in Toy_FlatScope\n" TOY_CC_RESET);
+			Toy_freeFlatScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeFlatScope(scope);
+		Toy_freeBucket(&bucket);
+	}
+
+	//shadow an entry, and restore it by popping
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_FlatScope* scope = Toy_allocateFlatScope();
+
+		Toy_String* hello = Toy_createNameStringLength(&bucket, "hello", 5, TOY_VALUE_ANY, false);
+		Toy_String* world = Toy_createNameStringLength(&bucket, "world", 5, TOY_VALUE_ANY, false);
+
+		Toy_declareFlatScope(scope, hello, TOY_VALUE_FROM_INTEGER(42));
+
+		Toy_pushFlatScope(scope);
+		Toy_pushFlatScope(scope);
+
+		Toy_Value outer = Toy_accessFlatScope(scope, hello);
+
+		Toy_declareFlatScope(scope, hello, TOY_VALUE_FROM_INTEGER(69));
+		Toy_declareFlatScope(scope, world, TOY_VALUE_FROM_INTEGER(420));
+		Toy_assignFlatScope(scope, hello, TOY_VALUE_FROM_INTEGER(70));
+
+		Toy_Value inner = Toy_accessFlatScope(scope, hello);
+
+		Toy_popFlatScope(scope);
+
+		Toy_Value restored = Toy_accessFlatScope(scope, hello);
+		bool worldDeclared = Toy_isDeclaredFlatScope(scope, world);
+
+		Toy_popFlatScope(scope);
+
+		//check
+		if (TOY_VALUE_AS_INTEGER(outer) != 42 ||
+			TOY_VALUE_AS_INTEGER(inner) != 70 ||
+			TOY_VALUE_AS_INTEGER(restored) != 42 ||
+			worldDeclared != false ||
+			scope->count != 1 ||
+			scope->depth != 0 ||
+			scope->index->count != 1 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to shadow an entry in Toy_FlatScope\n" TOY_CC_RESET);
+			Toy_freeFlatScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeFlatScope(scope);
+		Toy_freeBucket(&bucket);
+	}
+
+	//expand the bindings across many nested scopes
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_FlatScope* scope = Toy_allocateFlatScope();
+
+		Toy_String* counter = Toy_createNameStringLength(&bucket, "counter", 7, TOY_VALUE_INTEGER, false);
+
+		for (int i = 0; i < 100; i++) {
+			Toy_pushFlatScope(scope);
+			Toy_declareFlatScope(scope, counter, TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		Toy_Value deepest = Toy_accessFlatScope(scope, counter);
+
+		for (int i = 0; i < 50; i++) {
+			Toy_popFlatScope(scope);
+		}
+
+		Toy_Value middle = Toy_accessFlatScope(scope, counter);
+
+		//check
+		if (TOY_VALUE_AS_INTEGER(deepest) != 99 ||
+			TOY_VALUE_AS_INTEGER(middle) != 49 ||
+			scope->count != 50 ||
+			scope->capacity < 100 ||
+			scope->depth != 50 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to expand Toy_FlatScope across nested scopes\n" TOY_CC_RESET);
+			Toy_freeFlatScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeFlatScope(scope);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_flat_scope_elements();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
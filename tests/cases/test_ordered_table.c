@@ -0,0 +1,188 @@
+#include "toy_ordered_table.h"
+#include "toy_console_colors.h"
+
+#include <stdio.h>
+
+int test_ordered_table_allocation() {
+	//allocate and free a table
+	{
+		//setup
+		Toy_OrderedTable* table = Toy_allocateOrderedTable();
+
+		//check
+		if (table == NULL ||
+			table->capacity != 8 ||
+			table->entryCapacity != 6 ||
+			table->count != 0 ||
+			table->used != 0)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate an ordered table\n" TOY_CC_RESET);
+			Toy_freeOrderedTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeOrderedTable(table);
+	}
+
+	return 0;
+}
+
+int test_ordered_table_simple_insert_lookup_and_remove() {
+	//simple insert
+	{
+		//setup
+		Toy_OrderedTable* table = Toy_allocateOrderedTable();
+
+		//insert
+		Toy_insertOrderedTable(&table, TOY_VALUE_FROM_INTEGER(1), TOY_VALUE_FROM_INTEGER(42));
+
+		if (table == NULL ||
+			table->count != 1 ||
+			table->used != 1)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to insert into an ordered table\n" TOY_CC_RESET);
+			Toy_freeOrderedTable(table);
+			return -1;
+		}
+
+		//lookup
+		Toy_Value result = Toy_lookupOrderedTable(&table, TOY_VALUE_FROM_INTEGER(1));
+		Toy_Value missing = Toy_lookupOrderedTable(&table, TOY_VALUE_FROM_INTEGER(2));
+
+		if (TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 42 ||
+			TOY_VALUE_IS_NULL(missing) != true)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to lookup from an ordered table\n" TOY_CC_RESET);
+			Toy_freeOrderedTable(table);
+			return -1;
+		}
+
+		//remove
+		Toy_removeOrderedTable(&table, TOY_VALUE_FROM_INTEGER(1));
+		result = Toy_lookupOrderedTable(&table, TOY_VALUE_FROM_INTEGER(1));
+
+		if (table->count != 0 ||
+			TOY_VALUE_IS_NULL(result) != true)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to remove from an ordered table\n" TOY_CC_RESET);
+			Toy_freeOrderedTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeOrderedTable(table);
+	}
+
+	return 0;
+}
+
+int test_ordered_table_iteration_order() {
+	//insertion order is kept through expansions, overrides and removals
+	{
+		//setup
+		Toy_OrderedTable* table = Toy_allocateOrderedTable();
+
+		for (int i = 0; i < 100; i++) {
+			Toy_insertOrderedTable(&table, TOY_VALUE_FROM_INTEGER(99 - i), TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		//override one, remove the odd keys
+		Toy_insertOrderedTable(&table, TOY_VALUE_FROM_INTEGER(98), TOY_VALUE_FROM_INTEGER(-1));
+
+		for (int i = 1; i < 100; i += 2) {
+			Toy_removeOrderedTable(&table, TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		//iterate
+		unsigned int iterator = 0;
+		int expected = 98;
+		int visited = 0;
+
+		for (Toy_OrderedTableEntry* entry = Toy_iterateOrderedTable(table, &iterator); entry != NULL; entry = Toy_iterateOrderedTable(table, &iterator)) {
+			if (TOY_VALUE_AS_INTEGER(entry->key) != expected ||
+				TOY_VALUE_AS_INTEGER(entry->value) != (expected == 98 ? -1 : 99 - expected))
+			{
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected entry %d in ordered table iteration\n" TOY_CC_RESET, visited);
+				Toy_freeOrderedTable(table);
+				return -1;
+			}
+
+			expected -= 2;
+			visited++;
+		}
+
+		if (table->capacity != 256 ||
+			table->count != 50 ||
+			visited != 50)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Ordered table iteration failed\n" TOY_CC_RESET);
+			Toy_freeOrderedTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeOrderedTable(table);
+	}
+
+	//removed entries are compacted away instead of expanding
+	{
+		//setup
+		Toy_OrderedTable* table = Toy_allocateOrderedTable();
+
+		for (int i = 0; i < 1000; i++) {
+			Toy_insertOrderedTable(&table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+			Toy_removeOrderedTable(&table, TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		Toy_insertOrderedTable(&table, TOY_VALUE_FROM_INTEGER(42), TOY_VALUE_FROM_INTEGER(69));
+		Toy_Value result = Toy_lookupOrderedTable(&table, TOY_VALUE_FROM_INTEGER(42));
+
+		if (table->capacity != 8 ||
+			table->count != 1 ||
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 69)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Ordered table compaction failed\n" TOY_CC_RESET);
+			Toy_freeOrderedTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeOrderedTable(table);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_ordered_table_allocation();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_ordered_table_simple_insert_lookup_and_remove();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_ordered_table_iteration_order();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
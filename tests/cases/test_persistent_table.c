@@ -0,0 +1,163 @@
+#include "toy_persistent_table.h"
+#include "toy_console_colors.h"
+
+#include <stdio.h>
+
+int test_persistent_table_simple_insert_lookup_and_remove() {
+	//simple insert
+	{
+		//setup
+		Toy_PersistentTable* table = Toy_allocatePersistentTable();
+
+		//insert
+		Toy_insertPersistentTable(&table, TOY_VALUE_FROM_INTEGER(1), TOY_VALUE_FROM_INTEGER(42));
+
+		//lookup
+		Toy_Value result = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_INTEGER(1));
+		Toy_Value missing = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_INTEGER(2));
+
+		if (table == NULL ||
+			table->count != 1 ||
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 42 ||
+			TOY_VALUE_IS_NULL(missing) != true)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to insert into a persistent table\n" TOY_CC_RESET);
+			Toy_freePersistentTable(table);
+			return -1;
+		}
+
+		//remove
+		Toy_removePersistentTable(&table, TOY_VALUE_FROM_INTEGER(1));
+		result = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_INTEGER(1));
+
+		if (table->count != 0 ||
+			table->root != NULL ||
+			TOY_VALUE_IS_NULL(result) != true)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to remove from a persistent table\n" TOY_CC_RESET);
+			Toy_freePersistentTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freePersistentTable(table);
+	}
+
+	//full hash collisions (the bits of 1.0f as an integer)
+	{
+		//setup
+		Toy_PersistentTable* table = Toy_allocatePersistentTable();
+
+		Toy_insertPersistentTable(&table, TOY_VALUE_FROM_INTEGER(1065353216), TOY_VALUE_FROM_INTEGER(1));
+		Toy_insertPersistentTable(&table, TOY_VALUE_FROM_FLOAT(1.0f), TOY_VALUE_FROM_INTEGER(2));
+
+		Toy_Value a = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_INTEGER(1065353216));
+		Toy_Value b = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_FLOAT(1.0f));
+
+		if (table->count != 2 ||
+			TOY_VALUE_AS_INTEGER(a) != 1 ||
+			TOY_VALUE_AS_INTEGER(b) != 2)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to handle hash collisions in a persistent table\n" TOY_CC_RESET);
+			Toy_freePersistentTable(table);
+			return -1;
+		}
+
+		Toy_removePersistentTable(&table, TOY_VALUE_FROM_INTEGER(1065353216));
+		b = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_FLOAT(1.0f));
+
+		if (table->count != 1 ||
+			TOY_VALUE_AS_INTEGER(b) != 2)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to remove hash collisions from a persistent table\n" TOY_CC_RESET);
+			Toy_freePersistentTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freePersistentTable(table);
+	}
+
+	return 0;
+}
+
+int test_persistent_table_snapshots() {
+	//snapshots are unaffected by later changes
+	{
+		//setup
+		Toy_PersistentTable* table = Toy_allocatePersistentTable();
+
+		for (int i = 0; i < 1000; i++) {
+			Toy_insertPersistentTable(&table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		Toy_PersistentTable* snapshot = Toy_copyPersistentTable(table);
+
+		//modify the original
+		for (int i = 0; i < 500; i++) {
+			Toy_removePersistentTable(&table, TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		Toy_insertPersistentTable(&table, TOY_VALUE_FROM_INTEGER(999), TOY_VALUE_FROM_INTEGER(-1));
+		Toy_insertPersistentTable(&table, TOY_VALUE_FROM_INTEGER(1000), TOY_VALUE_FROM_INTEGER(1000));
+		Toy_private_findPersistentEntry(&table, TOY_VALUE_FROM_INTEGER(700), true, NULL)->value = TOY_VALUE_FROM_INTEGER(-2);
+
+		//check both
+		for (int i = 0; i < 1000; i++) {
+			Toy_Value original = Toy_lookupPersistentTable(&table, TOY_VALUE_FROM_INTEGER(i));
+			Toy_Value copied = Toy_lookupPersistentTable(&snapshot, TOY_VALUE_FROM_INTEGER(i));
+
+			int expected = i < 500 ? 0 : i == 999 ? -1 : i == 700 ? -2 : i;
+
+			if ((i < 500 && TOY_VALUE_IS_NULL(original) != true) ||
+				(i >= 500 && TOY_VALUE_AS_INTEGER(original) != expected) ||
+				TOY_VALUE_AS_INTEGER(copied) != i)
+			{
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Persistent table snapshot mismatch at %d\n" TOY_CC_RESET, i);
+				Toy_freePersistentTable(table);
+				Toy_freePersistentTable(snapshot);
+				return -1;
+			}
+		}
+
+		if (table->count != 501 ||
+			snapshot->count != 1000 ||
+			TOY_VALUE_IS_NULL(Toy_lookupPersistentTable(&snapshot, TOY_VALUE_FROM_INTEGER(1000))) != true)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Persistent table snapshot counts are wrong\n" TOY_CC_RESET);
+			Toy_freePersistentTable(table);
+			Toy_freePersistentTable(snapshot);
+			return -1;
+		}
+
+		//free
+		Toy_freePersistentTable(table);
+		Toy_freePersistentTable(snapshot);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_persistent_table_simple_insert_lookup_and_remove();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_persistent_table_snapshots();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
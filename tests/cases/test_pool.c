@@ -0,0 +1,222 @@
+#include "toy_pool.h"
+#include "toy_console_colors.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int test_pool_results() {
+	//each script's output and status is captured separately
+	{
+		//setup
+		Toy_Pool* pool = Toy_allocatePool(3);
+
+		const char* sources[] = {
+			"print 1;",
+			"var a = 2; print a * 21;",
+			"assert false, \"failed\";",
+			"var a = 1; yield a; yield a + 1;",
+			"var = 1;",
+		};
+
+		unsigned int tickets[5];
+		for (int i = 0; i < 5; i++) {
+			tickets[i] = Toy_submitPool(pool, sources[i]);
+		}
+
+		Toy_waitPool(pool);
+
+		Toy_PoolResult* r0 = Toy_getPoolResult(pool, tickets[0]);
+		Toy_PoolResult* r1 = Toy_getPoolResult(pool, tickets[1]);
+		Toy_PoolResult* r2 = Toy_getPoolResult(pool, tickets[2]);
+		Toy_PoolResult* r3 = Toy_getPoolResult(pool, tickets[3]);
+		Toy_PoolResult* r4 = Toy_getPoolResult(pool, tickets[4]);
+
+		//check the state
+		if (Toy_getPoolWorkerCount(pool) != 3 ||
+			Toy_getPoolResult(pool, 5) != NULL ||
+
+			r0->compiled != true ||
+			r0->status != TOY_VM_STATUS_OK ||
+			r0->output == NULL || strcmp(r0->output, "1\n") != 0 ||
+			r0->errors != NULL ||
+
+			r1->status != TOY_VM_STATUS_OK ||
+			r1->output == NULL || strcmp(r1->output, "42\n") != 0 ||
+
+			r2->compiled != true ||
+			r2->errors == NULL || strcmp(r2->errors, "failed\n") != 0 ||
+			r2->output != NULL ||
+
+			r3->status != TOY_VM_STATUS_OK ||
+			r3->output == NULL || strcmp(r3->output, "1\n2\n") != 0 ||
+
+			r4->compiled != false ||
+			r4->status != TOY_VM_STATUS_PANIC
+			)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected results from a 'Toy_Pool'\n" TOY_CC_RESET);
+			Toy_freePool(pool);
+			return -1;
+		}
+
+		//free
+		Toy_freePool(pool);
+	}
+
+	return 0;
+}
+
+int test_pool_many_scripts() {
+	//more scripts than workers, so the deques fill up and get stolen from
+	{
+		//setup
+		Toy_Pool* pool = Toy_allocatePool(4);
+
+		char sources[200][64];
+		for (int i = 0; i < 200; i++) {
+			snprintf(sources[i], 64, "var a = %d; { var b = a * 2; print b; }", i);
+			Toy_submitPool(pool, sources[i]);
+		}
+
+		Toy_waitPool(pool);
+
+		//check the state
+		for (int i = 0; i < 200; i++) {
+			Toy_PoolResult* result = Toy_getPoolResult(pool, i);
+
+			char expected[32];
+			snprintf(expected, 32, "%d\n", i * 2);
+
+			if (result->status != TOY_VM_STATUS_OK || result->output == NULL || strcmp(result->output, expected) != 0) {
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected result for script %d in a 'Toy_Pool'\n" TOY_CC_RESET, i);
+				Toy_freePool(pool);
+				return -1;
+			}
+		}
+
+		//the pool can be reused after a wait
+		unsigned int ticket = Toy_submitPool(pool, "print \"again\";");
+		Toy_waitPool(pool);
+
+		Toy_PoolResult* result = Toy_getPoolResult(pool, ticket);
+		if (ticket != 200 || result->output == NULL || strcmp(result->output, "again\n") != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reuse a 'Toy_Pool'\n" TOY_CC_RESET);
+			Toy_freePool(pool);
+			return -1;
+		}
+
+		//free
+		Toy_freePool(pool);
+	}
+
+	return 0;
+}
+
+int test_pool_reuse() {
+	//one worker runs every script in the same VM, so nothing may carry over
+	{
+		//setup
+		Toy_Pool* pool = Toy_allocatePool(1);
+
+		unsigned int first = Toy_submitPool(pool, "var a = 1; print a;");
+		unsigned int second = Toy_submitPool(pool, "var a = 2; print a;");
+		Toy_waitPool(pool);
+
+		Toy_PoolResult* r0 = Toy_getPoolResult(pool, first);
+		Toy_PoolResult* r1 = Toy_getPoolResult(pool, second);
+
+		//check the state
+		if (r0->status != TOY_VM_STATUS_OK || r0->output == NULL || strcmp(r0->output, "1\n") != 0 ||
+			r1->status != TOY_VM_STATUS_OK || r1->output == NULL || strcmp(r1->output, "2\n") != 0 || r1->errors != NULL)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: State carried over between scripts in a 'Toy_Pool'\n" TOY_CC_RESET);
+			Toy_freePool(pool);
+			return -1;
+		}
+
+		//free
+		Toy_freePool(pool);
+	}
+
+	//the compile options apply to every script
+	{
+		//setup
+		Toy_Pool* pool = Toy_allocatePool(2);
+		Toy_configurePool(pool, true, true);
+
+		unsigned int ticket = Toy_submitPool(pool, "print 1; assert false, \"failed\"; print 2;");
+		Toy_waitPool(pool);
+
+		Toy_PoolResult* result = Toy_getPoolResult(pool, ticket);
+
+		//check the state
+		if (result->status != TOY_VM_STATUS_OK || result->output == NULL || strcmp(result->output, "1\n2\n") != 0 || result->errors != NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to configure a 'Toy_Pool'\n" TOY_CC_RESET);
+			Toy_freePool(pool);
+			return -1;
+		}
+
+		//free
+		Toy_freePool(pool);
+	}
+
+	//lots of output is gathered in one buffer
+	{
+		//setup
+		Toy_Pool* pool = Toy_allocatePool(1);
+
+		char source[1000 * 12];
+		unsigned int length = 0;
+		for (int i = 0; i < 1000; i++) {
+			length += sprintf(source + length, "print %d;", i % 10);
+		}
+
+		unsigned int ticket = Toy_submitPool(pool, source);
+		Toy_waitPool(pool);
+
+		Toy_PoolResult* result = Toy_getPoolResult(pool, ticket);
+
+		//check the state
+		if (result->status != TOY_VM_STATUS_OK || result->output == NULL || result->outputLength != 2000 || strcmp(result->output + 1990, "5\n6\n7\n8\n9\n") != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to capture long output from a 'Toy_Pool'\n" TOY_CC_RESET);
+			Toy_freePool(pool);
+			return -1;
+		}
+
+		//free
+		Toy_freePool(pool);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_pool_results();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_pool_many_scripts();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_pool_reuse();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
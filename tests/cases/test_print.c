@@ -94,6 +94,82 @@ int test_callbacks() {
 	return 0;
 }
 
+void countContext(const char* msg, void* userData) {
+	(*(int*)userData)++;
+}
+
+int test_contexts() {
+	//a thread's context takes priority over the globals, until it's swapped out
+	{
+		//setup
+		int contextCounter = 0;
+		Toy_setPrintCallback(count);
+
+		Toy_PrintContext context = { .printCallback = countContext, .userData = &contextCounter };
+		Toy_PrintContext* previous = Toy_swapPrintContext(&context);
+
+		//invoke
+		Toy_print("");
+		Toy_print("");
+
+		//check
+		if (previous != NULL || contextCounter != 2 || counter != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to route print through a 'Toy_PrintContext'\n" TOY_CC_RESET);
+			Toy_swapPrintContext(previous);
+			Toy_resetPrintCallback();
+			return -1;
+		}
+
+		//restore and retry
+		if (Toy_swapPrintContext(previous) != &context) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to swap out a 'Toy_PrintContext'\n" TOY_CC_RESET);
+			Toy_resetPrintCallback();
+			return -1;
+		}
+
+		Toy_print("");
+
+		if (contextCounter != 2 || counter != 1) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to restore the global print callback\n" TOY_CC_RESET);
+			Toy_resetPrintCallback();
+			return -1;
+		}
+
+		//cleanup
+		Toy_resetPrintCallback();
+		counter = 0;
+	}
+
+	//a context's NULL callbacks fall back to the globals
+	{
+		//setup
+		int contextCounter = 0;
+		Toy_setErrorCallback(count);
+
+		Toy_PrintContext context = { .assertCallback = countContext, .userData = &contextCounter };
+		Toy_PrintContext* previous = Toy_swapPrintContext(&context);
+
+		//invoke
+		Toy_error("");
+		Toy_assertFailure("");
+
+		Toy_swapPrintContext(previous);
+
+		//check
+		if (contextCounter != 1 || counter != 1) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to fall back to the global callbacks from a 'Toy_PrintContext'\n" TOY_CC_RESET);
+			Toy_resetErrorCallback();
+			return -1;
+		}
+
+		//cleanup
+		Toy_resetErrorCallback();
+		counter = 0;
+	}
+
+	return 0;
+}
+
 int main() {
 	//run each test set, returning the total errors given
 	int total = 0, res = 0;
@@ -106,6 +182,14 @@ int main() {
 		total += res;
 	}
 
+	{
+		res = test_contexts();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
 	return total;
 }
 
@@ -993,6 +993,38 @@ int test_routine_keywords(Toy_Bucket** bucketHandle) {
 		free(buffer);
 	}
 
+	//repeated strings
+	{
+		//setup
+		const char* source = "var foobar = \"foobar\"; foobar = foobar .. \"foobar\"; print foobar;";
+		Toy_Lexer lexer;
+		Toy_Parser parser;
+
+		Toy_bindLexer(&lexer, source);
+		Toy_bindParser(&parser, &lexer);
+		Toy_Ast* ast = Toy_scanParser(bucketHandle, &parser);
+
+		//run
+		void* buffer = Toy_compileRoutine(ast);
+
+		//check header
+		int* header = (int*)buffer;
+
+		//the names and literals share one jump and one copy of the data
+		if (header[2] != 4 || //jumps size
+			header[3] != 8) //data size
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: failed to deduplicate the routine strings, found %d jumps and %d data, source: %s\n" TOY_CC_RESET, header[2], header[3], source);
+
+			//cleanup and return
+			free(buffer);
+			return -1;
+		}
+
+		//cleanup
+		free(buffer);
+	}
+
 	return 0;
 }
 
@@ -20,8 +20,7 @@ int test_scope_allocation() {
 		//check
 		if (scope == NULL ||
 			scope->next != NULL ||
-			scope->table == NULL ||
-			scope->table->capacity != 8 ||
+			scope->table != NULL ||
 			scope->refCount != 1 ||
 
 			false)
@@ -53,28 +52,23 @@ int test_scope_allocation() {
 		if (
 			scope == NULL ||
 			scope->next == NULL ||
-			scope->table == NULL ||
-			scope->table->capacity != 8 ||
+			scope->table != NULL ||
 			scope->refCount != 1 ||
 
 			scope->next->next == NULL ||
-			scope->next->table == NULL ||
-			scope->next->table->capacity != 8 ||
+			scope->next->table != NULL ||
 			scope->next->refCount != 2 ||
 
 			scope->next->next->next == NULL ||
-			scope->next->next->table == NULL ||
-			scope->next->next->table->capacity != 8 ||
+			scope->next->next->table != NULL ||
 			scope->next->next->refCount != 3 ||
 
 			scope->next->next->next->next == NULL ||
-			scope->next->next->next->table == NULL ||
-			scope->next->next->next->table->capacity != 8 ||
+			scope->next->next->next->table != NULL ||
 			scope->next->next->next->refCount != 4 ||
 
 			scope->next->next->next->next->next != NULL ||
-			scope->next->next->next->next->table == NULL ||
-			scope->next->next->next->next->table->capacity != 8 ||
+			scope->next->next->next->next->table != NULL ||
 			scope->next->next->next->next->refCount != 5 || //refCount includes all ancestors
 
 			false)
@@ -114,18 +108,15 @@ int test_scope_allocation() {
 		if (
 			scope == NULL ||
 			scope->next == NULL ||
-			scope->table == NULL ||
-			scope->table->capacity != 8 ||
+			scope->table != NULL ||
 			scope->refCount != 1 ||
 
 			scope->next->next == NULL ||
-			scope->next->table == NULL ||
-			scope->next->table->capacity != 8 ||
+			scope->next->table != NULL ||
 			scope->next->refCount != 2 ||
 
 			scope->next->next->next != NULL ||
-			scope->next->next->table == NULL ||
-			scope->next->next->table->capacity != 8 ||
+			scope->next->next->table != NULL ||
 			scope->next->next->refCount != 3 ||
 
 			false)
@@ -159,20 +150,17 @@ int test_scope_allocation() {
 		if (
 			scopeBase == NULL ||
 			scopeBase->next != NULL ||
-			scopeBase->table == NULL ||
-			scopeBase->table->capacity != 8 ||
+			scopeBase->table != NULL ||
 			scopeBase->refCount != 3 ||
 
 			scopeA == NULL ||
 			scopeA->next != scopeBase ||
-			scopeA->table == NULL ||
-			scopeA->table->capacity != 8 ||
+			scopeA->table != NULL ||
 			scopeA->refCount != 1 ||
 
 			scopeB == NULL ||
 			scopeB->next != scopeBase ||
-			scopeB->table == NULL ||
-			scopeB->table->capacity != 8 ||
+			scopeB->table != NULL ||
 			scopeB->refCount != 1 ||
 
 			scopeA->next != scopeB->next || //double check
@@ -211,21 +199,18 @@ int test_scope_allocation() {
 		if (
 			scopeA == NULL ||
 			scopeA->next != NULL ||
-			scopeA->table == NULL ||
-			scopeA->table->capacity != 8 ||
+			scopeA->table != NULL ||
 			scopeA->refCount != 2 ||
 
 			//scopeB still exists in memory until scopeC is popped
 			scopeB == NULL ||
 			scopeB->next != scopeA ||
-			scopeB->table == NULL ||
-			scopeB->table->capacity != 8 ||
+			scopeB->table != NULL ||
 			scopeB->refCount != 1 ||
 
 			scopeC == NULL ||
 			scopeC->next != scopeB ||
-			scopeC->table == NULL ||
-			scopeC->table->capacity != 8 ||
+			scopeC->table != NULL ||
 			scopeC->refCount != 1 ||
 
 			false)
@@ -258,20 +243,17 @@ int test_scope_allocation() {
 		if (
 			scopeA == NULL ||
 			scopeA->next != NULL ||
-			scopeA->table == NULL ||
-			scopeA->table->capacity != 8 ||
+			scopeA->table != NULL ||
 			scopeA->refCount != 3 ||
 
 			scopeB == NULL ||
 			scopeB->next != scopeA ||
-			scopeB->table == NULL ||
-			scopeB->table->capacity != 8 ||
+			scopeB->table != NULL ||
 			scopeB->refCount != 1 ||
 
 			scopeB == NULL ||
 			scopeB->next != scopeA ||
-			scopeB->table == NULL ||
-			scopeB->table->capacity != 8 ||
+			scopeB->table != NULL ||
 			scopeB->refCount != 1 ||
 
 			scopeB == scopeCopy ||
@@ -489,6 +471,241 @@ int test_scope_elements() {
 	return 0;
 }
 
+int test_scope_table_pool() {
+	//tables are recycled between scopes through the pool
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_TablePool pool;
+		Toy_initTablePool(&pool);
+
+		Toy_Scope* scope = Toy_pushScope(&bucket, NULL);
+		scope->pool = &pool;
+
+		Toy_String* hello = Toy_createNameStringLength(&bucket, "hello", 5, TOY_VALUE_ANY, false);
+
+		//declare in an inner scope, then pop it
+		Toy_Scope* inner = Toy_pushScope(&bucket, scope);
+		Toy_declareScope(inner, hello, TOY_VALUE_FROM_INTEGER(42));
+		Toy_Table* recycled = inner->table;
+		Toy_popScope(inner);
+
+		//check the table is pooled and emptied
+		if (inner->pool != &pool ||
+			recycled == NULL ||
+			pool.counts[0] != 1 ||
+			pool.tables[0][0] != recycled ||
+			recycled->count != 0 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to release a table to the pool\n" TOY_CC_RESET);
+			Toy_freeString(hello);
+			Toy_popScope(scope);
+			Toy_freeTablePool(&pool);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//the next declaration reuses it
+		inner = Toy_pushScope(&bucket, scope);
+		Toy_declareScope(inner, hello, TOY_VALUE_FROM_INTEGER(69));
+		Toy_Value result = Toy_accessScope(inner, hello);
+
+		if (inner->table != recycled ||
+			pool.counts[0] != 0 ||
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 69 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reuse a table from the pool\n" TOY_CC_RESET);
+			Toy_freeString(hello);
+			Toy_popScope(inner);
+			Toy_popScope(scope);
+			Toy_freeTablePool(&pool);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeString(hello);
+		Toy_popScope(inner);
+		Toy_popScope(scope);
+		Toy_freeTablePool(&pool);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int test_scope_copy_on_write() {
+	//copies share the table until one of them is modified
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Scope* scope = Toy_pushScope(&bucket, NULL);
+
+		Toy_String* hello = Toy_createNameStringLength(&bucket, "hello", 5, TOY_VALUE_ANY, false);
+		Toy_String* world = Toy_createNameStringLength(&bucket, "world", 5, TOY_VALUE_ANY, false);
+
+		Toy_declareScope(scope, hello, TOY_VALUE_FROM_INTEGER(42));
+
+		Toy_Scope* copy = Toy_deepCopyScope(&bucket, scope);
+		Toy_Table* shared = scope->table;
+
+		//check the table is shared
+		if (copy->table != shared ||
+			shared->refCount != 2 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(copy, hello)) != 42 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to share a table between copied scopes\n" TOY_CC_RESET);
+			Toy_freeString(hello);
+			Toy_popScope(copy);
+			Toy_popScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//assigning through the copy gives it its own table
+		Toy_assignScope(copy, hello, TOY_VALUE_FROM_INTEGER(69));
+
+		if (copy->table == shared ||
+			scope->table != shared ||
+			shared->refCount != 1 ||
+			copy->table->refCount != 1 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(copy, hello)) != 69 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(scope, hello)) != 42 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to copy a shared table on assignment\n" TOY_CC_RESET);
+			Toy_freeString(hello);
+			Toy_popScope(copy);
+			Toy_popScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//declaring through the original does the same
+		Toy_Scope* second = Toy_deepCopyScope(&bucket, scope);
+		Toy_declareScope(scope, world, TOY_VALUE_FROM_INTEGER(420));
+
+		if (second->table != shared ||
+			scope->table == shared ||
+			shared->refCount != 1 ||
+			Toy_isDeclaredScope(second, world) != false ||
+			Toy_isDeclaredScope(scope, world) != true ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(scope, hello)) != 42 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to copy a shared table on declaration\n" TOY_CC_RESET);
+			Toy_freeString(hello);
+			Toy_popScope(second);
+			Toy_popScope(copy);
+			Toy_popScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeString(world);
+		Toy_freeString(hello);
+		Toy_popScope(second);
+		Toy_popScope(copy);
+		Toy_popScope(scope);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int test_scope_persistent() {
+	//persistent scopes share the trie, and only copy the path to a modified entry
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Scope* scope = Toy_pushPersistentScope(&bucket, NULL);
+
+		Toy_String* hello = Toy_createNameStringLength(&bucket, "hello", 5, TOY_VALUE_ANY, false);
+		Toy_String* world = Toy_createNameStringLength(&bucket, "world", 5, TOY_VALUE_ANY, false);
+
+		Toy_declareScope(scope, hello, TOY_VALUE_FROM_INTEGER(42));
+
+		Toy_Scope* copy = Toy_deepCopyScope(&bucket, scope);
+
+		//check the trie is shared
+		if (scope->table != NULL ||
+			copy->table != NULL ||
+			copy->persistent == NULL ||
+			copy->persistent->root != scope->persistent->root ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(copy, hello)) != 42 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to share a trie between copied persistent scopes\n" TOY_CC_RESET);
+			Toy_freeString(world);
+			Toy_freeString(hello);
+			Toy_popScope(copy);
+			Toy_popScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//assigning through the copy leaves the original untouched
+		Toy_assignScope(copy, hello, TOY_VALUE_FROM_INTEGER(69));
+
+		if (copy->persistent->root == scope->persistent->root ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(copy, hello)) != 69 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(scope, hello)) != 42 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to copy a shared path on assignment\n" TOY_CC_RESET);
+			Toy_freeString(world);
+			Toy_freeString(hello);
+			Toy_popScope(copy);
+			Toy_popScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//declaring through the original does the same
+		Toy_Scope* second = Toy_deepCopyScope(&bucket, scope);
+		Toy_declareScope(scope, world, TOY_VALUE_FROM_INTEGER(420));
+
+		if (Toy_isDeclaredScope(second, world) != false ||
+			Toy_isDeclaredScope(copy, world) != false ||
+			Toy_isDeclaredScope(scope, world) != true ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(second, hello)) != 42 ||
+
+			false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to copy a shared path on declaration\n" TOY_CC_RESET);
+			Toy_freeString(world);
+			Toy_freeString(hello);
+			Toy_popScope(second);
+			Toy_popScope(copy);
+			Toy_popScope(scope);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeString(world);
+		Toy_freeString(hello);
+		Toy_popScope(second);
+		Toy_popScope(copy);
+		Toy_popScope(scope);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
 int main() {
 	//run each test set, returning the total errors given
 	int total = 0, res = 0;
@@ -509,5 +726,29 @@ int main() {
 		total += res;
 	}
 
+	{
+		res = test_scope_table_pool();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_scope_copy_on_write();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_scope_persistent();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
 	return total;
 }
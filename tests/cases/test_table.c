@@ -605,6 +605,205 @@ int test_table_expansions_under_stress() {
 	return 0;
 }
 
+int test_table_contractions() {
+	//expand, then contract by removing
+	{
+		//setup
+		Toy_Table* table = Toy_allocateTable();
+
+		for (int i = 0; i < 400; i++) {
+			Toy_insertTable(&table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		//remove most of the entries
+		for (int i = 0; i < 390; i++) {
+			Toy_removeTable(&table, TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		Toy_Value result = Toy_lookupTable(&table, TOY_VALUE_FROM_INTEGER(395));
+
+		//check the state
+		if (table == NULL ||
+			table->capacity != 32 ||
+			table->count != 10 ||
+
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 395
+			)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Table contractions by removal failed\n" TOY_CC_RESET);
+			Toy_freeTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeTable(table);
+	}
+
+	//insert and remove on the boundary, without thrashing
+	{
+		//setup
+		Toy_Table* table = Toy_allocateTable();
+
+		for (int i = 0; i < 7; i++) {
+			Toy_insertTable(&table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		//crosses the expansion threshold
+		Toy_insertTable(&table, TOY_VALUE_FROM_INTEGER(7), TOY_VALUE_FROM_INTEGER(7));
+		Toy_removeTable(&table, TOY_VALUE_FROM_INTEGER(7));
+		Toy_insertTable(&table, TOY_VALUE_FROM_INTEGER(7), TOY_VALUE_FROM_INTEGER(7));
+		Toy_removeTable(&table, TOY_VALUE_FROM_INTEGER(7));
+
+		//check the state
+		if (table == NULL ||
+			table->capacity != 16 ||
+			table->count != 7
+			)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Table contractions on the boundary failed\n" TOY_CC_RESET);
+			Toy_freeTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeTable(table);
+	}
+
+	//explicit compaction
+	{
+		//setup
+		Toy_Table* table = Toy_allocateTable();
+
+		for (int i = 0; i < 400; i++) {
+			Toy_insertTable(&table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		for (int i = 0; i < 300; i++) {
+			Toy_removeTable(&table, TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		Toy_compactTable(&table);
+
+		Toy_Value result = Toy_lookupTable(&table, TOY_VALUE_FROM_INTEGER(365));
+
+		//check the state
+		if (table == NULL ||
+			table->capacity != 128 ||
+			table->count != 100 ||
+
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != 365
+			)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Table compaction failed\n" TOY_CC_RESET);
+			Toy_freeTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeTable(table);
+	}
+
+	return 0;
+}
+
+int test_table_bulk_build() {
+	//presized allocation
+	{
+		//setup
+		Toy_Table* table = Toy_allocateTableWithCapacity(100);
+
+		//check
+		if (table == NULL ||
+			table->capacity != 128 ||
+			table->count != 0)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to allocate a table with capacity\n" TOY_CC_RESET);
+			Toy_freeTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeTable(table);
+	}
+
+	//build from arrays, with and without sorting
+	for (int sorted = 0; sorted < 2; sorted++) {
+		//setup
+		Toy_Value keys[400];
+		Toy_Value values[400];
+
+		for (int i = 0; i < 400; i++) {
+			keys[i] = TOY_VALUE_FROM_INTEGER(i);
+			values[i] = TOY_VALUE_FROM_INTEGER(300 - i);
+		}
+
+		//duplicate keys override earlier ones
+		keys[399] = TOY_VALUE_FROM_INTEGER(265);
+
+		Toy_Table* table = Toy_buildTable(keys, values, 400, sorted);
+
+		Toy_Value result = Toy_lookupTable(&table, TOY_VALUE_FROM_INTEGER(265));
+		Toy_Value other = Toy_lookupTable(&table, TOY_VALUE_FROM_INTEGER(12));
+
+		//check the state
+		if (table == NULL ||
+			table->capacity != 512 ||
+			table->count != 399 ||
+
+			TOY_VALUE_IS_INTEGER(result) != true ||
+			TOY_VALUE_AS_INTEGER(result) != -99 ||
+			TOY_VALUE_IS_INTEGER(other) != true ||
+			TOY_VALUE_AS_INTEGER(other) != 288
+			)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Table bulk build failed (sorted: %d)\n" TOY_CC_RESET, sorted);
+			Toy_freeTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeTable(table);
+	}
+
+	return 0;
+}
+
+int test_table_iteration() {
+	//visit every entry once
+	{
+		//setup
+		Toy_Table* table = Toy_allocateTable();
+
+		for (int i = 0; i < 100; i++) {
+			Toy_insertTable(&table, TOY_VALUE_FROM_INTEGER(i), TOY_VALUE_FROM_INTEGER(i));
+		}
+
+		//iterate
+		unsigned int iterator = 0;
+		int visited = 0;
+		int sum = 0;
+
+		for (Toy_TableEntry* entry = Toy_iterateTable(table, &iterator); entry != NULL; entry = Toy_iterateTable(table, &iterator)) {
+			visited++;
+			sum += TOY_VALUE_AS_INTEGER(entry->value);
+		}
+
+		//check the state
+		if (visited != 100 || sum != 4950) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Table iteration failed\n" TOY_CC_RESET);
+			Toy_freeTable(table);
+			return -1;
+		}
+
+		//free
+		Toy_freeTable(table);
+	}
+
+	return 0;
+}
+
 int main() {
 	//run each test set, returning the total errors given
 	int total = 0, res = 0;
@@ -649,5 +848,29 @@ int main() {
 		total += res;
 	}
 
+	{
+		res = test_table_contractions();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_table_bulk_build();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_table_iteration();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
 	return total;
 }
@@ -0,0 +1,232 @@
+#include "toy_transpiler.h"
+#include "toy_console_colors.h"
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//utils
+static Toy_Bytecode makeBytecodeFromSource(Toy_Bucket** bucketHandle, const char* source, bool dense) {
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(bucketHandle, &parser);
+
+	return dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+}
+
+int test_transpiler_routine() {
+	//each instruction becomes one line of C
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "var a = 1; a += 2; { print a .. \"\\\"?\"; } yield 1.5; assert a == 3;", false);
+
+		char* source = Toy_transpileBytecode(bc.ptr, bc.count, "script");
+
+		//check the output
+		const char* expected[] = {
+			"#include \"toy_vm.h\"",
+			"static const char* script_strings[] = {\n\t\"a\",\n\t\"\\\"\\?\",\n};",
+			"static void script_run(Toy_VM* vm) {",
+			"Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));",
+			"Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 1, false, 0);",
+			"Toy_private_nativeDuplicate(vm, true, ",
+			"Toy_private_nativeArithmetic(vm, TOY_OPCODE_ADD);\n\tToy_private_nativeAssign(vm, ",
+			"vm->scope = Toy_pushScope(&vm->scopeBucket, vm->scope);",
+			"Toy_private_nativeConcat(vm);\n\tToy_private_nativePrint(vm);",
+			"vm->scope = Toy_popScope(vm->scope);",
+			"Toy_pushStack(&vm->stack, TOY_VALUE_FROM_FLOAT(0x1.8p+0f));",
+			"vm->routineCounter = 1;\n\tToy_private_nativeYield(vm);\n\treturn;\n\n\tcase 1:",
+			"Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_EQUAL, false);",
+			"Toy_private_nativeAssert(vm, 1);\n\treturn;\n\t}\n}",
+			"const Toy_NativeRoutine script = {\n\t.run = script_run,\n\t.strings = script_strings,\n\t.stringCount = 2,",
+		};
+
+		for (unsigned int i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+			if (source == NULL || strstr(source, expected[i]) == NULL) {
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to find '%s' in the transpiled routine:\n%s\n" TOY_CC_RESET, expected[i], source != NULL ? source : "(null)");
+				free(source);
+				Toy_freeBytecode(bc);
+				Toy_freeBucket(&bucket);
+				return -1;
+			}
+		}
+
+		//free
+		free(source);
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//both encodings decode to the same instructions, so they transpile to the same C
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		const char* script = "var s: string = \"hello world\"; print s[0, 5]; var n = -70000; n %= 7; print !(n > 1) || true && 2 <= 3;";
+		Toy_Bytecode aligned = makeBytecodeFromSource(&bucket, script, false);
+		Toy_Bytecode dense = makeBytecodeFromSource(&bucket, script, true);
+
+		char* alignedSource = Toy_transpileBytecode(aligned.ptr, aligned.count, "script");
+		char* denseSource = Toy_transpileBytecode(dense.ptr, dense.count, "script");
+
+		//check the output
+		if (alignedSource == NULL || denseSource == NULL || strcmp(alignedSource, denseSource) != 0 || strstr(alignedSource, "TOY_VALUE_FROM_INTEGER(-70000)") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: The aligned and dense encodings transpiled differently:\n%s\n%s\n" TOY_CC_RESET, alignedSource != NULL ? alignedSource : "(null)", denseSource != NULL ? denseSource : "(null)");
+			free(alignedSource);
+			free(denseSource);
+			Toy_freeBytecode(aligned);
+			Toy_freeBytecode(dense);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		free(alignedSource);
+		free(denseSource);
+		Toy_freeBytecode(aligned);
+		Toy_freeBytecode(dense);
+		Toy_freeBucket(&bucket);
+	}
+
+	//routines without strings don't get a table
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print 42;", false);
+
+		char* source = Toy_transpileBytecode(bc.ptr, bc.count, "1 answer");
+
+		//check the output, including the name made into an identifier
+		if (source == NULL || strstr(source, "_strings") != NULL || strstr(source, "const Toy_NativeRoutine _1_answer = {") == NULL || strstr(source, ".strings = NULL,") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected output for a routine without strings:\n%s\n" TOY_CC_RESET, source != NULL ? source : "(null)");
+			free(source);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		free(source);
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int test_transpiler_bundle() {
+	//one routine per module, named after the bundle and the module
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+
+		Toy_Lexer lexer;
+		Toy_Parser parser;
+		Toy_Ast* modules[2];
+
+		Toy_bindLexer(&lexer, "print \"first\";");
+		Toy_bindParser(&parser, &lexer);
+		modules[0] = Toy_scanParser(&bucket, &parser);
+
+		Toy_bindLexer(&lexer, "print \"second\";");
+		Toy_bindParser(&parser, &lexer);
+		modules[1] = Toy_scanParser(&bucket, &parser);
+
+		const char* names[] = { "first", "second-module" };
+		Toy_Bytecode bc = Toy_compileBundle(modules, names, 2, true);
+
+		char* source = Toy_transpileBytecode(bc.ptr, bc.count, "bundle");
+
+		//check the output
+		if (source == NULL ||
+			strstr(source, "const Toy_NativeRoutine bundle_first = {") == NULL ||
+			strstr(source, "const Toy_NativeRoutine bundle_second_module = {") == NULL ||
+			strstr(source, "\"second\"") == NULL)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected output for a bundle:\n%s\n" TOY_CC_RESET, source != NULL ? source : "(null)");
+			free(source);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		free(source);
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int test_transpiler_rejects() {
+	//routines that fail verification aren't transpiled
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print 42;", false);
+
+		//same as Toy_bindVM()
+		int offset = Toy_getBytecodeHeaderSize();
+
+		unsigned int codeAddr;
+		memcpy(&codeAddr, bc.ptr + offset + 20, sizeof(codeAddr));
+		bc.ptr[offset + codeAddr + 8] = 200; //the print
+
+		fprintf(stderr, TOY_CC_NOTICE "(the next error is expected)\n" TOY_CC_RESET);
+
+		char* source = Toy_transpileBytecode(bc.ptr, bc.count, "script");
+
+		//check the output
+		if (source != NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Transpiled a routine that failed verification:\n%s\n" TOY_CC_RESET, source);
+			free(source);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_transpiler_routine();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_transpiler_bundle();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_transpiler_rejects();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
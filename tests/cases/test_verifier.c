@@ -0,0 +1,433 @@
+#include "toy_verifier.h"
+#include "toy_console_colors.h"
+
+#include "toy_lexer.h"
+#include "toy_parser.h"
+#include "toy_bytecode.h"
+#include "toy_vm.h"
+#include "toy_opcodes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//utils
+static Toy_Bytecode makeBytecodeFromSource(Toy_Bucket** bucketHandle, const char* source, bool dense) {
+	Toy_Lexer lexer;
+	Toy_bindLexer(&lexer, source);
+	Toy_Parser parser;
+	Toy_bindParser(&parser, &lexer);
+	Toy_Ast* ast = Toy_scanParser(bucketHandle, &parser);
+
+	return dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+}
+
+//same as Toy_bindVM()
+static unsigned char* findRoutine(Toy_Bytecode bc) {
+	int offset = Toy_getBytecodeHeaderSize();
+
+	return bc.ptr + offset;
+}
+
+static unsigned int findRoutineLength(Toy_Bytecode bc) {
+	return bc.count - (unsigned int)(findRoutine(bc) - bc.ptr);
+}
+
+//NOTE: only for routines without params
+static unsigned char* findCode(unsigned char* routine) {
+	unsigned int codeAddr;
+	memcpy(&codeAddr, routine + 20, sizeof(codeAddr));
+	return routine + codeAddr;
+}
+
+int test_verifier_accepts() {
+	//everything the compiler emits is accepted, in either encoding
+	for (int dense = 0; dense < 2; dense++) {
+		//setup
+		const char* sources[] = {
+			"print 42;",
+			"var a: int = 1; a += 2; a -= 1; a *= 3; a /= 2; a %= 2; print a;",
+			"var s = \"hello world\"; print s[0, 5]; print s[6];",
+			"assert true; assert 1 < 2, \"message\"; print 1 != 2;",
+			"{ var a = 1; { var b = a; print a .. \"\" == \"\"; } }",
+			"var x = null; yield x; var b = true && false || !false; yield b;",
+			"print 1.5 >= 2 && 3 <= 4 || 5 > 6;",
+		};
+
+		for (unsigned int i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+			Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+			Toy_Bytecode bc = makeBytecodeFromSource(&bucket, sources[i], dense);
+
+			char msg[256] = "";
+			bool verified = Toy_verifyRoutine(findRoutine(bc), findRoutineLength(bc), msg, 256);
+
+			//check the state
+			if (!verified) {
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to verify the %s routine of '%s': %s\n" TOY_CC_RESET, dense ? "dense" : "aligned", sources[i], msg);
+				Toy_freeBytecode(bc);
+				Toy_freeBucket(&bucket);
+				return -1;
+			}
+
+			//free
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+		}
+	}
+
+	return 0;
+}
+
+int test_verifier_rejects() {
+	//an invalid opcode
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print 42;", false);
+		unsigned char* routine = findRoutine(bc);
+
+		findCode(routine)[8] = 200; //the print
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Invalid opcode 200") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject an invalid opcode, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//a jump index past the end of the jump table
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print \"hello\";", false);
+		unsigned char* routine = findRoutine(bc);
+
+		unsigned int index = 64;
+		memcpy(findCode(routine) + 4, &index, sizeof(index));
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Invalid jump index") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject an invalid jump index, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//popping more than was pushed
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print 42;", false);
+		unsigned char* routine = findRoutine(bc);
+
+		findCode(routine)[0] = TOY_OPCODE_PRINT; //was the read
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Stack underflow") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject a stack underflow, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//a scope that's never popped
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "{ print 42; }", false);
+		unsigned char* routine = findRoutine(bc);
+
+		findCode(routine)[16] = TOY_OPCODE_SCOPE_PUSH; //was the pop
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Unbalanced scopes") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject unbalanced scopes, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//a dense jump slot that never ends
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print \"hello\";", true);
+		unsigned char* routine = findRoutine(bc);
+
+		memset(findCode(routine) + 4, 0xFF, 4); //the slot, the print and the return
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Truncated instruction") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject an unterminated varint, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//a dense jump slot that wraps around when scaled to a byte offset, or doesn't fit an int at all
+	for (int wide = 0; wide < 2; wide++) {
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print \"hello\"; print 1; print 2;", true);
+		unsigned char* routine = findRoutine(bc);
+		unsigned char* code = findCode(routine);
+
+		const unsigned char slot[] = { 0x80, 0x80, 0x80, 0x80, wide ? 0x14 : 0x04 }; //0x40000000, or 33 bits
+		memcpy(code + 4, slot, sizeof(slot)); //the slot, the first print and the next read
+		code[10] = TOY_OPCODE_RETURN; //after the print that follows
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, wide ? "Truncated instruction" : "Invalid jump index") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject an out of range dense jump slot, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//a routine too short for its own header
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print 42;", false);
+		unsigned char* routine = findRoutine(bc);
+
+		unsigned int size = 16;
+		memcpy(routine, &size, sizeof(size));
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Truncated routine header") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject a truncated header, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//a routine that runs past the end of its image, such as a truncated file
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print \"hello\";", false);
+		unsigned char* routine = findRoutine(bc);
+
+		char truncatedMsg[256] = "";
+		bool truncated = Toy_verifyRoutine(routine, findRoutineLength(bc) - 4, truncatedMsg, 256);
+
+		char headerMsg[256] = "";
+		bool header = Toy_verifyRoutine(routine, 8, headerMsg, 256);
+
+		//check the state
+		if (truncated || strstr(truncatedMsg, "Truncated routine") == NULL || header || strstr(headerMsg, "Truncated routine header") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject a truncated routine, found '%s' and '%s'\n" TOY_CC_RESET, truncatedMsg, headerMsg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	//more values left on the stack than it can hold, which would otherwise exit at runtime
+	{
+		//setup
+		unsigned int count = TOY_STACK_OVERFLOW + 1;
+		char* source = malloc(count * 2 + 1);
+		for (unsigned int i = 0; i < count; i++) {
+			memcpy(source + i * 2, "1;", 2);
+		}
+		source[count * 2] = '\0';
+
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, source, false);
+		unsigned char* routine = findRoutine(bc);
+
+		char msg[256] = "";
+		bool verified = Toy_verifyRoutine(routine, findRoutineLength(bc), msg, 256);
+
+		//check the state
+		if (verified || strstr(msg, "Stack overflow") == NULL) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reject a stack overflow, found '%s'\n" TOY_CC_RESET, msg);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			free(source);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+		free(source);
+	}
+
+	return 0;
+}
+
+int test_verifier_vm() {
+	//verified routines are run, and the rest are never bound
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode good = makeBytecodeFromSource(&bucket, "var a = 1; a += 1; assert a == 2;", false);
+		Toy_Bytecode bad = makeBytecodeFromSource(&bucket, "print 42;", false);
+
+		findCode(findRoutine(bad))[8] = 200; //the print
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		bool goodBound = Toy_bindVM(&vm, good.ptr, good.count);
+
+		Toy_VMStatus goodStatus = Toy_runVM(&vm);
+
+		Toy_freeVM(&vm);
+
+		fprintf(stderr, TOY_CC_NOTICE "(the next error is expected)\n" TOY_CC_RESET);
+
+		Toy_initVM(&vm);
+		bool badBound = Toy_bindVM(&vm, bad.ptr, bad.count);
+
+		Toy_VMStatus badStatus = Toy_runVM(&vm);
+
+		//check the state
+		if (goodBound != true ||
+			goodStatus != TOY_VM_STATUS_OK ||
+			badBound != false ||
+			badStatus != TOY_VM_STATUS_PANIC)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected verification results in a 'Toy_VM'\n" TOY_CC_RESET);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(good);
+			Toy_freeBytecode(bad);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(good);
+		Toy_freeBytecode(bad);
+		Toy_freeBucket(&bucket);
+	}
+
+	//truncated images are never bound, even when the version header fits
+	{
+		//setup
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		Toy_Bytecode bc = makeBytecodeFromSource(&bucket, "print 42;", false);
+
+		fprintf(stderr, TOY_CC_NOTICE "(the next two errors are expected)\n" TOY_CC_RESET);
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		bool shortBound = Toy_bindVM(&vm, bc.ptr, 4);
+		Toy_freeVM(&vm);
+
+		Toy_initVM(&vm);
+		bool truncatedBound = Toy_bindVM(&vm, bc.ptr, bc.count - 4);
+		Toy_VMStatus truncatedStatus = Toy_runVM(&vm);
+
+		//check the state
+		if (shortBound != false || truncatedBound != false || truncatedStatus != TOY_VM_STATUS_PANIC) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected results from binding a truncated image\n" TOY_CC_RESET);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			Toy_freeBucket(&bucket);
+			return -1;
+		}
+
+		//free
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+		Toy_freeBucket(&bucket);
+	}
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		res = test_verifier_accepts();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_verifier_rejects();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		res = test_verifier_vm();
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	return total;
+}
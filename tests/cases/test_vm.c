@@ -1,3 +1,6 @@
+//for pthreads, fileno and mmap under -std=c17
+#define _POSIX_C_SOURCE 200809L
+
 #include "toy_vm.h"
 #include "toy_console_colors.h"
 
@@ -6,10 +9,16 @@
 #include "toy_bytecode.h"
 #include "toy_print.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <pthread.h>
+	#include <sys/mman.h>
+#endif
+
 //utils
 Toy_Bytecode makeBytecodeFromSource(Toy_Bucket** bucketHandle, const char* source) { //did I forget this?
 	Toy_Lexer lexer;
@@ -44,13 +53,10 @@ int test_setup_and_teardown(Toy_Bucket** bucketHandle) {
 		//run the setup
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//check the header size
-		int headerSize = 3 + strlen(TOY_VERSION_BUILD) + 1;
-		if (headerSize % 4 != 0) {
-			headerSize += 4 - (headerSize % 4); //ceil
-		}
+		int headerSize = Toy_getBytecodeHeaderSize();
 
 		//check the routine was loaded correctly
 		if (
@@ -66,11 +72,13 @@ int test_setup_and_teardown(Toy_Bucket** bucketHandle) {
 
 			//cleanup and return
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
 		//don't run it this time, simply teadown
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	return 0;
@@ -95,7 +103,7 @@ int test_simple_execution(Toy_Bucket** bucketHandle) {
 		//run the setup
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -111,11 +119,13 @@ int test_simple_execution(Toy_Bucket** bucketHandle) {
 
 			//cleanup and return
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
 		//teadown
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	return 0;
@@ -140,7 +150,7 @@ int test_opcode_not_equal(Toy_Bucket** bucketHandle) {
 		//run the setup
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -156,11 +166,13 @@ int test_opcode_not_equal(Toy_Bucket** bucketHandle) {
 
 			//cleanup and return
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
 		//teadown
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	return 0;
@@ -193,7 +205,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -207,6 +219,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 			Toy_resetAssertFailureCallback();
 			free(callbackUtilReceived);
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
@@ -215,6 +228,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 		free(callbackUtilReceived);
 		callbackUtilReceived = NULL;
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	//test assert false
@@ -234,7 +248,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -249,6 +263,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 			Toy_resetAssertFailureCallback();
 			free(callbackUtilReceived);
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
@@ -257,6 +272,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 		free(callbackUtilReceived);
 		callbackUtilReceived = NULL;
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	//test assert false with message
@@ -276,7 +292,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -291,6 +307,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 			Toy_resetAssertFailureCallback();
 			free(callbackUtilReceived);
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
@@ -299,6 +316,7 @@ int test_keyword_assert(Toy_Bucket** bucketHandle) {
 		free(callbackUtilReceived);
 		callbackUtilReceived = NULL;
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	return 0;
@@ -322,7 +340,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -337,6 +355,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 			Toy_resetPrintCallback();
 			free(callbackUtilReceived);
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
@@ -345,6 +364,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 		free(callbackUtilReceived);
 		callbackUtilReceived = NULL;
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	//test print with a string
@@ -364,7 +384,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -379,6 +399,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 			Toy_resetPrintCallback();
 			free(callbackUtilReceived);
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
@@ -387,6 +408,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 		free(callbackUtilReceived);
 		callbackUtilReceived = NULL;
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	//test print with a string concat
@@ -406,7 +428,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -421,6 +443,48 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 			Toy_resetPrintCallback();
 			free(callbackUtilReceived);
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teadown
+		Toy_resetPrintCallback();
+		free(callbackUtilReceived);
+		callbackUtilReceived = NULL;
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	//test print with a string stored past the first 255 bytes of the data section
+	{
+		//setup
+		Toy_setPrintCallback(callbackUtil);
+		const char* source =
+			"var a = \"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\";"
+			"var b = \"bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\";"
+			"var c = \"cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc\";"
+			"print \"past the end\";";
+
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, source);
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		//run
+		Toy_runVM(&vm);
+
+		//check
+		if (callbackUtilReceived == NULL ||
+			strcmp(callbackUtilReceived, "past the end") != 0)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected value '%s' passed to print keyword, source: %s\n" TOY_CC_RESET, callbackUtilReceived != NULL ? callbackUtilReceived : "NULL", source);
+
+			//cleanup and return
+			Toy_resetPrintCallback();
+			free(callbackUtilReceived);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
@@ -429,6 +493,7 @@ int test_keyword_print(Toy_Bucket** bucketHandle) {
 		free(callbackUtilReceived);
 		callbackUtilReceived = NULL;
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	return 0;
@@ -453,7 +518,7 @@ int test_scope(Toy_Bucket** bucketHandle) {
 		//run the setup
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -475,11 +540,13 @@ int test_scope(Toy_Bucket** bucketHandle) {
 
 			//cleanup and return
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
 		//teadown
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	//test declaration with absent value
@@ -500,7 +567,7 @@ int test_scope(Toy_Bucket** bucketHandle) {
 		//run the setup
 		Toy_VM vm;
 		Toy_initVM(&vm);
-		Toy_bindVM(&vm, bc.ptr);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
 
 		//run
 		Toy_runVM(&vm);
@@ -520,11 +587,13 @@ int test_scope(Toy_Bucket** bucketHandle) {
 
 			//cleanup and return
 			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
 			return -1;
 		}
 
 		//teadown
 		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
 	return 0;
@@ -540,7 +609,7 @@ int test_vm_reuse(Toy_Bucket** bucketHandle) {
 
 		//run 1
 		Toy_Bytecode bc1 = makeBytecodeFromSource(bucketHandle, "print \"Hello world!\";");
-		Toy_bindVM(&vm, bc1.ptr);
+		Toy_bindVM(&vm, bc1.ptr, bc1.count);
 		Toy_runVM(&vm);
 		Toy_resetVM(&vm);
 
@@ -559,7 +628,7 @@ int test_vm_reuse(Toy_Bucket** bucketHandle) {
 
 		//run 2
 		Toy_Bytecode bc2 = makeBytecodeFromSource(bucketHandle, "print \"Hello world!\";");
-		Toy_bindVM(&vm, bc2.ptr);
+		Toy_bindVM(&vm, bc2.ptr, bc2.count);
 		Toy_runVM(&vm);
 		Toy_resetVM(&vm);
 
@@ -578,7 +647,7 @@ int test_vm_reuse(Toy_Bucket** bucketHandle) {
 
 		//run 3
 		Toy_Bytecode bc3 = makeBytecodeFromSource(bucketHandle, "print \"Hello world!\";");
-		Toy_bindVM(&vm, bc3.ptr);
+		Toy_bindVM(&vm, bc3.ptr, bc3.count);
 		Toy_runVM(&vm);
 		Toy_resetVM(&vm);
 
@@ -605,73 +674,1040 @@ int test_vm_reuse(Toy_Bucket** bucketHandle) {
 	return 0;
 }
 
-int main() {
-	//run each test set, returning the total errors given
-	int total = 0, res = 0;
+//counts the bytes partitioned from a bucket chain, including any expansions
+unsigned int countBucketUsage(Toy_Bucket* bucket) {
+	unsigned int total = 0;
+	for (Toy_Bucket* iter = bucket; iter != NULL; iter = iter->next) {
+		total += iter->count;
+	}
+	return total;
+}
 
+int test_access_allocations(Toy_Bucket** bucketHandle) {
+	//reading a variable shouldn't allocate any strings, cached or not
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_setup_and_teardown(&bucket);
-		Toy_freeBucket(&bucket);
-		if (res == 0) {
-			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "foobar; foobar; foobar; foobar;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "foobar", 6, TOY_VALUE_INTEGER, false);
+		Toy_declareScope(vm.scope, key, TOY_VALUE_FROM_INTEGER(42));
+		Toy_invalidateVMCaches(&vm);
+
+		unsigned int before = countBucketUsage(vm.stringBucket);
+
+		Toy_runVM(&vm);
+		Toy_runVM(&vm);
+
+		unsigned int after = countBucketUsage(vm.stringBucket);
+
+		if (before != after ||
+			vm.stack->count != 8 ||
+			TOY_VALUE_AS_INTEGER(Toy_peekStack(&vm.stack)) != 42 ||
+			vm.stats.cacheMisses != 4 ||
+			vm.stats.cacheHits != 4
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected allocations when accessing variables, %d bytes partitioned\n" TOY_CC_RESET, (int)(after - before));
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
 		}
-		total += res;
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
+	return 0;
+}
+
+int test_inline_caches(Toy_Bucket** bucketHandle) {
+	//repeated runs of the same routine should hit the caches
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_simple_execution(&bucket);
-		Toy_freeBucket(&bucket);
-		if (res == 0) {
-			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "x = x + 1;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "x", 1, TOY_VALUE_INTEGER, false);
+		Toy_declareScope(vm.scope, key, TOY_VALUE_FROM_INTEGER(0));
+		Toy_invalidateVMCaches(&vm);
+
+		Toy_runVM(&vm);
+		Toy_VMStats first = Toy_getVMStats(&vm);
+
+		Toy_runVM(&vm);
+		Toy_runVM(&vm);
+		Toy_VMStats second = Toy_getVMStats(&vm);
+
+		if (first.cacheHits != 0 ||
+			first.cacheMisses != 2 ||
+			second.cacheHits != 4 ||
+			second.cacheMisses != 2 ||
+			TOY_VALUE_IS_INTEGER(Toy_accessScope(vm.scope, key)) != true ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 3
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected inline cache stats, hits %d and misses %d\n" TOY_CC_RESET, (int)second.cacheHits, (int)second.cacheMisses);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
 		}
-		total += res;
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
+	//declaring should invalidate the caches, so shadowed entries are never used
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_opcode_not_equal(&bucket);
-		Toy_freeBucket(&bucket);
-		if (res == 0) {
-			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "x = x + 1;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "x", 1, TOY_VALUE_INTEGER, false);
+		Toy_declareScope(vm.scope, key, TOY_VALUE_FROM_INTEGER(0));
+		Toy_invalidateVMCaches(&vm);
+
+		Toy_runVM(&vm);
+
+		//shadow the outer variable
+		Toy_Scope* outer = vm.scope;
+		vm.scope = Toy_pushScope(&vm.scopeBucket, vm.scope);
+		Toy_declareScope(vm.scope, key, TOY_VALUE_FROM_INTEGER(10));
+		Toy_invalidateVMCaches(&vm);
+
+		Toy_runVM(&vm);
+		Toy_VMStats stats = Toy_getVMStats(&vm);
+
+		if (stats.cacheHits != 0 ||
+			stats.cacheMisses != 4 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 11 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(outer, key)) != 1
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected inline cache results after shadowing, hits %d and misses %d\n" TOY_CC_RESET, (int)stats.cacheHits, (int)stats.cacheMisses);
+
+			//cleanup and return
+			vm.scope = Toy_popScope(vm.scope);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
 		}
-		total += res;
+
+		//teardown
+		vm.scope = Toy_popScope(vm.scope);
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
+	//a cached assignment shouldn't write into a table shared with a copied scope
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_keyword_print(&bucket);
-		Toy_freeBucket(&bucket);
-		if (res == 0) {
-			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "x = x + 1;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "x", 1, TOY_VALUE_INTEGER, false);
+		Toy_declareScope(vm.scope, key, TOY_VALUE_FROM_INTEGER(0));
+		Toy_invalidateVMCaches(&vm);
+
+		Toy_runVM(&vm);
+
+		Toy_Scope* snapshot = Toy_deepCopyScope(&vm.scopeBucket, vm.scope);
+
+		Toy_runVM(&vm);
+		Toy_runVM(&vm);
+
+		if (snapshot->table == vm.scope->table ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(snapshot, key)) != 1 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 3
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected inline cache results after copying a scope\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_popScope(snapshot);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
 		}
-		total += res;
+
+		//teardown
+		Toy_popScope(snapshot);
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
+	//the same for a path shared with a copy of a persistent scope
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_keyword_assert(&bucket);
-		Toy_freeBucket(&bucket);
-		if (res == 0) {
-			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "x = x + x;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		vm.scope = Toy_pushPersistentScope(bucketHandle, NULL);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "x", 1, TOY_VALUE_INTEGER, false);
+		Toy_declareScope(vm.scope, key, TOY_VALUE_FROM_INTEGER(1));
+		Toy_invalidateVMCaches(&vm);
+
+		Toy_runVM(&vm);
+
+		Toy_Scope* snapshot = Toy_deepCopyScope(bucketHandle, vm.scope);
+
+		Toy_runVM(&vm);
+
+		if (snapshot->persistent == NULL ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(snapshot, key)) != 2 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 4
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected inline cache results after copying a persistent scope\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_popScope(snapshot);
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
 		}
-		total += res;
+
+		//teardown
+		Toy_popScope(snapshot);
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
 	}
 
+	return 0;
+}
+
+int test_panic(Toy_Bucket** bucketHandle) {
+	//a runtime error unwinds out of the routine, and the VM can be reused after a reset
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_scope(&bucket);
-		Toy_freeBucket(&bucket);
-		if (res == 0) {
-			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		Toy_setErrorCallback(callbackUtil);
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+
+		Toy_Bytecode bc1 = makeBytecodeFromSource(bucketHandle, "var a = 0; { var b = 42; { var c = b / a; } }");
+		Toy_bindVM(&vm, bc1.ptr, bc1.count);
+		Toy_Scope* root = vm.scope;
+
+		Toy_VMStatus first = Toy_runVM(&vm);
+		Toy_VMStatus second = Toy_runVM(&vm); //refused until reset
+
+		if (first != TOY_VM_STATUS_PANIC ||
+			second != TOY_VM_STATUS_PANIC ||
+			vm.panic != true ||
+			vm.scope != root ||
+			vm.stack->count != 0 ||
+			callbackUtilReceived == NULL ||
+			strcmp(callbackUtilReceived, "Can't divide or modulo by zero") != 0
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected state after a panic in 'Toy_VM', error '%s'\n" TOY_CC_RESET, callbackUtilReceived != NULL ? callbackUtilReceived : "NULL");
+
+			//cleanup and return
+			free(callbackUtilReceived);
+			callbackUtilReceived = NULL;
+			Toy_freeBytecode(bc1);
+			Toy_freeVM(&vm);
+			Toy_resetErrorCallback();
+			return -1;
 		}
-		total += res;
+
+		Toy_resetVM(&vm);
+		Toy_freeBytecode(bc1);
+
+		//run again, using the variable declared before the panic
+		Toy_Bytecode bc2 = makeBytecodeFromSource(bucketHandle, "a = a + 1;");
+		Toy_bindVM(&vm, bc2.ptr, bc2.count);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "a", 1, TOY_VALUE_ANY, false);
+		Toy_VMStatus third = Toy_runVM(&vm);
+
+		if (third != TOY_VM_STATUS_OK ||
+			vm.panic != false ||
+			TOY_VALUE_IS_INTEGER(Toy_accessScope(vm.scope, key)) != true ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 1
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to reuse 'Toy_VM' after a panic\n" TOY_CC_RESET);
+
+			//cleanup and return
+			free(callbackUtilReceived);
+			callbackUtilReceived = NULL;
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc2);
+			Toy_resetErrorCallback();
+			return -1;
+		}
+
+		//cleanup
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc2);
+		free(callbackUtilReceived);
+		callbackUtilReceived = NULL;
+		Toy_resetErrorCallback();
 	}
 
+	return 0;
+}
+
+int test_budget(Toy_Bucket** bucketHandle) {
+	//run a routine a few instructions at a time, resuming after each yield
 	{
-		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
-		res = test_vm_reuse(&bucket);
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = 1; { var b = 2; a = a + b; } var c = a * 10;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		int yields = 0;
+		Toy_VMStatus status;
+		while ((status = Toy_runVMFor(&vm, 2)) == TOY_VM_STATUS_YIELDED) {
+			yields++;
+		}
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "c", 1, TOY_VALUE_ANY, false);
+
+		if (status != TOY_VM_STATUS_OK ||
+			yields < 3 ||
+			vm.suspended != false ||
+			vm.stack->count != 0 ||
+			TOY_VALUE_IS_INTEGER(Toy_accessScope(vm.scope, key)) != true ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 30
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected result after running 'Toy_VM' with a budget, %d yields\n" TOY_CC_RESET, yields);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	//a yielded VM can also be finished without a budget
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = 1; { var b = 2; a = a + b; } var c = a * 10;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_VMStatus first = Toy_runVMFor(&vm, 3);
+		Toy_VMStatus second = Toy_runVM(&vm);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "c", 1, TOY_VALUE_ANY, false);
+
+		if (first != TOY_VM_STATUS_YIELDED ||
+			second != TOY_VM_STATUS_OK ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 30
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to resume a yielded 'Toy_VM' without a budget\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	return 0;
+}
+
+int test_keyword_yield(Toy_Bucket** bucketHandle) {
+	//a generator keeps its stack and scope between resumes
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = 1; yield a; { var b = a + 1; yield b * 10; a = b; } yield; var c = a;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		Toy_VMStatus first = Toy_runVM(&vm);
+		Toy_Value firstValue = vm.yieldValue;
+
+		Toy_VMStatus second = Toy_runVM(&vm);
+		Toy_Value secondValue = vm.yieldValue;
+
+		Toy_VMStatus third = Toy_runVM(&vm);
+		Toy_Value thirdValue = vm.yieldValue;
+
+		Toy_VMStatus last = Toy_runVM(&vm);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "c", 1, TOY_VALUE_ANY, false);
+
+		if (first != TOY_VM_STATUS_YIELDED_VALUE ||
+			TOY_VALUE_IS_INTEGER(firstValue) != true ||
+			TOY_VALUE_AS_INTEGER(firstValue) != 1 ||
+			second != TOY_VM_STATUS_YIELDED_VALUE ||
+			TOY_VALUE_IS_INTEGER(secondValue) != true ||
+			TOY_VALUE_AS_INTEGER(secondValue) != 20 ||
+			third != TOY_VM_STATUS_YIELDED_VALUE ||
+			TOY_VALUE_IS_NULL(thirdValue) != true ||
+			last != TOY_VM_STATUS_OK ||
+			vm.suspended != false ||
+			vm.stack->count != 0 ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) != 2
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected result after resuming a yielding 'Toy_VM'\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	//a budget runs out independently of the script's yields
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = 1; a = a + 1; yield a; a = a * 3; yield a;");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		int budgetYields = 0;
+		int valueYields = 0;
+		int sum = 0;
+
+		Toy_VMStatus status;
+		while ((status = Toy_runVMFor(&vm, 2)) != TOY_VM_STATUS_OK) {
+			if (status == TOY_VM_STATUS_YIELDED) {
+				budgetYields++;
+			}
+			else if (status == TOY_VM_STATUS_YIELDED_VALUE) {
+				valueYields++;
+				sum += TOY_VALUE_AS_INTEGER(vm.yieldValue);
+			}
+			else {
+				break;
+			}
+		}
+
+		if (status != TOY_VM_STATUS_OK ||
+			budgetYields < 2 ||
+			valueYields != 2 ||
+			sum != 8
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected result after mixing budgets and 'yield', %d budget yields, %d value yields, sum %d\n" TOY_CC_RESET, budgetYields, valueYields, sum);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	return 0;
+}
+
+static void callbackContext(const char* msg, void* userData) {
+	(*(int*)userData)++;
+}
+
+int test_print_context(Toy_Bucket** bucketHandle) {
+	//each VM's output goes to its own callbacks, leaving the globals alone
+	{
+		Toy_Bytecode bcA = makeBytecodeFromSource(bucketHandle, "print 1; print 2;");
+		Toy_Bytecode bcB = makeBytecodeFromSource(bucketHandle, "print 3; assert false, \"oops\";");
+
+		int printsA = 0, printsB = 0; //B counts its assert too
+
+		Toy_VM vmA;
+		Toy_initVM(&vmA);
+		Toy_setVMPrintContext(&vmA, (Toy_PrintContext){ .printCallback = callbackContext, .userData = &printsA });
+		Toy_bindVM(&vmA, bcA.ptr, bcA.count);
+
+		Toy_VM vmB;
+		Toy_initVM(&vmB);
+		Toy_setVMPrintContext(&vmB, (Toy_PrintContext){ .printCallback = callbackContext, .assertCallback = callbackContext, .userData = &printsB });
+		Toy_bindVM(&vmB, bcB.ptr, bcB.count);
+
+		Toy_setPrintCallback(callbackUtil);
+		Toy_setAssertFailureCallback(callbackUtil);
+
+		//interleave the two VMs
+		Toy_runVMFor(&vmA, 2);
+		Toy_runVM(&vmB);
+		Toy_runVM(&vmA);
+
+		if (printsA != 2 ||
+			printsB != 2 ||
+			callbackUtilReceived != NULL
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected output routing through 'Toy_PrintContext', %d and %d prints\n" TOY_CC_RESET, printsA, printsB);
+
+			//cleanup and return
+			Toy_resetPrintCallback();
+			Toy_resetAssertFailureCallback();
+			free(callbackUtilReceived);
+			callbackUtilReceived = NULL;
+			Toy_freeVM(&vmA);
+			Toy_freeBytecode(bcA);
+			Toy_freeVM(&vmB);
+			Toy_freeBytecode(bcB);
+			return -1;
+		}
+
+		//the global callbacks are back in place after a run
+		Toy_print("outside");
+
+		if (callbackUtilReceived == NULL || strcmp(callbackUtilReceived, "outside") != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to restore the global print callback after running a 'Toy_VM'\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_resetPrintCallback();
+			Toy_resetAssertFailureCallback();
+			free(callbackUtilReceived);
+			callbackUtilReceived = NULL;
+			Toy_freeVM(&vmA);
+			Toy_freeBytecode(bcA);
+			Toy_freeVM(&vmB);
+			Toy_freeBytecode(bcB);
+			return -1;
+		}
+
+		//teardown
+		Toy_resetPrintCallback();
+		Toy_resetAssertFailureCallback();
+		free(callbackUtilReceived);
+		callbackUtilReceived = NULL;
+		Toy_freeVM(&vmA);
+		Toy_freeBytecode(bcA);
+		Toy_freeVM(&vmB);
+		Toy_freeBytecode(bcB);
+	}
+
+	return 0;
+}
+
+int test_borrowed_bytecode(Toy_Bucket** bucketHandle) {
+	//the bytecode belongs to the caller, so it can outlive a VM and be bound again
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = 6; var b = a * 7;");
+
+		Toy_VM first;
+		Toy_initVM(&first);
+		Toy_bindVM(&first, bc.ptr, bc.count);
+		Toy_VMStatus firstStatus = Toy_runVM(&first);
+		Toy_freeVM(&first);
+
+		Toy_VM second;
+		Toy_initVM(&second);
+		Toy_bindVM(&second, bc.ptr, bc.count);
+		Toy_VMStatus secondStatus = Toy_runVM(&second);
+
+		Toy_String* key = Toy_createNameStringLength(bucketHandle, "b", 1, TOY_VALUE_ANY, false);
+
+		if (firstStatus != TOY_VM_STATUS_OK ||
+			secondStatus != TOY_VM_STATUS_OK ||
+			second.bc != bc.ptr ||
+			TOY_VALUE_AS_INTEGER(Toy_accessScope(second.scope, key)) != 42
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to bind the same bytecode to a second 'Toy_VM'\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_freeVM(&second);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&second);
+		Toy_freeBytecode(bc);
+	}
+
+	//bytecode from another major version is refused, without exiting
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = 6;");
+		bc.ptr[0] = TOY_VERSION_MAJOR + 1;
+
+		fprintf(stderr, TOY_CC_NOTICE "(the next error is expected)\n" TOY_CC_RESET);
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		bool bound = Toy_bindVM(&vm, bc.ptr, bc.count);
+
+		if (bound != false || vm.panic != true || Toy_runVM(&vm) != TOY_VM_STATUS_PANIC) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to refuse bytecode from another major version\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	return 0;
+}
+
+int test_constant_strings(Toy_Bucket** bucketHandle) {
+	//each string in the routine is built once, then shared by every read of it
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var a = \"hello\"; var b = \"hello\"; var c = a .. \"hello\";");
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+		Toy_VMStatus status = Toy_runVM(&vm);
+
+		Toy_String* keyA = Toy_createNameStringLength(bucketHandle, "a", 1, TOY_VALUE_ANY, false);
+		Toy_String* keyB = Toy_createNameStringLength(bucketHandle, "b", 1, TOY_VALUE_ANY, false);
+
+		if (status != TOY_VM_STATUS_OK ||
+			vm.constantCount != 8 || //hello, a, b and c, each as a leaf or a name
+			TOY_VALUE_AS_STRING(Toy_accessScope(vm.scope, keyA)) != TOY_VALUE_AS_STRING(Toy_accessScope(vm.scope, keyB))
+		)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to share the constant strings in a 'Toy_VM'\n" TOY_CC_RESET);
+
+			//cleanup and return
+			Toy_freeVM(&vm);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		Toy_freeVM(&vm);
+		Toy_freeBytecode(bc);
+	}
+
+	return 0;
+}
+
+//appends each line to the buffer in 'userData'
+static void callbackAppend(const char* msg, void* userData) {
+	char* buffer = userData;
+	size_t length = strlen(buffer);
+	snprintf(buffer + length, 1024 - length, "%s\n", msg);
+}
+
+int test_dense_encoding(Toy_Bucket** bucketHandle) {
+	//both encodings of the same source print the same things, and the dense one is smaller
+	{
+		const char* sources[] = {
+			"print 42; print -1; print 100000; print -100000; print 2147483647; print 3.5; print true; print null;",
+			"var a: int = 1; a += 200; a -= 1; a *= 3; a /= 2; a %= 7; print a;",
+			"var s = \"hello world\"; print s[0, 5]; print s[6]; print s .. \"!\";",
+			"var x = 1; { var y = x + 1; { var z = y * 2; print x == z; print x != z; print z; } } assert x < 2, \"failed\";",
+			"print 1.5 >= 2 && 3 <= 4 || !false;",
+		};
+
+		for (unsigned int i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+			char outputs[2][1024] = { "", "" };
+			unsigned int sizes[2];
+			bool flags[2];
+			bool verified[2];
+			Toy_VMStatus statuses[2];
+
+			for (int dense = 0; dense < 2; dense++) {
+				Toy_Lexer lexer;
+				Toy_bindLexer(&lexer, sources[i]);
+				Toy_Parser parser;
+				Toy_bindParser(&parser, &lexer);
+				Toy_Ast* ast = Toy_scanParser(bucketHandle, &parser);
+				Toy_Bytecode bc = dense ? Toy_compileDenseBytecode(ast) : Toy_compileBytecode(ast);
+
+				Toy_VM vm;
+				Toy_initVM(&vm);
+				Toy_setVMPrintContext(&vm, (Toy_PrintContext){ .printCallback = callbackAppend, .assertCallback = callbackAppend, .userData = outputs[dense] });
+				verified[dense] = Toy_bindVM(&vm, bc.ptr, bc.count);
+
+				sizes[dense] = bc.count;
+				flags[dense] = vm.dense;
+				statuses[dense] = Toy_runVM(&vm);
+
+				Toy_freeVM(&vm);
+				Toy_freeBytecode(bc);
+			}
+
+			if (flags[0] != false ||
+				flags[1] != true ||
+				verified[0] != true ||
+				verified[1] != true ||
+				statuses[0] != TOY_VM_STATUS_OK ||
+				statuses[1] != TOY_VM_STATUS_OK ||
+				strcmp(outputs[0], outputs[1]) != 0 ||
+				sizes[1] >= sizes[0]
+			)
+			{
+				fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected results from the dense encoding, source: %s\n" TOY_CC_RESET, sources[i]);
+				fprintf(stderr, TOY_CC_ERROR "aligned (%u bytes):\n%sdense (%u bytes):\n%s" TOY_CC_RESET, sizes[0], outputs[0], sizes[1], outputs[1]);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int test_bundles(Toy_Bucket** bucketHandle) {
+	//each module of a bundle runs on its own, and binding one never reads the others
+	{
+		//setup
+		const char* sources[] = {
+			"print \"first\";",
+			"var a = 1; print a + 1;",
+			"print \"last\";",
+		};
+		const char* names[] = { "first", "second", "last" };
+		Toy_Ast* modules[3];
+
+		for (int i = 0; i < 3; i++) {
+			Toy_Lexer lexer;
+			Toy_bindLexer(&lexer, sources[i]);
+			Toy_Parser parser;
+			Toy_bindParser(&parser, &lexer);
+			modules[i] = Toy_scanParser(bucketHandle, &parser);
+		}
+
+		Toy_Bytecode bc = Toy_compileBundle(modules, names, 3, false);
+
+		//the default is the first module
+		char outputs[3][1024] = { "", "", "" };
+
+		Toy_VM vm;
+		Toy_initVM(&vm);
+		Toy_setVMPrintContext(&vm, (Toy_PrintContext){ .printCallback = callbackAppend, .userData = outputs[0] });
+		Toy_bindVM(&vm, bc.ptr, bc.count);
+		Toy_VMStatus firstStatus = Toy_runVM(&vm);
+		Toy_freeVM(&vm);
+
+		//wreck the unused modules, which the next bind shouldn't notice
+		memset((unsigned char*)Toy_findBundleModule(bc.ptr, bc.count, "first"), 0xFF, 24); //the header
+		memset((unsigned char*)Toy_findBundleModule(bc.ptr, bc.count, "last"), 0xFF, 24);
+
+		Toy_initVM(&vm);
+		Toy_setVMPrintContext(&vm, (Toy_PrintContext){ .printCallback = callbackAppend, .userData = outputs[1] });
+		bool secondBound = Toy_bindVMToModule(&vm, bc.ptr, bc.count, "second");
+		Toy_VMStatus secondStatus = Toy_runVM(&vm);
+		Toy_freeVM(&vm);
+
+		fprintf(stderr, TOY_CC_NOTICE "(the next two errors are expected)\n" TOY_CC_RESET);
+
+		Toy_initVM(&vm);
+		bool missingBound = Toy_bindVMToModule(&vm, bc.ptr, bc.count, "missing");
+		Toy_freeVM(&vm);
+
+		//an image that ends before the first module
+		unsigned int firstAddr = Toy_findBundleModule(bc.ptr, bc.count, "first") - bc.ptr;
+
+		Toy_initVM(&vm);
+		bool truncatedBound = Toy_bindVM(&vm, bc.ptr, firstAddr);
+		Toy_freeVM(&vm);
+
+		//check the state
+		if (firstStatus != TOY_VM_STATUS_OK ||
+			strcmp(outputs[0], "first\n") != 0 ||
+			secondBound != true ||
+			secondStatus != TOY_VM_STATUS_OK ||
+			strcmp(outputs[1], "2\n") != 0 ||
+			missingBound != false ||
+			truncatedBound != false)
+		{
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected results from a bundle, found '%s' and '%s'\n" TOY_CC_RESET, outputs[0], outputs[1]);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//free
+		Toy_freeBytecode(bc);
+	}
+
+	return 0;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static void* sharedBytecodeWorker(void* arg) {
+	const Toy_Bytecode* image = arg;
+
+	Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+	Toy_String* key = Toy_createNameStringLength(&bucket, "total", 5, TOY_VALUE_ANY, false);
+
+	Toy_VM vm;
+	Toy_initVM(&vm);
+	Toy_bindVM(&vm, image->ptr, image->count);
+	Toy_VMStatus status = Toy_runVM(&vm);
+
+	//report the result through the return value
+	intptr_t result = status == TOY_VM_STATUS_OK ? TOY_VALUE_AS_INTEGER(Toy_accessScope(vm.scope, key)) : -1;
+
+	Toy_freeVM(&vm);
+	Toy_freeBucket(&bucket);
+
+	return (void*)result;
+}
+#endif
+
+int test_shared_bytecode(Toy_Bucket** bucketHandle) {
+#if !defined(_WIN32) && !defined(_WIN64)
+	//several VMs on separate threads, running from one read-only image - any write would fault
+	{
+		Toy_Bytecode bc = makeBytecodeFromSource(bucketHandle, "var total = 0; { var a = 20; total = a + 1; } total = total * 2; total = total;");
+
+		FILE* file = tmpfile();
+		fwrite(bc.ptr, 1, bc.count, file);
+		fflush(file);
+
+		unsigned char* image = mmap(NULL, bc.count, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+
+		if (image == MAP_FAILED) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Failed to map a read-only bytecode image\n" TOY_CC_RESET);
+			fclose(file);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//the workers only read the mapping and its length
+		Toy_Bytecode view = { .ptr = image, .capacity = bc.count, .count = bc.count };
+
+		pthread_t threads[4];
+		for (int i = 0; i < 4; i++) {
+			pthread_create(&threads[i], NULL, sharedBytecodeWorker, &view);
+		}
+
+		int failures = 0;
+		for (int i = 0; i < 4; i++) {
+			void* result;
+			pthread_join(threads[i], &result);
+			failures += (intptr_t)result != 42;
+		}
+
+		if (failures != 0) {
+			fprintf(stderr, TOY_CC_ERROR "ERROR: Unexpected result from %d VMs sharing one bytecode image\n" TOY_CC_RESET, failures);
+
+			//cleanup and return
+			munmap(image, bc.count);
+			fclose(file);
+			Toy_freeBytecode(bc);
+			return -1;
+		}
+
+		//teardown
+		munmap(image, bc.count);
+		fclose(file);
+		Toy_freeBytecode(bc);
+	}
+#endif
+
+	return 0;
+}
+
+int main() {
+	//run each test set, returning the total errors given
+	int total = 0, res = 0;
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_setup_and_teardown(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_simple_execution(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_opcode_not_equal(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_keyword_print(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_keyword_assert(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_scope(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_vm_reuse(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_access_allocations(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_inline_caches(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_panic(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_budget(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_keyword_yield(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_print_context(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_borrowed_bytecode(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_shared_bytecode(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_dense_encoding(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_constant_strings(&bucket);
+		Toy_freeBucket(&bucket);
+		if (res == 0) {
+			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
+		}
+		total += res;
+	}
+	{
+		Toy_Bucket* bucket = Toy_allocateBucket(TOY_BUCKET_IDEAL);
+		res = test_bundles(&bucket);
 		Toy_freeBucket(&bucket);
 		if (res == 0) {
 			printf(TOY_CC_NOTICE "All good\n" TOY_CC_RESET);
@@ -0,0 +1,40 @@
+//runs one routine written by 'repl.exe -t', so its output can be compared with the VM's
+#include "toy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//the routine's name is given on the command line, see the makefile
+extern const Toy_NativeRoutine TOY_NATIVE_ROUTINE;
+
+//callbacks, same as the repl
+static void printCallback(const char* msg) {
+	fprintf(stdout, "%s\n", msg);
+}
+
+static void errorAndExitCallback(const char* msg) {
+	fprintf(stderr, "%s\n", msg);
+	exit(-1);
+}
+
+int main() {
+	Toy_setPrintCallback(printCallback);
+	Toy_setErrorCallback(errorAndExitCallback);
+	Toy_setAssertFailureCallback(errorAndExitCallback);
+
+	Toy_VM vm;
+	Toy_initVM(&vm);
+	Toy_bindVMToNative(&vm, &TOY_NATIVE_ROUTINE);
+
+	//print each yielded value before resuming, like the repl
+	Toy_VMStatus status = Toy_runVM(&vm);
+
+	while (status == TOY_VM_STATUS_YIELDED_VALUE) {
+		Toy_stringifyValue(vm.yieldValue, Toy_print);
+		status = Toy_runVM(&vm);
+	}
+
+	Toy_freeVM(&vm);
+
+	return status == TOY_VM_STATUS_OK ? 0 : -1;
+}
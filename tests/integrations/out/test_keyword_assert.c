@@ -0,0 +1,35 @@
+//transpiled by Toy_transpileBytecode() from version 2.0.0 bytecode, bind with Toy_bindVMToNative()
+#include "toy_vm.h"
+
+#include <math.h>
+
+static const char* test_keyword_assert_strings[] = {
+	"Hello world",
+	"Assertion message",
+};
+
+static void test_keyword_assert_run(Toy_VM* vm) {
+	switch(vm->routineCounter) {
+	case 0:
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeAssert(vm, 1);
+	Toy_private_nativeReadString(vm, 0, false, 0);
+	Toy_private_nativeAssert(vm, 1);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_LESS, false);
+	Toy_private_nativeAssert(vm, 1);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeReadString(vm, 1, false, 0);
+	Toy_private_nativeAssert(vm, 2);
+	return;
+	}
+}
+
+const Toy_NativeRoutine test_keyword_assert = {
+	.run = test_keyword_assert_run,
+	.strings = test_keyword_assert_strings,
+	.stringCount = 2,
+	.siteCount = 12,
+};
+
@@ -0,0 +1,55 @@
+//transpiled by Toy_transpileBytecode() from version 2.0.0 bytecode, bind with Toy_bindVMToNative()
+#include "toy_vm.h"
+
+#include <math.h>
+
+static const char* test_keyword_print_strings[] = {
+	"Hello world!",
+	"Hello",
+	"world!",
+	"\tHello\nworld",
+	"Hello world",
+	"hello",
+	"world",
+};
+
+static void test_keyword_print_run(Toy_VM* vm) {
+	switch(vm->routineCounter) {
+	case 0:
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(42));
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(3));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(5));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_MULTIPLY);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 0, false, 0);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 1, false, 0);
+	Toy_private_nativeReadString(vm, 2, false, 0);
+	Toy_private_nativeConcat(vm);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 3, false, 0);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 4, false, 0);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(0));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(5));
+	Toy_private_nativeIndex(vm, 3);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 5, false, 0);
+	Toy_private_nativeReadString(vm, 6, false, 0);
+	Toy_private_nativeConcat(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(6));
+	Toy_private_nativeIndex(vm, 3);
+	Toy_private_nativePrint(vm);
+	return;
+	}
+}
+
+const Toy_NativeRoutine test_keyword_print = {
+	.run = test_keyword_print_run,
+	.strings = test_keyword_print_strings,
+	.stringCount = 7,
+	.siteCount = 27,
+};
+
@@ -0,0 +1,50 @@
+//transpiled by Toy_transpileBytecode() from version 2.0.0 bytecode, bind with Toy_bindVMToNative()
+#include "toy_vm.h"
+
+#include <math.h>
+
+static const char* test_scopes_strings[] = {
+	"answer",
+	"question",
+};
+
+static void test_scopes_run(Toy_VM* vm) {
+	switch(vm->routineCounter) {
+	case 0:
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(42));
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 6, false, 0);
+	Toy_private_nativeAccess(vm, 2, 6, 0);
+	Toy_private_nativePrint(vm);
+	vm->scope = Toy_pushScope(&vm->scopeBucket, vm->scope);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(7));
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 6, false, 0);
+	Toy_private_nativeAccess(vm, 7, 6, 0);
+	Toy_private_nativePrint(vm);
+	vm->scope = Toy_popScope(vm->scope);
+	vm->scopeVersion++;
+	Toy_private_nativeAccess(vm, 10, 6, 0);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(42));
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 8, false, 1);
+	Toy_private_nativeAccess(vm, 14, 8, 1);
+	Toy_private_nativePrint(vm);
+	vm->scope = Toy_pushScope(&vm->scopeBucket, vm->scope);
+	Toy_private_nativeAccess(vm, 17, 8, 1);
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 8, false, 1);
+	Toy_private_nativeAccess(vm, 19, 8, 1);
+	Toy_private_nativePrint(vm);
+	vm->scope = Toy_popScope(vm->scope);
+	vm->scopeVersion++;
+	Toy_private_nativeAccess(vm, 22, 8, 1);
+	Toy_private_nativePrint(vm);
+	return;
+	}
+}
+
+const Toy_NativeRoutine test_scopes = {
+	.run = test_scopes_run,
+	.strings = test_scopes_strings,
+	.stringCount = 2,
+	.siteCount = 25,
+};
+
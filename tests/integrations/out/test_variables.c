@@ -0,0 +1,182 @@
+//transpiled by Toy_transpileBytecode() from version 2.0.0 bytecode, bind with Toy_bindVMToNative()
+#include "toy_vm.h"
+
+#include <math.h>
+
+static const char* test_variables_strings[] = {
+	"answer",
+	"empty",
+	"foo",
+	"bar",
+	"a",
+	"b",
+	"c",
+	"Hello",
+	"world!",
+	"s",
+};
+
+static void test_variables_run(Toy_VM* vm) {
+	switch(vm->routineCounter) {
+	case 0:
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(42));
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 6, false, 0);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_NULL());
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 5, false, 1);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(6));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(9));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_MULTIPLY);
+	Toy_private_nativeAssign(vm, 8);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_private_nativeAccess(vm, 10, 6, 0);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_ADD);
+	Toy_private_nativeAssign(vm, 13);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_private_nativeDuplicate(vm, true, 15);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(5));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_ADD);
+	Toy_private_nativeAssign(vm, 17);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_private_nativeDuplicate(vm, true, 19);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(5));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_SUBTRACT);
+	Toy_private_nativeAssign(vm, 21);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_private_nativeDuplicate(vm, true, 23);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(9));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_MULTIPLY);
+	Toy_private_nativeAssign(vm, 25);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_private_nativeDuplicate(vm, true, 27);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_DIVIDE);
+	Toy_private_nativeAssign(vm, 29);
+	Toy_private_nativeReadString(vm, 0, true, 6);
+	Toy_private_nativeDuplicate(vm, true, 31);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(10));
+	Toy_private_nativeArithmetic(vm, TOY_OPCODE_MODULO);
+	Toy_private_nativeAssign(vm, 33);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_EQUAL, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_EQUAL, true);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_LESS, false);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 2, false, 0);
+	Toy_private_nativeReadString(vm, 3, false, 0);
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_GREATER, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_LESS, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_GREATER, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_LESS_EQUAL, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_GREATER_EQUAL, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_LESS_EQUAL, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(1));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(2));
+	Toy_private_nativeComparison(vm, TOY_OPCODE_COMPARE_GREATER_EQUAL, false);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_AND);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_AND);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_AND);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_AND);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_OR);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_OR);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_OR);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_OR);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_NEGATE);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_NEGATE);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(false));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_AND);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_BOOLEAN(true));
+	Toy_private_nativeLogical(vm, TOY_OPCODE_OR);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_NULL());
+	Toy_private_nativeDeclare(vm, TOY_VALUE_INTEGER, 1, false, 4);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(42));
+	Toy_private_nativeDeclare(vm, TOY_VALUE_INTEGER, 1, false, 5);
+	Toy_private_nativeReadString(vm, 4, true, 1);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(69));
+	Toy_private_nativeAssign(vm, 124);
+	Toy_private_nativeReadString(vm, 5, true, 1);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(8891));
+	Toy_private_nativeAssign(vm, 127);
+	Toy_private_nativeAccess(vm, 128, 1, 4);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeAccess(vm, 130, 1, 5);
+	Toy_private_nativePrint(vm);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(42));
+	Toy_private_nativeDeclare(vm, TOY_VALUE_INTEGER, 1, true, 6);
+	Toy_private_nativeAccess(vm, 134, 1, 6);
+	Toy_private_nativePrint(vm);
+	Toy_private_nativeReadString(vm, 7, false, 0);
+	Toy_private_nativeReadString(vm, 8, false, 0);
+	Toy_private_nativeConcat(vm);
+	Toy_private_nativeDeclare(vm, TOY_VALUE_ANY, 1, false, 9);
+	Toy_private_nativeAccess(vm, 140, 1, 9);
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(3));
+	Toy_pushStack(&vm->stack, TOY_VALUE_FROM_INTEGER(3));
+	Toy_private_nativeIndex(vm, 3);
+	Toy_private_nativePrint(vm);
+	return;
+	}
+}
+
+const Toy_NativeRoutine test_variables = {
+	.run = test_variables_run,
+	.strings = test_variables_strings,
+	.stringCount = 10,
+	.siteCount = 146,
+};
+